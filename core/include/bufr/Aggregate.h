@@ -0,0 +1,49 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace bufr {
+
+    /// \brief Says what statistics to compute for a field (see File::aggregate). The count, min,
+    /// max and mean are always computed, the histogram only if bin edges are given.
+    struct AggregateSpec
+    {
+        std::string field;  ///< The name of the query in the QuerySet
+        std::string groupBy;  ///< Optional, the name of the query whose values group the field
+        std::vector<double> binEdges;  ///< Optional, the (ascending) edges of the histogram bins
+    };
+
+    /// \brief The statistics of a field (or of one group of it). Missing values are left out.
+    struct AggregateStats
+    {
+        size_t count = 0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        double sum = 0;
+        std::vector<size_t> histogram;  ///< Values in each bin (out of range ones are left out)
+
+        /// \brief The mean of the values (NaN if there are none).
+        double mean() const
+        {
+            return (count > 0) ? sum / static_cast<double>(count)
+                               : std::numeric_limits<double>::quiet_NaN();
+        }
+    };
+
+    /// \brief The statistics for an AggregateSpec. Fields with one value per subset are grouped
+    /// by a field with one value per subset, and repeated fields are grouped either by a field
+    /// with one value per subset or by one with as many values as they have (ex: TMBR by CHNM).
+    struct AggregateResult
+    {
+        AggregateSpec spec;
+        AggregateStats total;
+        std::map<double, AggregateStats> groups;  ///< By group value (empty without groupBy)
+    };
+}  // namespace bufr
@@ -40,11 +40,18 @@ namespace bufr {
 
         /// \brief Uses the provided description to parse the buffer file.
         /// \param maxMsgsToParse Messages to parse (0 for everything)
-        std::shared_ptr<DataContainer> parse(const size_t maxMsgsToParse = 0);
+        /// \param numWorkers Number of processes to decode the messages with (see File::execute)
+        /// \param numThreads Number of threads to build and export the variables with once the
+        ///        messages are decoded (0 for one per core). The result is the same for any number.
+        std::shared_ptr<DataContainer> parse(const size_t maxMsgsToParse = 0,
+                                             const size_t numWorkers = 1,
+                                             const size_t numThreads = 1);
 
         /// \brief Uses the provided description to parse the BUFR file using MPI.
         /// \param comm The eckit MPI comm object
-        std::shared_ptr<DataContainer> parse(const eckit::mpi::Comm&);
+        /// \param numThreads Number of threads to build and export the variables with (see parse)
+        std::shared_ptr<DataContainer> parse(const eckit::mpi::Comm&,
+                                             const size_t numThreads = 1);
 
         /// \brief Start over from beginning of the BUFR file
         void reset();
@@ -60,7 +67,9 @@ namespace bufr {
 
         /// \brief Exports collected data into a DataContainer
         /// \param srcData Data to export
-        std::shared_ptr<DataContainer> exportData(const BufrDataMap& srcData);
+        /// \param numThreads Number of threads to export the variables with (see parse)
+        std::shared_ptr<DataContainer> exportData(const BufrDataMap& srcData,
+                                                  const size_t numThreads = 1);
 
         /// \brief Function responsible for dividing the data into subcategories.
         /// \details This function is intended to be called over and over for each specified Split
@@ -202,11 +202,18 @@ namespace bufr {
             }
             else
             {
-                return std::fabs(value.octets[idx] - MissingOctetValue)
-                       <= std::numeric_limits<double>::epsilon() * MissingOctetValue * 100;
+                return isMissingOctet(value.octets[idx]);
             }
         }
 
+        /// \brief Is an octet value the missing value (see isMissing). It has no branches, so
+        ///        loops over the octets that use it can be vectorised.
+        static bool isMissingOctet(double value)
+        {
+            return std::fabs(value - MissingOctetValue)
+                   <= std::numeric_limits<double>::epsilon() * MissingOctetValue * 100;
+        }
+
         /// \brief Set the isLongString attribute
         /// \param isLongString True if the data is a long string.
         void isLongStr(bool isLongString)
@@ -13,6 +13,8 @@
 #include <iostream>
 #include <vector>
 
+#include <gsl/gsl-lite.hpp>
+
 #include "eckit/mpi/Comm.h"
 
 #include "QueryParser.h"
@@ -396,17 +398,12 @@ namespace bufr {
         }
         else
         {
-          data_ = std::vector<T>(data.size());
-          for (size_t idx = 0; idx < data.size(); ++idx)
+          const auto& octets = data.value.octets;
+          data_ = std::vector<T>(octets.size());
+          for (size_t idx = 0; idx < octets.size(); ++idx)
           {
-            if (!data.isMissing(idx))
-            {
-              data_[idx] = data.value.octets[idx];
-            }
-            else
-            {
-              data_[idx] = missingValue();
-            }
+            data_[idx] = Data::isMissingOctet(octets[idx]) ? missingValue()
+                                                            : static_cast<T>(octets[idx]);
           }
         }
       }
@@ -417,6 +414,12 @@ namespace bufr {
         data_ = data;
       }
 
+      /// \brief Set the data associated with this data object by taking over the vector.
+      void setData(std::vector<T>&& data)
+      {
+        data_ = std::move(data);
+      }
+
       /// \brief Write the data out using a writer.
       /// \param writer The writer to use.
       void write(std::shared_ptr<ObjectWriterBase> writer) final
@@ -733,10 +736,15 @@ namespace bufr {
         return dimData;
       }
 
-      /// \brief Get the raw data associated with this data object.
+      /// \brief Get a copy of the raw data associated with this data object.
       /// \return The raw data.
       std::vector<T> getRawData() const { return data_; }
 
+      /// \brief Get a view of the raw data associated with this data object (no copy). It stays
+      ///        valid as long as the object is alive and its data isn't set again.
+      /// \return The raw data.
+      gsl::span<const T> getRawDataView() const { return data_; }
+
       /// \brief Get the size of the data object.
       /// \return The size of the data object.
       size_t size() const final
@@ -771,7 +779,7 @@ namespace bufr {
 
         auto slicedDataObject = std::make_shared<DataObject<T>>();
 
-        slicedDataObject->setData(newData);
+        slicedDataObject->setData(std::move(newData));
         slicedDataObject->setFieldName(fieldName_);
         slicedDataObject->setGroupByFieldName(groupByFieldName_);
         slicedDataObject->setDims(sliceDims);
@@ -938,6 +946,13 @@ namespace bufr {
         data_ = data;
       }
 
+      /// \brief Set the data associated with this data object by taking over the vector.
+      /// \param data The raw data
+      void setData(std::vector<std::string>&& data)
+      {
+        data_ = std::move(data);
+      }
+
       /// \brief Write the data out using a writer.
       /// \param writer The writer to use.
       void write(std::shared_ptr<ObjectWriterBase> writer) final
@@ -1308,7 +1323,7 @@ namespace bufr {
 
         auto slicedDataObject = std::make_shared<DataObject<std::string>>();
 
-        slicedDataObject->setData(newData);
+        slicedDataObject->setData(std::move(newData));
         slicedDataObject->setFieldName(fieldName_);
         slicedDataObject->setGroupByFieldName(groupByFieldName_);
         slicedDataObject->setDims(sliceDims);
@@ -1318,10 +1333,15 @@ namespace bufr {
         return slicedDataObject;
       }
 
-      /// \brief Get the raw data associated with this data object.
+      /// \brief Get a copy of the raw data associated with this data object.
       /// \return The raw data.
       std::vector<std::string> getRawData() const { return data_; }
 
+      /// \brief Get a view of the raw data associated with this data object (no copy). It stays
+      ///        valid as long as the object is alive and its data isn't set again.
+      /// \return The raw data.
+      gsl::span<const std::string> getRawDataView() const { return data_; }
+
       /// \brief Get the size of the data object.
       /// \return The size of the data object.
       size_t size() const final
@@ -12,6 +12,8 @@
 #include <unordered_map>
 
 #include "bufr_interface.h"
+#include "FortranUnits.h"
+#include "MessageIndex.h"
 #include "QuerySet.h"
 #include "SubsetVariant.h"
 
@@ -115,6 +117,8 @@ namespace bufr {
     class DataProvider
     {
      public:
+        typedef std::function<bool(const MessageHeader&, const uint8_t*)> SubsetReader;
+
         DataProvider() = delete;
 
         explicit DataProvider(const std::string filePath) :
@@ -125,17 +129,30 @@ namespace bufr {
         virtual ~DataProvider() = default;
 
         /// \brief Runs through the contents of the BUFR file. Calls the functions given as
-        ///        its running.
+        ///        its running. If the message index is available (see getIndex) it is used to
+        ///        jump straight to the first message that is needed. Messages excluded by the
+        ///        section 1 filters of the QuerySet (time window and message types) are skipped
+        ///        without being read. Without an index, a run that reads the whole file (with a
+        ///        subset reader set) leaves the index behind.
         /// \param processSubset The function to call to process a subset.
         /// \param processMsg (Optional) Function to call when finish processing a message.
         /// \param continueProcessing (Optional) Function to call to figure out if we should keep
         ///                           running or not.
+        /// \param offset (Optional) Number of matching messages to skip before processing.
         void run(const QuerySet& querySet,
                  const std::function<void()> processSubset,
                  const std::function<void()> processMsg = [](){},
                  const std::function<bool()> continueProcessing = [](){ return true; },
                  size_t offset = 0);
 
+        /// \brief Sets a function that can decode the subsets of a message that come after the
+        ///        first one without NCEPLIB-bufr. It is called (in run) once NCEPLIB-bufr has read
+        ///        the first subset of a message and returns true if it took care of the rest of
+        ///        the subsets.
+        /// \param subsetReader The function (given the message headers and a pointer to the
+        ///                     start of the message).
+        void setSubsetReader(const SubsetReader& subsetReader) { subsetReader_ = subsetReader; }
+
         /// \brief Open the BUFR file with NCEPLIB-bufr
         virtual void open() = 0;
 
@@ -149,14 +166,28 @@ namespace bufr {
             open();
         }
 
+        /// \brief Get the number of messages in the file that match the QuerySet.
         size_t numMessages(const QuerySet& querySet);
 
+        /// \brief Get the message index for the file. The index is loaded from the on-disk cache
+        ///        (see MessageIndexCache) or built the first time it is requested, and then kept
+        ///        for the life of the object (it survives close and rewind).
+        std::shared_ptr<MessageIndex> getIndex();
+
+        /// \brief Use an index that was already made for the same file (by another DataProvider)
+        ///        instead of loading or building it again.
+        void setIndex(const std::shared_ptr<MessageIndex>& index) { index_ = index; }
+
         /// \brief Is the BUFR file open
         bool isFileOpen() { return isOpen_; }
 
         /// \brief Tells the Fortran BUFR interface to delete its temporary data structures that are
         /// are needed to support this class instanc.
-        inline void deleteData() { delete_table_data_f(); }
+        inline void deleteData()
+        {
+            auto lock = FortranUnits::lock();
+            delete_table_data_f();
+        }
 
         /// \brief Get the current active subset variant.
         SubsetVariant getSubsetVariant() const
@@ -239,8 +270,15 @@ namespace bufr {
         /// \brief Initialize the table cache in order to capture all the subset information.
         virtual void initAllTableData() {}
 
+        /// \brief Get the name of the kind of BUFR file this provider reads (ex: "NCEP").
+        virtual std::string typeName() const = 0;
+
+        /// \brief Get the path of the master tables the file is read with (empty if the tables
+        ///        come from the file itself).
+        virtual std::string tablePath() const { return ""; }
+
      protected:
-        static const int FileUnit = 12;
+        int fileUnit_ = 0;  // Fortran unit for the file (see FortranUnits), valid while open
 
         const std::string filePath_;
         std::string subset_;
@@ -255,16 +293,42 @@ namespace bufr {
         gsl::span<const double> val_;
         gsl::span<const int> inv_;
 
+        // Message index (lazily built) and the buffer used to hand messages to NCEPLIB-bufr
+        std::shared_ptr<MessageIndex> index_;
+        std::vector<int> msgBuffer_;
+        SubsetReader subsetReader_;
+
         /// \brief Update the table data for the currently loaded subset.
         /// \param subset The subset string.
         virtual void updateTableData(const std::string& subset) = 0;
 
+        /// \brief Make any NCEPLIB-bufr settings that are global (shared with the other open
+        ///        files) match this provider before reading messages. Called with the
+        ///        FortranUnits lock held.
+        virtual void activateTables() {}
+
         /// \brief Read the data from the BUFR interface for the current subset and reset the
         /// internal data structures.
         ////// \param bufrLoc The Fortran idx for the subset we need to read.
         void updateData(int bufrLoc);
 
+        /// \brief Load a message from the index into NCEPLIB-bufr so its subsets can be read.
+        /// \param index The message index.
+        /// \param msgIdx Position of the message in the file.
+        /// \return The subset name for the message (empty if NCEPLIB-bufr could not read it).
+        std::string loadMessage(const MessageIndex& index, size_t msgIdx);
+
+        /// \brief Load a message that is already in memory into NCEPLIB-bufr (see loadMessage).
+        /// \param msg Pointer to the start of the message.
+        /// \param length Length of the message in bytes.
+        /// \return The subset name for the message (empty if NCEPLIB-bufr could not read it).
+        std::string loadMessage(const uint8_t* msg, size_t length);
+
      private:
+        /// \brief Hand the message in msgBuffer_ to NCEPLIB-bufr.
+        /// \return The subset name for the message (empty if NCEPLIB-bufr could not read it).
+        std::string loadMessageBuffer();
+
         /// \brief Get the currently valid subset table data
         virtual std::shared_ptr<TableData> getTableData() const = 0;
     };
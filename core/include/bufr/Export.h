@@ -8,6 +8,7 @@
 #include "eckit/config/LocalConfiguration.h"
 
 #include "Filter.h"
+#include "QuerySet.h"
 #include "Split.h"
 #include "Variable.h"
 
@@ -33,12 +34,14 @@ namespace bufr {
         inline Variables getVariables() const { return variables_; }
         inline Filters getFilters() const { return filters_; }
         inline std::vector<std::string> getSubsets() const { return subsets_; }
+        inline SubsetSampling getSampling() const { return sampling_; }
 
      private:
         Splits splits_;
         Variables  variables_;
         Filters filters_;
         std::vector<std::string> subsets_;
+        SubsetSampling sampling_;
 
 
         /// \brief Create Variables exports from config.
@@ -50,5 +53,8 @@ namespace bufr {
 
         /// \brief Create Filters exports from config.
         void addFilters(const eckit::Configuration &conf);
+
+        /// \brief Read the subset sampling options from config (see SubsetSampling).
+        void addSampling(const eckit::Configuration &conf);
     };
 }  // namespace bufr
@@ -3,10 +3,14 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include "Aggregate.h"
 #include "ResultSet.h"
+#include "ResultSetIterator.h"
 #include "QuerySet.h"
 #include "DataProvider.h"
+#include "MessageIndex.h"
 
 namespace bufr {
 
@@ -24,13 +28,53 @@ namespace bufr {
         /// \param query_set The queryset object that contains the collection of desired queries
         /// \param offset The index of the message in the file to start reading from
         /// \param numMessages The number of messages to read from the file
+        /// \param numWorkers The number of processes to decode the messages with. With more than
+        ///        one, the messages are split between forked worker processes (see WorkerPool)
+        ///        and their results are merged in message order. Query sets that sample the
+        ///        subsets (see QuerySet::setSampleStride) are always run in one process.
         ResultSet execute(const QuerySet& query_set,
                           size_t offset = 0,
-                          size_t numMessages = 0);
+                          size_t numMessages = 0,
+                          size_t numWorkers = 1);
 
-        /// \brief Number of messages in the currently open file..
+        /// \brief Execute the queries a chunk of messages at a time, so that large files can be
+        ///        processed without holding all of their data in memory.
+        /// \param querySet The queryset object that contains the collection of desired queries
+        /// \param chunkMessages The maximum number of messages per chunk (0 for no limit)
+        /// \param chunkBytes End a chunk once its data takes up this many bytes (0 for no limit)
+        /// \param offset The index of the message in the file to start reading from
+        /// \param numMessages The number of messages to read from the file (0 for all)
+        /// \return An iterator that returns the ResultSet for each chunk.
+        ResultSetIterator executeChunks(const QuerySet& querySet,
+                                        size_t chunkMessages,
+                                        size_t chunkBytes = 0,
+                                        size_t offset = 0,
+                                        size_t numMessages = 0);
+
+        /// \brief Compute statistics of the query results (count, min, max, mean and optionally
+        ///        a histogram) without keeping the data. The subsets are folded into the
+        ///        statistics as they are collected, so the memory used only depends on the
+        ///        number of groups.
+        /// \param querySet The queryset object that contains the collection of desired queries
+        /// \param specs The fields to compute statistics for (and what to group them by)
+        /// \param offset The index of the message in the file to start reading from
+        /// \param numMessages The number of messages to read from the file (0 for all)
+        /// \return The statistics for each AggregateSpec.
+        std::vector<AggregateResult> aggregate(const QuerySet& querySet,
+                                               const std::vector<AggregateSpec>& specs,
+                                               size_t offset = 0,
+                                               size_t numMessages = 0);
+
+        /// \brief Number of messages in the currently open file (answered from the message
+        ///        index).
         size_t size(const QuerySet& querySet = QuerySet());
 
+        /// \brief Get the message index for the file. It is built the first time it is needed
+        ///        (or left behind by an execute that read the whole file) and reused by all
+        ///        later calls (execute uses it to seek to the offset and to apply the section 1
+        ///        filters).
+        std::shared_ptr<MessageIndex> index();
+
         /// \brief Close the currently opened BUFR file.
         void close();
 
@@ -39,5 +83,6 @@ namespace bufr {
 
      private:
         std::shared_ptr<DataProvider> dataProvider_;
+        std::string wmoTablePath_;
     };
 }  // namespace bufr
@@ -0,0 +1,73 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <set>
+
+
+namespace bufr {
+
+    /// \brief A singleton that hands out Fortran unit numbers, so that any number of BUFR files
+    /// can be open at the same time (each DataProvider gets its own units when it is opened and
+    /// gives them back when it is closed). NCEPLIB-bufr keeps all of its state in global module
+    /// variables, so it also owns the lock that every call into NCEPLIB-bufr has to be made
+    /// under. The lock is recursive, so code that holds it can call code that takes it again.
+    class FortranUnits
+    {
+     public:
+        typedef std::unique_lock<std::recursive_mutex> Lock;
+
+        FortranUnits(FortranUnits const&) = delete;
+        void operator=(FortranUnits const&) = delete;
+
+        /// \brief Reserve a Fortran unit number that no other DataProvider is using.
+        /// \return The unit number.
+        static int acquire();
+
+        /// \brief Give back a unit number so that it can be used again.
+        /// \param unit The unit number (ignored if it was not reserved).
+        static void release(int unit);
+
+        /// \brief Number of units that are currently reserved.
+        static size_t numAcquired();
+
+        /// \brief Take the lock that serialises the calls into NCEPLIB-bufr.
+        static Lock lock() { return Lock(instance().mutex_); }
+
+        /// \brief Start over with a free lock in a process created with fork. Only the thread
+        ///        that called fork exists in the child, so a lock held by the parent could
+        ///        otherwise never be released. Call it in the child right after fork (and only
+        ///        fork while holding the lock, so NCEPLIB-bufr isn't in the middle of a call).
+        static void afterFork();
+
+        /// \brief A counter that changes whenever NCEPLIB-bufr may have rebuilt its internal
+        ///        tables (they are shared by all open files, so node indices can shift when
+        ///        another file is opened or closed). Cached copies of the tables need to be
+        ///        refreshed when it changes.
+        static size_t tableGeneration();
+
+        /// \brief Let everyone know that the NCEPLIB-bufr tables may have changed.
+        static void tablesChanged();
+
+     private:
+        // Stay clear of the units that are commonly used for the standard streams and by
+        // existing Fortran code.
+        static const int FirstUnit = 20;
+        static const int LastUnit = 99;
+
+        std::recursive_mutex mutex_;
+        std::set<int> units_;
+        size_t tableGeneration_ = 0;
+
+        /// \brief Get the singleton instance of FortranUnits.
+        static FortranUnits& instance()
+        {
+            static FortranUnits instance;
+            return instance;
+        }
+
+        FortranUnits() = default;
+    };
+}  // namespace bufr
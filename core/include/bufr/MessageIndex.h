@@ -0,0 +1,118 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MessageReader.h"
+#include "QuerySet.h"
+
+
+namespace bufr {
+
+    /// \brief Summary of a single BUFR message. Everything except the subset name is read
+    ///        directly from the section 0, 1 and 3 headers of the message.
+    struct MessageInfo
+    {
+        /// \brief Byte offset of the "BUFR" marker that starts the message.
+        size_t offset = 0;
+
+        /// \brief Total length of the message in bytes (section 0 to "7777").
+        size_t length = 0;
+
+        int edition = 0;
+        int dataCategory = 0;
+        int dataSubCategory = 0;
+
+        /// \brief Section 1 date in the form YYYYMMDDHH.
+        int date = 0;
+
+        /// \brief Number of data subsets in the message (from section 3).
+        size_t numSubsets = 0;
+
+        /// \brief Does the message use WMO compression (from section 3)?
+        bool isCompressed = false;
+
+        /// \brief First data descriptor in section 3 (F X Y packed into 16 bits).
+        int tableDescriptor = 0;
+
+        /// \brief Subset name as NCEPLIB-bufr reports it (empty if it could not be determined).
+        std::string subset;
+
+        /// \brief Is this a BUFR table (dictionary) message rather than a data message?
+        bool isDictionary() const { return dataCategory == 11; }
+    };
+
+    /// \brief Index of the messages in a BUFR file. It is built with one scan over the file (see
+    ///        MessageReader) that only reads the message headers, so the data sections are never
+    ///        touched. It makes it possible to count messages and to jump straight to any
+    ///        message in the file.
+    class MessageIndex
+    {
+     public:
+        MessageIndex() = delete;
+
+        /// \brief Scan the file and index every BUFR message in it.
+        /// \param filePath Path to the BUFR file.
+        explicit MessageIndex(const std::string& filePath);
+
+        /// \brief Make an index from previously gathered message info (see MessageIndexCache).
+        /// \param filePath Path to the BUFR file.
+        /// \param messages The info for every message in the file.
+        MessageIndex(const std::string& filePath, std::vector<MessageInfo>&& messages);
+
+        /// \brief Number of messages (including table messages) in the file.
+        size_t size() const { return messages_.size(); }
+
+        /// \brief Are there any messages in the index?
+        bool empty() const { return messages_.empty(); }
+
+        /// \brief Get the info for the message at the given position in the file.
+        /// \param msgIdx Position of the message in the file (0 based).
+        const MessageInfo& operator[](size_t msgIdx) const { return messages_[msgIdx]; }
+
+        /// \brief Get the info for every message in the file.
+        const std::vector<MessageInfo>& messages() const { return messages_; }
+
+        /// \brief Get the path of the indexed file.
+        std::string getFilepath() const { return filePath_; }
+
+        /// \brief Set the subset name for a message.
+        /// \param msgIdx Position of the message in the file (0 based).
+        /// \param subset The subset name.
+        void setSubset(size_t msgIdx, const std::string& subset)
+        {
+            messages_[msgIdx].subset = subset;
+        }
+
+        /// \brief Get the positions of the data messages whose subsets are part of the QuerySet
+        ///        (and that pass its time window and message type filters).
+        /// \param querySet The QuerySet used to select the subsets.
+        /// \return Positions of the matching messages in file order.
+        std::vector<size_t> messagesFor(const QuerySet& querySet) const;
+
+        /// \brief Read the raw bytes of a message into a word aligned buffer (NCEPLIB-bufr wants
+        ///        messages as arrays of integers).
+        /// \param msgIdx Position of the message in the file (0 based).
+        /// \param buffer The buffer to fill. It is resized to fit the message.
+        void read(size_t msgIdx, std::vector<int>& buffer) const;
+
+        /// \brief Get the full headers (including the section 3 descriptor list) of a message.
+        /// \param msgIdx Position of the message in the file (0 based).
+        MessageHeader header(size_t msgIdx) const;
+
+        /// \brief Get the reader for the mapped file.
+        std::shared_ptr<MessageReader> getReader() const { return reader_; }
+
+        /// \brief Make the index entry for a message (the subset is left empty).
+        /// \param header The headers of the message.
+        static MessageInfo infoFor(const MessageHeader& header);
+
+     private:
+        const std::string filePath_;
+        std::vector<MessageInfo> messages_;
+        std::shared_ptr<MessageReader> reader_;
+    };
+}  // namespace bufr
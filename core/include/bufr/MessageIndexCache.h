@@ -0,0 +1,97 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "MessageIndex.h"
+
+
+namespace bufr {
+
+    /// \brief A singleton that persists MessageIndex objects on disk so that files which have
+    /// been indexed once never need to be scanned again. Each index is stored in a small text
+    /// file that is either placed next to the BUFR file (sidecar) or in a cache directory. The
+    /// stored index records the path, size, inode and modification time (to the nanosecond) of
+    /// the BUFR file, the master tables it was labeled with (plus an optional content hash) and
+    /// it is only used if these still match.
+    ///
+    /// \par Indexes that exist are used, but new ones are only written when asked for (so plain
+    /// reads never leave files behind). The defaults can be set with the environment variables
+    /// BUFR_INDEX_CACHE (set to 1 to write sidecar files, or to 0 to turn the cache off),
+    /// BUFR_INDEX_CACHE_DIR (the cache directory, indexes are written there when it is set) and
+    /// BUFR_INDEX_CACHE_HASH (set to 1 to also check the content hash).
+    class MessageIndexCache
+    {
+     public:
+        MessageIndexCache(MessageIndexCache const&) = delete;
+        void operator=(MessageIndexCache const&) = delete;
+
+        /// \brief Turn the cache on or off.
+        static void setEnabled(bool enabled) { instance().enabled_ = enabled; }
+
+        /// \brief Is the cache turned on?
+        static bool isEnabled() { return instance().enabled_; }
+
+        /// \brief Should the indexes that are built be written to the cache (ex: bufr_index.x)?
+        static void setWritable(bool writable) { instance().writable_ = writable; }
+
+        /// \brief Are the indexes that are built written to the cache?
+        static bool isWritable() { return instance().enabled_ && instance().writable_; }
+
+        /// \brief Set the directory to store the index files in. Use an empty string to store
+        ///        them next to the BUFR files.
+        static void setDirectory(const std::string& directory)
+        {
+            instance().directory_ = directory;
+        }
+
+        /// \brief Get the directory the index files are stored in (empty for sidecar files).
+        static std::string getDirectory() { return instance().directory_; }
+
+        /// \brief Should the content hash of the BUFR file be used to validate the index? This is
+        ///        the safest option, but it means the whole file has to be read.
+        static void setUseHash(bool useHash) { instance().useHash_ = useHash; }
+
+        /// \brief Get the path of the index file for a BUFR file.
+        /// \param filePath Path to the BUFR file.
+        static std::string pathFor(const std::string& filePath);
+
+        /// \brief Load the index for a BUFR file.
+        /// \param filePath Path to the BUFR file.
+        /// \param providerType The type of DataProvider the index was made for (the subset names
+        ///        depend on it).
+        /// \param tablePath The master tables the subsets were labeled with (empty if there are
+        ///        none).
+        /// \return The index, or nullptr if there is no valid index for the file.
+        static std::shared_ptr<MessageIndex> load(const std::string& filePath,
+                                                  const std::string& providerType,
+                                                  const std::string& tablePath = "");
+
+        /// \brief Store the index for a BUFR file (if the cache is writable).
+        /// \param index The index to store.
+        /// \param providerType The type of DataProvider the index was made for.
+        /// \param tablePath The master tables the subsets were labeled with.
+        /// \return True if the index was written.
+        static bool save(const MessageIndex& index,
+                         const std::string& providerType,
+                         const std::string& tablePath = "");
+
+     private:
+        bool enabled_ = true;
+        bool writable_ = false;
+        std::string directory_;
+        bool useHash_ = false;
+
+        /// \brief Get the singleton instance of the MessageIndexCache.
+        static MessageIndexCache& instance()
+        {
+            static MessageIndexCache instance;
+            return instance;
+        }
+
+        /// \brief Reads the default settings from the environment.
+        MessageIndexCache();
+    };
+}  // namespace bufr
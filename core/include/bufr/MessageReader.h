@@ -0,0 +1,113 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace bufr {
+
+    /// \brief The decoded section 0 to 3 headers of a BUFR message, along with where the
+    ///        message and its data section are in the file.
+    struct MessageHeader
+    {
+        // Section 0
+        size_t offset = 0;
+        size_t length = 0;
+        int edition = 0;
+
+        // Section 1
+        int masterTable = 0;
+        int centre = 0;
+        int subCentre = 0;
+        int updateSequence = 0;
+        int dataCategory = 0;
+        int intlSubCategory = 0;
+        int dataSubCategory = 0;  // local subcategory (the one NCEPLIB-bufr calls MSBT)
+        int masterTableVersion = 0;
+        int localTableVersion = 0;
+        int year = 0;
+        int month = 0;
+        int day = 0;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+
+        // Section 2
+        bool hasSection2 = false;
+
+        // Section 3
+        size_t numSubsets = 0;
+        bool isObserved = false;
+        bool isCompressed = false;
+        std::vector<int> descriptors;  // F X Y packed into 16 bits
+
+        // Section 4 (relative to the start of the message)
+        size_t dataOffset = 0;
+        size_t dataLength = 0;
+
+        /// \brief Section 1 date in the form YYYYMMDDHH.
+        int date() const { return year * 1000000 + month * 10000 + day * 100 + hour; }
+
+        /// \brief Is this a BUFR table (dictionary) message rather than a data message?
+        bool isDictionary() const { return dataCategory == 11; }
+    };
+
+    /// \brief Reads the framing and section 0 to 3 headers of the BUFR messages in a file
+    ///        directly (no NCEPLIB-bufr). The file is memory mapped, so only the pages holding
+    ///        the headers are actually read from disk. Objects of this class don't have any
+    ///        global state, so separate instances can be used from separate threads.
+    class MessageReader
+    {
+     public:
+        MessageReader() = delete;
+        MessageReader(const MessageReader&) = delete;
+        MessageReader& operator=(const MessageReader&) = delete;
+
+        /// \brief Map the file into memory. If the file can not be opened, the reader behaves as
+        ///        if the file was empty.
+        /// \param filePath Path to the BUFR file.
+        explicit MessageReader(const std::string& filePath);
+
+        ~MessageReader();
+
+        /// \brief Get the path of the file.
+        std::string getFilepath() const { return filePath_; }
+
+        /// \brief Size of the file in bytes.
+        size_t size() const { return size_; }
+
+        /// \brief Pointer to the mapped contents of the file.
+        const uint8_t* data() const { return data_; }
+
+        /// \brief Find the next complete message at or after the given offset. Anything that
+        ///        isn't a valid message (padding, record markers, truncated messages) is skipped.
+        /// \param[in, out] offset Where to start looking. On success this is the offset of the
+        ///                 message that was found.
+        /// \param[out] header The decoded headers of the message.
+        /// \param readDescriptors Should the whole section 3 descriptor list be read? If not
+        ///        only the first descriptor is read.
+        /// \return True if a message was found.
+        bool next(size_t& offset, MessageHeader& header, bool readDescriptors = true) const;
+
+        /// \brief Decode the headers of a message in memory.
+        /// \param msg Pointer to the start of the message ("BUFR").
+        /// \param available Number of bytes available at msg.
+        /// \param[out] header The decoded headers (offset is left unchanged).
+        /// \param readDescriptors Should the whole section 3 descriptor list be read? If not
+        ///        only the first descriptor is read.
+        /// \return True if msg holds a complete and valid message.
+        static bool parse(const uint8_t* msg,
+                          size_t available,
+                          MessageHeader& header,
+                          bool readDescriptors = true);
+
+     private:
+        const std::string filePath_;
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+}  // namespace bufr
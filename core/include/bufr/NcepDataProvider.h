@@ -18,6 +18,9 @@ namespace bufr {
      public:
         explicit NcepDataProvider(const std::string& filePath_);
 
+        /// \brief Closes the file (if it is still open) so its Fortran unit can be reused.
+        ~NcepDataProvider() override;
+
         /// \brief Open the BUFR file with NCEPLIB-bufr
         void open() final;
 
@@ -31,9 +34,13 @@ namespace bufr {
         ///        loaded subset.
         bool hasVariants() const final;
 
+        /// \brief Get the name of the kind of BUFR file this provider reads.
+        std::string typeName() const final { return "NCEP"; }
+
      private:
         /// \brief Data for subset table data
         std::shared_ptr<TableData> currentTableData_ = nullptr;
+        size_t tableGeneration_ = 0;
 
         /// \brief Update the table data for the currently loaded subset.
         /// \param subset The subset string.
@@ -5,18 +5,123 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
+#include <iomanip>
 
+#include "Data.h"
 #include "Tokenizer.h"
 
 namespace bufr {
 
+    /// \brief A condition on the values of the element at the end of a query (i.e. the
+    ///        '[-30:30]' in '*/CLAT[-30:30]'). Subsets with a value that fails it are dropped.
+    struct ValuePredicate
+    {
+        enum class Op
+        {
+            Range,
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual
+        };
+
+        Op op = Op::Range;
+        std::vector<double> values;  // The lower and upper ends for a range
+
+        /// \brief Make the predicate from its token.
+        static std::shared_ptr<ValuePredicate> parse(const PredicateToken& token)
+        {
+            static const std::unordered_map<std::string, Op> opMap = {
+                {"[:]", Op::Range},
+                {"==", Op::Equal},
+                {"!=", Op::NotEqual},
+                {"<", Op::Less},
+                {"<=", Op::LessEqual},
+                {">", Op::Greater},
+                {">=", Op::GreaterEqual}
+            };
+
+            auto predicate = std::make_shared<ValuePredicate>();
+            predicate->op = opMap.at(token.op());
+            predicate->values = token.values();
+            return predicate;
+        }
+
+        /// \brief Does the value pass? Missing values never do.
+        bool test(double value) const
+        {
+            if (Data::isMissingOctet(value)) return false;
+
+            switch (op)
+            {
+                case Op::Range:
+                    return values[0] <= value && value <= values[1];
+                case Op::Equal:
+                    return std::find(values.begin(), values.end(), value) != values.end();
+                case Op::NotEqual:
+                    return std::find(values.begin(), values.end(), value) == values.end();
+                case Op::Less:
+                    return value < values[0];
+                case Op::LessEqual:
+                    return value <= values[0];
+                case Op::Greater:
+                    return value > values[0];
+                case Op::GreaterEqual:
+                    return value >= values[0];
+            }
+
+            return false;
+        }
+
+        /// \brief The predicate as it is written in a query string.
+        std::string str() const
+        {
+            std::ostringstream predicateStr;
+            predicateStr << std::setprecision(15);
+            if (op == Op::Range)
+            {
+                predicateStr << "[";
+                if (!std::isinf(values[0])) predicateStr << values[0];
+                predicateStr << ":";
+                if (!std::isinf(values[1])) predicateStr << values[1];
+                predicateStr << "]";
+                return predicateStr.str();
+            }
+
+            static const std::unordered_map<Op, std::string> opStrs = {
+                {Op::Equal, "=="},
+                {Op::NotEqual, "!="},
+                {Op::Less, "<"},
+                {Op::LessEqual, "<="},
+                {Op::Greater, ">"},
+                {Op::GreaterEqual, ">="}
+            };
+
+            predicateStr << opStrs.at(op);
+            if (values.size() > 1) predicateStr << "{";
+            for (size_t valueIdx = 0; valueIdx < values.size(); ++valueIdx)
+            {
+                if (valueIdx > 0) predicateStr << ",";
+                predicateStr << values[valueIdx];
+            }
+            if (values.size() > 1) predicateStr << "}";
+
+            return predicateStr.str();
+        }
+    };
+
     /// \brief A component of a query string. Abstract base class.
     struct QueryComponent
     {
         std::string name;
         size_t index = 0;
         std::vector<size_t> filter;
+        std::shared_ptr<ValuePredicate> predicate;  // Optional (the last component only)
 
         virtual ~QueryComponent() = default;
     };
@@ -97,6 +202,10 @@ namespace bufr {
                 {
                     component->filter = filterToken->indices();
                 }
+                else if (auto predicateToken = std::dynamic_pointer_cast<PredicateToken>(token))
+                {
+                    component->predicate = ValuePredicate::parse(*predicateToken);
+                }
             }
 
             return component;
@@ -108,7 +217,9 @@ namespace bufr {
     /// \param rhs The right hand side of the operator.
     inline bool operator==(const PathComponent& lhs, const PathComponent& rhs)
     {
-        return lhs.name == rhs.name && lhs.index == rhs.index && lhs.filter == rhs.filter;
+        return lhs.name == rhs.name && lhs.index == rhs.index && lhs.filter == rhs.filter &&
+               (lhs.predicate ? lhs.predicate->str() : "") ==
+               (rhs.predicate ? rhs.predicate->str() : "");
     }
 
     /// \brief A query. Contains the components that make up a query.
@@ -162,6 +273,12 @@ namespace bufr {
                         }
                         pathStr << "}";
                     }
+
+                    // Add predicate string
+                    if (pathComponent->predicate)
+                    {
+                        pathStr << pathComponent->predicate->str();
+                    }
                 }
                 else
                 {
@@ -191,6 +308,13 @@ namespace bufr {
             return false;
         }
 
+        /// \brief Does this query have a value predicate?
+        /// \return True if the element at the end of the query has a predicate.
+        bool hasPredicate() const
+        {
+            return !path.empty() && path.back()->predicate != nullptr;
+        }
+
      private:
         std::string queryStr_;
     };
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 #include <set>
@@ -20,6 +21,27 @@ namespace bufr {
   class QuerySetImpl;
   typedef std::set<std::string> Subsets;
 
+  /// \brief Which subsets to keep while the queries are run (see QuerySet::setSampleStride,
+  /// QuerySet::setSampleFraction and QuerySet::setGridThinning).
+  struct SubsetSampling
+  {
+    size_t stride = 1;  ///< Keep every stride-th subset
+    double fraction = 1;  ///< Keep each subset with this probability
+    uint64_t seed = 0;  ///< Seed for the random sampling
+
+    std::string latitude;  ///< Name of the latitude query for the grid thinning
+    std::string longitude;  ///< Name of the longitude query for the grid thinning
+    double cellSize = 0;  ///< Size of the grid cells in degrees (0 for no thinning)
+    std::string quality;  ///< Optional, name of the query that ranks the subsets in a cell
+    bool lowerIsBetter = true;  ///< Is the best subset the one with the lowest quality value?
+
+    /// \brief Are the subsets thinned on a grid?
+    bool thins() const { return cellSize > 0; }
+
+    /// \brief Are any of the subsets left out?
+    bool isActive() const { return stride > 1 || fraction < 1 || thins(); }
+  };
+
   /// \brief Manages a collection of queries.
   class QuerySet
   {
@@ -51,6 +73,58 @@ namespace bufr {
 
     std::vector<Query> queriesFor(const std::string& name) const;
 
+    /// \brief Only read the messages whose section 1 date is in the time window. Messages
+    /// outside of it are skipped without being unpacked.
+    /// \param[in] start The start of the window in the form YYYYMMDDHH (inclusive).
+    /// \param[in] end The end of the window in the form YYYYMMDDHH (inclusive).
+    void setTimeWindow(int start, int end);
+
+    /// \brief Only read the messages with the given section 1 data category (message type)
+    /// and sub-category. Can be called more than once to read several message types.
+    /// \param[in] dataCategory The data category.
+    /// \param[in] dataSubCategory The local data sub-category (-1 for any).
+    void addMessageType(int dataCategory, int dataSubCategory = -1);
+
+    /// \brief Does the query set limit the messages by their section 1 data (time window or
+    /// message types)?
+    bool filtersMessages() const;
+
+    /// \brief Should a message with the given section 1 data be read?
+    /// \param[in] dataCategory The data category of the message.
+    /// \param[in] dataSubCategory The local data sub-category of the message.
+    /// \param[in] date The date of the message in the form YYYYMMDDHH.
+    bool includesMessage(int dataCategory, int dataSubCategory, int date) const;
+
+    /// \brief Only keep every stride-th subset (the first one and then every stride-th one
+    /// after it, counted over all the subsets that are read).
+    /// \param[in] stride The stride (1 keeps all the subsets).
+    void setSampleStride(size_t stride);
+
+    /// \brief Keep a random sample of the subsets. The same seed gives the same sample.
+    /// \param[in] fraction The probability of keeping each subset, in (0, 1].
+    /// \param[in] seed The seed of the random number generator.
+    void setSampleFraction(double fraction, uint64_t seed = 0);
+
+    /// \brief Keep one subset per latitude/longitude grid cell. The location of a subset is the
+    /// first value of the latitude and longitude queries, subsets without one aren't thinned.
+    /// \param[in] latitudeName The name of the latitude query.
+    /// \param[in] longitudeName The name of the longitude query.
+    /// \param[in] cellSize The size of the grid cells in degrees (0 turns the thinning off).
+    /// \param[in] qualityName Optional, the name of a query ranking the subsets in a cell. The
+    ///            best one is kept rather than the first one (missing values rank last).
+    /// \param[in] lowerIsBetter Is the best subset the one with the lowest quality value?
+    void setGridThinning(const std::string& latitudeName,
+                         const std::string& longitudeName,
+                         double cellSize,
+                         const std::string& qualityName = "",
+                         bool lowerIsBetter = true);
+
+    /// \brief Set all the sampling options at once (see SubsetSampling).
+    void setSampling(const SubsetSampling& sampling);
+
+    /// \brief Get the sampling options.
+    const SubsetSampling& sampling() const;
+
     friend class QueryRunner;
 
    private:
@@ -19,12 +19,55 @@
 namespace bufr {
   class ResultSetImpl;
 
+  /// \brief How much memory the data in a ResultSet takes up (see ResultSet::memoryStats). The
+  /// data of each query lives in a handful of buffers that grow as subsets are added, so the
+  /// reserved bytes can be up to about twice the used bytes unless the buffers were sized up
+  /// front (as is done for each chunk after the first, see File::executeChunks).
+  struct MemoryStats
+  {
+    size_t numSubsets = 0;
+    size_t numBuffers = 0;     ///< The buffers for the counts, offsets and values
+    size_t usedBytes = 0;      ///< The bytes that hold data
+    size_t reservedBytes = 0;  ///< The bytes allocated for the buffers (used or not)
+  };
+
+  /// \brief How the messages behind a ResultSet were decoded (see ResultSet::decodeStats).
+  /// NCEPLIB-bufr reads the first subset of each message. The rest of the subsets are decoded
+  /// straight from the message data when possible (native), otherwise NCEPLIB-bufr reads them
+  /// too (fallback). Messages with a single subset aren't counted.
+  struct DecodeStats
+  {
+    size_t numNativeMessages = 0;    ///< Messages whose other subsets were decoded natively
+    size_t numFallbackMessages = 0;  ///< Messages that were left to NCEPLIB-bufr
+  };
+
+  /// \brief The data for a field without any padding (see ResultSet::getRagged). The values of
+  /// all the subsets are stored one after the other, and the offsets (CSR style) say which of
+  /// them belong to each element of each dimension. There is one offsets array for each
+  /// dimension but the last: the elements of dimension k + 1 (or the values if k is the last
+  /// offsets array) in element i of dimension k are the ones from offsets[k][i] up to
+  /// offsets[k][i + 1]. The first dimension has one element per subset, so fields with only
+  /// one dimension have no offsets and one value per subset.
+  struct RaggedData
+  {
+    std::shared_ptr<DataObjectBase> values;
+    std::vector<std::vector<size_t>> offsets;
+  };
+
+  /// \brief A field to get with ResultSet::getMany (the arguments of ResultSet::get).
+  struct FieldRequest
+  {
+    std::string name;
+    std::string groupByFieldName;
+    std::string overrideType;
+  };
+
   /// \brief This class acts as the container for all the data that is collected during the
-  /// the BUFR querying process in the form of SubsetLookupTable instances.
+  /// the BUFR querying process (stored column wise for each query).
   ///
   /// \par The getter functions for the data construct the final output based on the data and
-  /// metadata in these lookup tables. There are many complications. For one the data may be
-  /// jagged (lookup table instances do not necessarily all have the same number of elements
+  /// metadata in these columns. There are many complications. For one the data may be
+  /// jagged (subsets do not necessarily all have the same number of elements
   /// [repeated data could have a different number of repeats per instance]). Another is the
   /// application group_by fields which affect the dimensionality of the data. In order to make
   /// the data into rectangular arrays it may be necessary to strategically fill in missing values
@@ -49,7 +92,34 @@ namespace bufr {
                                         const std::string& groupByFieldName = "",
                                         const std::string& overrideType     = "") const;
 
+    /// \brief Gets the data for several fields (like get for each of them). The subsets are
+    /// only gone over once to work out the dimensions of all the fields and their group by
+    /// fields, rather than once per field. After that the fields are assembled independently,
+    /// so they can be spread over several threads (the result doesn't depend on the number).
+    /// \param fields The fields to get.
+    /// \param numThreads The number of threads to assemble the fields on (0 for one per core).
+    /// \return The data for each field, in the same order.
+    std::vector<std::shared_ptr<DataObjectBase>>
+    getMany(const std::vector<FieldRequest>& fields, size_t numThreads = 1) const;
+
+    /// \brief Gets the data for a field without padding it into a rectangular array (see
+    /// RaggedData). Unlike get, this doesn't support group_by fields.
+    /// \param fieldName The name of the field to get the data for.
+    /// \param overrideType The name of the override type to convert the data to (see get).
+    /// \return The values and the offsets for each dimension.
+    RaggedData getRagged(const std::string& fieldName,
+                         const std::string& overrideType = "") const;
+
+    /// \brief Gets statistics on the memory used for the collected data.
+    /// \return The MemoryStats.
+    MemoryStats memoryStats() const;
+
+    /// \brief Gets statistics on how the messages were decoded.
+    /// \return The DecodeStats.
+    DecodeStats decodeStats() const;
+
     friend class QueryRunner;
+    friend class WorkerPool;
 
    private:
      std::unique_ptr<ResultSetImpl> impl_;
@@ -0,0 +1,61 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <memory>
+
+#include "ResultSet.h"
+#include "QuerySet.h"
+#include "DataProvider.h"
+
+
+namespace bufr {
+    class ResultSetIteratorImpl;
+
+    /// \brief Executes a QuerySet over a BUFR file one chunk of messages at a time (see
+    ///        File::executeChunks). Each call to next decodes the next chunk and returns its
+    ///        data as a ResultSet, so only one chunk has to be held in memory at a time. The
+    ///        targets and decode programs found for each subset variant are kept from one chunk
+    ///        to the next, and each chunk starts where the last one stopped.
+    class ResultSetIterator
+    {
+     public:
+        ResultSetIterator() = delete;
+        ResultSetIterator(const ResultSetIterator&) = delete;
+        ResultSetIterator(ResultSetIterator&&);
+        ~ResultSetIterator();
+
+        ResultSetIterator& operator=(const ResultSetIterator&) = delete;
+        ResultSetIterator& operator=(ResultSetIterator&&);
+
+        /// \brief Constructor.
+        /// \param dataProvider The DataProvider of the open file.
+        /// \param querySet The queries to execute.
+        /// \param offset The index of the first message to read (counting only the messages
+        ///        that match the QuerySet).
+        /// \param numMessages The number of messages to read (0 for the rest of the file).
+        /// \param chunkMessages The maximum number of messages in a chunk (0 for no limit).
+        /// \param chunkBytes End a chunk once its data takes up this many bytes (0 for no
+        ///        limit). Chunks always end with a whole message, so a chunk can be larger.
+        ResultSetIterator(const std::shared_ptr<DataProvider>& dataProvider,
+                          const QuerySet& querySet,
+                          size_t offset,
+                          size_t numMessages,
+                          size_t chunkMessages,
+                          size_t chunkBytes);
+
+        /// \brief Are there any messages left to read?
+        bool hasNext() const;
+
+        /// \brief Decode the next chunk of messages.
+        /// \return The data for the chunk.
+        ResultSet next();
+
+        /// \brief Index of the next message to read (counting only the messages that match the
+        ///        QuerySet).
+        size_t position() const;
+
+     private:
+        std::unique_ptr<ResultSetIteratorImpl> impl_;
+    };
+}  // namespace bufr
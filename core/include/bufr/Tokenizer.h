@@ -11,6 +11,7 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <limits>
 
 #include "eckit/exception/Exceptions.h"
 
@@ -179,11 +180,89 @@ namespace bufr {
     std::vector<size_t> indices_;
   };
 
-  /// \brief Token for a query (i.e. '*/BRIT{2-4}/PCCF[2]'). This token contains tokens for all
-  ///        the elements of the query string.
+  /// \brief Token for a value predicate at the end of a query (i.e. '[-30:30]', '=={223,224}'
+  ///        or '<4'). The range form includes both ends, and either end may be left out.
+  class PredicateToken : public TokenBase<PredicateToken> {
+  public:
+    constexpr static const char* Pattern
+      = "\\[[-+0-9.eE]*:[-+0-9.eE]*\\]|(==|!=|<=|>=|<|>)([-+0-9.eE]+|\\{[-+0-9.eE,]+\\})";
+    constexpr static const char* DebugStr = "<predicate>";
+
+    /// \brief The operator ("[:]" for a range, otherwise one of ==, !=, <, <=, >, >=).
+    std::string op() const { return op_; }
+
+    /// \brief The values to compare with (the lower and upper ends for a range, where a missing
+    ///        end is -inf or inf).
+    std::vector<double> values() const { return values_; }
+
+    /// \brief Tokenize the str_ into tokens.
+    void tokenize() final {
+      static const auto rangeRegex = std::regex("\\[([^:]*):([^\\]]*)\\]");
+      static const auto compareRegex = std::regex("(==|!=|<=|>=|<|>)(\\{?)([^}]+)\\}?");
+
+      std::smatch matches;
+      if (std::regex_match(str_, matches, rangeRegex)) {
+        op_     = "[:]";
+        values_ = {matches[1].length() ? toNumber(matches[1].str())
+                                       : -std::numeric_limits<double>::infinity(),
+                   matches[2].length() ? toNumber(matches[2].str())
+                                       : std::numeric_limits<double>::infinity()};
+
+        if (values_[0] > values_[1]) {
+          throw eckit::BadParameter("PredicateToken: empty range in predicate " + str_);
+        }
+      } else if (std::regex_match(str_, matches, compareRegex)) {
+        op_ = matches[1].str();
+
+        std::istringstream valuesStr(matches[3].str());
+        std::string valueStr;
+        while (std::getline(valuesStr, valueStr, ',')) {
+          values_.push_back(toNumber(valueStr));
+        }
+
+        if (matches[2].length() && op_ != "==" && op_ != "!=") {
+          throw eckit::BadParameter("PredicateToken: only == and != can take a set of values: "
+                                    + str_);
+        }
+      } else {
+        throw eckit::BadParameter("PredicateToken: invalid predicate " + str_);
+      }
+    }
+
+    /// \brief Get the debug string for the token.
+    std::string debugStr() const override {
+      std::ostringstream debugStr;
+      debugStr << "<predicate=" << str_ << ">";
+      return debugStr.str();
+    }
+
+  private:
+    std::string op_;
+    std::vector<double> values_;
+
+    double toNumber(const std::string& str) const {
+      size_t numChars = 0;
+      double value    = 0;
+      try {
+        value = std::stod(str, &numChars);
+      } catch (const std::exception&) {
+        numChars = 0;
+      }
+
+      if (str.empty() || numChars != str.size()) {
+        throw eckit::BadParameter("PredicateToken: invalid number " + str + " in " + str_);
+      }
+
+      return value;
+    }
+  };
+
+  /// \brief Token for a query (i.e. '*/BRIT{2-4}/PCCF[2]' or '*/CLAT[-30:30]'). This token
+  ///        contains tokens for all the elements of the query string.
   class QueryToken : public TokenBase<QueryToken> {
   public:
-    constexpr static const char* Pattern  = "([A-Z0-9_\\*\\/]+((\\[\\d+\\])?)+(\\{[0-9\\-,]+\\})?)+";
+    constexpr static const char* Pattern  = "([A-Z0-9_\\*\\/]+((\\[\\d+\\])?)+(\\{[0-9\\-,]+\\})?)+"
+      "(\\[[-+0-9.eE]*:[-+0-9.eE]*\\]|(==|!=|<=|>=|<|>)([-+0-9.eE]+|\\{[-+0-9.eE,]+\\}))?";
     constexpr static const char* DebugStr = "<query>";
     constexpr static const char* SubPattern = "[^,]+";
 
@@ -217,6 +296,8 @@ namespace bufr {
           subTokens_.push_back(filter);
         else if (auto index = IndexToken::parse(start, end))
           subTokens_.push_back(index);
+        else if (auto predicate = PredicateToken::parse(start, end))
+          subTokens_.push_back(predicate);
         else
           throw eckit::BadValue("Failed to parse query " + std::string(start, end));
       }
@@ -29,6 +29,9 @@ namespace bufr {
         WmoDataProvider(const std::string& filePath_,
                         const std::string& tableFilePath_);
 
+        /// \brief Closes the file (if it is still open) so its Fortran units can be reused.
+        ~WmoDataProvider() override;
+
         /// \brief Open the BUFR file with NCEPLIB-bufr
         void open() final;
 
@@ -42,22 +45,33 @@ namespace bufr {
         ///        loaded subset.
         bool hasVariants() const final;
 
+        /// \brief Get the name of the kind of BUFR file this provider reads.
+        std::string typeName() const final { return "WMO"; }
+
+        /// \brief Get the path of the master tables the file is read with.
+        std::string tablePath() const final { return tableFilePath_; }
+
         /// \brief Initialize the table cache in order to capture all the subset information.
         void initAllTableData() final;
 
      private:
-        static const int FileUnitTable1 = 13;
-        static const int FileUnitTable2 = 14;
+        int tableUnit1_ = 0;  // Units for the master tables (see FortranUnits)
+        int tableUnit2_ = 0;
 
         const std::string tableFilePath_;
         std::unordered_map<std::string, std::shared_ptr<TableData>> tableCache_;
         std::shared_ptr<TableData> currentTableData_ = nullptr;
         std::unordered_map<std::string, size_t> variantCount_;
+        std::unordered_map<std::string, size_t> variantIds_;
+        size_t tableGeneration_ = 0;
 
         /// \brief Update the table data for the currently loaded subset.
         /// \param subset The subset string.
         void updateTableData(const std::string& subset) final;
 
+        /// \brief Point NCEPLIB-bufr at the master tables for this file.
+        void activateTables() final;
+
         /// \brief Get the currently valid subset table data
         inline std::shared_ptr<TableData> getTableData() const final { return currentTableData_; };
     };
@@ -26,6 +26,7 @@ namespace encoders {
         std::vector<Query> paths;
         std::string source;
         std::string labels;
+        bool ragged = false;  // Write as a CF contiguous ragged array (netCDF only)
     };
 
     struct VariableDescription
@@ -110,7 +111,8 @@ namespace encoders {
         void addDimension(const std::string& name,
                            const std::vector<std::string>& paths,
                            const std::string& source = "",
-                           const std::string& labels = "");
+                           const std::string& labels = "",
+                           bool ragged = false);
 
         /// \brief Remove a dimension element
         void removeDimension(const std::string& name);
@@ -54,7 +54,7 @@ namespace encoders {
 
       virtual ~EncoderDimensions() = default;
 
-      std::vector<EncoderDimensionPtr> dims() { return dims_; };
+      std::vector<EncoderDimensionPtr> dims() const { return dims_; };
 
       std::vector<std::string> dimNamesForVar(const std::string& varName) const
       {
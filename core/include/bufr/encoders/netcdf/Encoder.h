@@ -74,6 +74,18 @@ namespace netcdf {
         DimensionDescription dimForDimPath(const Query &path,
                                            const NamedPathDims &pathMap) const;
 
+        /// \brief Work out how much of each row to write for the ragged dimensions (see
+        ///        DimensionDescription::ragged). A row ends after the last element that isn't
+        ///        missing in any of the variables on the dimension.
+        /// \param container The data container.
+        /// \param categories The categories being written.
+        /// \param dims The dimensions for the categories.
+        /// \return The row size for each location, by dimension name.
+        std::map<std::string, std::vector<size_t>>
+            getRowSizes(const std::shared_ptr<DataContainer>& container,
+                        const SubCategory& categories,
+                        const EncoderDimensions& dims) const;
+
         /// \brief Split the variable name into group / name components
         /// \param name The variable name to split.
         std::pair<std::string, std::string> splitName(std::string name) const;
@@ -16,6 +16,7 @@
 #include "bufr/Split.h"
 #include "eckit/exception/Exceptions.h"
 #include "../Log.h"
+#include "../ThreadPool.h"
 
 namespace bufr {
 
@@ -53,7 +54,9 @@ namespace bufr {
         file_.close();
     }
 
-    std::shared_ptr<DataContainer> BufrParser::parse(const size_t maxMsgsToParse)
+    std::shared_ptr<DataContainer> BufrParser::parse(const size_t maxMsgsToParse,
+                                                     const size_t numWorkers,
+                                                     const size_t numThreads)
     {
         auto startTime = std::chrono::steady_clock::now();
 
@@ -67,22 +70,32 @@ namespace bufr {
             }
         }
 
+        querySet.setSampling(description_.getExport().getSampling());
+
         log::info() << "Executing Queries" << std::endl;
-        const auto resultSet = file_.execute(querySet, maxMsgsToParse);
+        const auto resultSet = file_.execute(querySet, 0, maxMsgsToParse, numWorkers);
 
         log::info() << "Building Bufr Data" << std::endl;
-        auto srcData = BufrDataMap();
+        std::vector<FieldRequest> fields;
         for (const auto& var : description_.getExport().getVariables())
         {
             for (const auto& queryInfo : var->getQueryList())
             {
-                srcData[queryInfo.name] = resultSet.get(
-                    queryInfo.name, queryInfo.groupByField, queryInfo.type);
+                fields.push_back({queryInfo.name, queryInfo.groupByField, queryInfo.type});
             }
         }
 
+        // All the fields are worked out together (one pass over the subsets).
+        const auto objects = resultSet.getMany(fields, numThreads);
+
+        auto srcData = BufrDataMap();
+        for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx)
+        {
+            srcData[fields[fieldIdx].name] = objects[fieldIdx];
+        }
+
         log::info()  << "Exporting Data" << std::endl;
-        auto exportedData = exportData(srcData);
+        auto exportedData = exportData(srcData, numThreads);
 
         auto timeElapsed = std::chrono::steady_clock::now() - startTime;
         auto timeElapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>
@@ -94,7 +107,8 @@ namespace bufr {
         return exportedData;
     }
 
-    std::shared_ptr<DataContainer> BufrParser::parse(const eckit::mpi::Comm& comm)
+    std::shared_ptr<DataContainer> BufrParser::parse(const eckit::mpi::Comm& comm,
+                                                     const size_t numThreads)
     {
       // Make the QuerySet
       auto querySet = QuerySet(description_.getExport().getSubsets());
@@ -106,6 +120,8 @@ namespace bufr {
         }
       }
 
+      querySet.setSampling(description_.getExport().getSampling());
+
       auto msgsInFile = file_.size(querySet);
 
       // Distribute the messages to the tasks
@@ -134,18 +150,25 @@ namespace bufr {
       const auto resultSet = file_.execute(querySet, startOffset, msgsToParse);
 
       log::info() << "MPI task: " << comm.rank() << " Building Bufr Data" << std::endl;
-      auto srcData = BufrDataMap();
+      std::vector<FieldRequest> fields;
       for (const auto& var : description_.getExport().getVariables())
       {
         for (const auto& queryInfo : var->getQueryList())
         {
-          srcData[queryInfo.name] = resultSet.get(
-            queryInfo.name, queryInfo.groupByField, queryInfo.type);
+          fields.push_back({queryInfo.name, queryInfo.groupByField, queryInfo.type});
         }
       }
 
+      const auto objects = resultSet.getMany(fields, numThreads);
+
+      auto srcData = BufrDataMap();
+      for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx)
+      {
+        srcData[fields[fieldIdx].name] = objects[fieldIdx];
+      }
+
       log::info() << "MPI task: " << comm.rank() << " Exporting Data" << std::endl;
-      auto exportedData = exportData(srcData);
+      auto exportedData = exportData(srcData, numThreads);
 
       auto timeElapsed = std::chrono::steady_clock::now() - startTime;
       auto timeElapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>
@@ -157,7 +180,8 @@ namespace bufr {
       return exportedData;
     }
 
-    std::shared_ptr<DataContainer> BufrParser::exportData(const BufrDataMap &srcData) {
+    std::shared_ptr<DataContainer> BufrParser::exportData(const BufrDataMap &srcData,
+                                                          const size_t numThreads) {
         auto exportDescription = description_.getExport();
 
         auto filters = exportDescription.getFilters();
@@ -187,23 +211,35 @@ namespace bufr {
             splitDataMaps = splitData(splitDataMaps, *split);
         }
 
-        // Export
-        auto exportData = std::make_shared<DataContainer>(catMap);
+        // Export. The variables (of every category) don't depend on each other, so they are
+        // exported at the same time and then added to the container in the usual order.
+        std::vector<const CatDataMap::value_type*> categories;
         for (const auto &dataPair : splitDataMaps)
         {
-            for (const auto &var : vars)
-            {
-                std::ostringstream pathStr;
-                pathStr << "variables/" << var->getExportName();
+            categories.push_back(&dataPair);
+        }
+
+        std::vector<std::shared_ptr<DataObjectBase>> objects(categories.size() * vars.size());
+        ThreadPool pool(numThreads, objects.size());
+        pool.run(objects.size(), [&](size_t objectIdx)
+        {
+            const auto& var = vars[objectIdx % vars.size()];
+            objects[objectIdx] = var->exportData(categories[objectIdx / vars.size()]->second);
+        });
+
+        auto exportData = std::make_shared<DataContainer>(catMap);
+        for (size_t objectIdx = 0; objectIdx < objects.size(); ++objectIdx)
+        {
+            const auto& var = vars[objectIdx % vars.size()];
 
-                std::string ovar;
-                ovar = var->getExportName();
-                log::debug() << "Exporting variable = " << ovar << std::endl;
+            std::ostringstream pathStr;
+            pathStr << "variables/" << var->getExportName();
 
-                exportData->add(pathStr.str(),
-                                var->exportData(dataPair.second),
-                                dataPair.first);
-            }
+            log::debug() << "Exporting variable = " << var->getExportName() << std::endl;
+
+            exportData->add(pathStr.str(),
+                            objects[objectIdx],
+                            categories[objectIdx / vars.size()]->first);
         }
 
         return exportData;
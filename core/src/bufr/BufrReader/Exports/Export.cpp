@@ -30,6 +30,7 @@ namespace
         const char* Variables = "variables";
         const char* GroupByVariable = "group_by_variable";
         const char* Subsets = "subsets";
+        const char* Sampling = "sampling";
 
         namespace Variable
         {
@@ -53,6 +54,19 @@ namespace
         {
             const char* Bounding = "bounding";
         }
+
+        namespace Sample
+        {
+            const char* Stride = "stride";
+            const char* Fraction = "fraction";
+            const char* Seed = "seed";
+            const char* Thinning = "thinning";
+            const char* Latitude = "latitude";
+            const char* Longitude = "longitude";
+            const char* CellSize = "cellSize";
+            const char* Quality = "quality";
+            const char* LowerIsBetter = "lowerIsBetter";
+        }  // namespace Sample
     }  // namespace ConfKeys
 }  // namespace
 
@@ -109,6 +123,11 @@ namespace bufr {
                     "Group by variable not found in export::variables section.");
             }
         }
+
+        if (conf.has(ConfKeys::Sampling))  // Optional
+        {
+            addSampling(conf.getSubConfiguration(ConfKeys::Sampling));
+        }
     }
 
     void Export::addVariables(const eckit::Configuration &conf, const std::string& groupByField)
@@ -214,4 +233,56 @@ namespace bufr {
             filters_.push_back(filter);
         }
     }
+
+    void Export::addSampling(const eckit::Configuration &conf)
+    {
+        if (conf.has(ConfKeys::Sample::Stride))
+        {
+            const auto stride = conf.getInt(ConfKeys::Sample::Stride);
+            if (stride < 1)
+            {
+                throw eckit::BadParameter("bufr::sampling::stride must be at least 1.");
+            }
+
+            sampling_.stride = static_cast<size_t>(stride);
+        }
+
+        if (conf.has(ConfKeys::Sample::Fraction))
+        {
+            sampling_.fraction = conf.getDouble(ConfKeys::Sample::Fraction);
+            sampling_.seed = static_cast<uint64_t>(conf.getLong(ConfKeys::Sample::Seed, 0));
+        }
+
+        if (!conf.has(ConfKeys::Sample::Thinning)) return;
+
+        const auto thinConf = conf.getSubConfiguration(ConfKeys::Sample::Thinning);
+        sampling_.latitude = thinConf.getString(ConfKeys::Sample::Latitude);
+        sampling_.longitude = thinConf.getString(ConfKeys::Sample::Longitude);
+        sampling_.cellSize = thinConf.getDouble(ConfKeys::Sample::CellSize);
+        sampling_.quality = thinConf.getString(ConfKeys::Sample::Quality, "");
+        sampling_.lowerIsBetter = thinConf.getBool(ConfKeys::Sample::LowerIsBetter, true);
+
+        // The thinning works on the queries, so the variables have to be query variables.
+        for (const auto& name : {sampling_.latitude, sampling_.longitude, sampling_.quality})
+        {
+            if (name.empty()) continue;
+
+            bool found = false;
+            for (const auto& var : variables_)
+            {
+                for (const auto& queryInfo : var->getQueryList())
+                {
+                    found = found || (queryInfo.name == name);
+                }
+            }
+
+            if (!found)
+            {
+                std::stringstream errStr;
+                errStr << "bufr::sampling::thinning variable " << name << " must be a query ";
+                errStr << "variable in the export::variables section.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+    }
 }  // namespace bufr
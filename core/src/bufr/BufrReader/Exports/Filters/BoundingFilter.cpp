@@ -70,9 +70,9 @@ namespace bufr {
                 extraDims *= dims[dimIdx];
             }
 
-            // Make local copy otherwise you get weird memory corruption issue.
-            auto rawData = var->getRawData();
-            auto array = Eigen::Map<EigArray> (rawData.data(), dims[0], extraDims);
+            // Read only view of the data (var keeps it alive).
+            const auto rawData = var->getRawDataView();
+            auto array = Eigen::Map<const EigArray> (rawData.data(), dims[0], extraDims);
 
             for (auto rowIdx = 0; rowIdx < dims[0]; rowIdx++)
             {
@@ -125,7 +125,7 @@ namespace bufr {
             }
         }
 
-        return DataObjectBuilder::make<float>(aircraftAlts,
+        return DataObjectBuilder::make<float>(std::move(aircraftAlts),
                                               getExportName(),
                                               groupByField_,
                                               referenceObj->getDims(),
@@ -57,7 +57,6 @@ namespace bufr {
     checkKeys(map);
     static const int missingInt = DataObject<int>::missingValue();
 
-    setenv("TZ", "UTC", 1);             // Force UTC time zone
     std::tm tm{};                       // zero initialise
     tm.tm_year          = 1970 - 1900;  // 1970
     tm.tm_mon           = 0;            // Jan=0, Feb=1, ...
@@ -66,7 +65,7 @@ namespace bufr {
     tm.tm_min           = 0;
     tm.tm_sec           = 0;
     tm.tm_isdst         = 0;  // Not daylight saving
-    std::time_t epochDt = std::mktime(&tm);
+    std::time_t epochDt = timegm(&tm);  // UTC (doesn't depend on the TZ of the process)
 
     std::vector<int64_t> timeOffsets;
     timeOffsets.reserve(map.at(getExportKey(ConfKeys::Year))->size());
@@ -117,8 +116,7 @@ namespace bufr {
           }
         }
 
-        // Be careful with mktime as it can be very slow.
-        auto thisTime = std::mktime(&tm);
+        auto thisTime = timegm(&tm);
         if (thisTime < 0) {
           log::warning() << "Caution, date suspicious date (year, month, day): " << year << ", "
                                << month << ", " << day << std::endl;
@@ -130,7 +128,7 @@ namespace bufr {
       timeOffsets.push_back(diff_time);
     }
 
-    return DataObjectBuilder::make<int64_t>(timeOffsets,
+    return DataObjectBuilder::make<int64_t>(std::move(timeOffsets),
                                             getExportName(),
                                             groupByField_,
                                             map.at(getExportKey(ConfKeys::Year))->getDims(),
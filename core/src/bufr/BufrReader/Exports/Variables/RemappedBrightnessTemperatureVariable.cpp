@@ -3,6 +3,7 @@
 #include "RemappedBrightnessTemperatureVariable.h"
 
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <unordered_map>
 #include <vector>
@@ -30,6 +31,10 @@ namespace
                                                  ConfKeys::SensorChannelNumber,
                                                  ConfKeys::BrightnessTemperature,
                                                 };
+
+    // The ATMS remapping code keeps state in Fortran module variables, so only one variable
+    // can use it at a time (the variables can be exported on several threads).
+    std::mutex atmsMutex;
 }  // namespace
 
 
@@ -68,10 +73,11 @@ namespace bufr {
         // scanline has the same dimension as fovn
         std::vector<int> scanline(fovnObj->size(), DataObject<int>::missingValue());
 
-        // Get observation time (obstime) variable
+        // Get observation time (obstime) variable (read in place, the arrays are passed to
+        // Fortran as a c_ptr by reference)
         auto datetimeObj = datetime_.exportData(map);
-        std::vector<int64_t> obstime;
-        obstime = std::dynamic_pointer_cast<DataObject<int64_t>>(datetimeObj)->getRawData();
+        const int64_t* obstime =
+            std::dynamic_pointer_cast<DataObject<int64_t>>(datetimeObj)->getRawDataView().data();
 
         // Get field-of-view number
         std::vector<int> fovn(fovnObj->size(), DataObject<int>::missingValue());
@@ -99,12 +105,13 @@ namespace bufr {
         // input & output variables: btobs, scanline, error_status
         if (nobs > 0) {
             int error_status;
+            std::lock_guard<std::mutex> lock(atmsMutex);
 	    ATMS_Spatial_Average_f(nobs, nchn, &obstime, &fovn, &channel, &btobs,
                                                &scanline, &error_status);
         }
 
         // Export remapped observation (btobs)
-        return DataObjectBuilder::make<float>(btobs,
+        return DataObjectBuilder::make<float>(std::move(btobs),
                                               getExportName(),
                                               groupByField_,
                                               radObj->getDims(),
@@ -124,7 +124,7 @@ namespace bufr {
            }
         }
 
-        return DataObjectBuilder::make<float>(scanang,
+        return DataObjectBuilder::make<float>(std::move(scanang),
                                               getExportName(),
                                               groupByField_,
                                               fovnObj->getDims(),
@@ -78,7 +78,7 @@ namespace bufr {
            }
         }
 
-        return DataObjectBuilder::make<int>(scanpos,
+        return DataObjectBuilder::make<int>(std::move(scanpos),
                                               getExportName(),
                                               groupByField_,
                                               fovnObj->getDims(),
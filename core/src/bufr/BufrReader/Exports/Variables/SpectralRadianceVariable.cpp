@@ -89,7 +89,7 @@ namespace bufr {
 //                                                   radObj->getPath(),
 //                                                   radObj->getDimPaths());
 
-        return DataObjectBuilder::make<float>(outData,
+        return DataObjectBuilder::make<float>(std::move(outData),
                                               getExportName(),
                                               groupByField_,
                                               radObj->getDims(),
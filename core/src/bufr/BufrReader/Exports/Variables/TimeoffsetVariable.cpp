@@ -88,7 +88,7 @@ namespace bufr {
             timeDiffs[idx] = diff_time;
         }
 
-        return DataObjectBuilder::make<int64_t>(timeDiffs,
+        return DataObjectBuilder::make<int64_t>(std::move(timeDiffs),
                                               getExportName(),
                                               groupByField_,
                                               timeOffsets->getDims(),
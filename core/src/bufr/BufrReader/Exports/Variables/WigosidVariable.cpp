@@ -88,7 +88,7 @@ namespace bufr {
 
         const auto& wigosIds = map.at(getExportKey(ConfKeys::Wgosids));
 
-        return DataObjectBuilder::make<std::string>(wigosID,
+        return DataObjectBuilder::make<std::string>(std::move(wigosID),
                                                     getExportName(),
                                                     groupByField_,
                                                     wigosIds->getDims(),
@@ -0,0 +1,168 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "Aggregator.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    namespace
+    {
+        void checkName(const std::vector<std::string>& names, const std::string& name)
+        {
+            if (std::find(names.begin(), names.end(), name) == names.end())
+            {
+                std::ostringstream errStr;
+                errStr << "Can't aggregate " << name << ", the QuerySet has no query with that ";
+                errStr << "name.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+
+        void checkNumeric(const Data& values, const std::string& name)
+        {
+            if (values.isLongStr() && !values.empty())
+            {
+                std::ostringstream errStr;
+                errStr << "Can't aggregate " << name << ", it holds long strings.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+    }  // namespace
+
+    Aggregator::Aggregator(const QuerySet& querySet, const std::vector<AggregateSpec>& specs)
+    {
+        const auto names = querySet.names();
+
+        for (const auto& spec : specs)
+        {
+            if (spec.binEdges.size() == 1 ||
+                std::adjacent_find(spec.binEdges.begin(), spec.binEdges.end(),
+                                   std::greater_equal<double>()) != spec.binEdges.end())
+            {
+                std::ostringstream errStr;
+                errStr << "The histogram bin edges for " << spec.field << " must be at least 2 ";
+                errStr << "values in ascending order.";
+                throw eckit::BadParameter(errStr.str());
+            }
+
+            checkName(names, spec.field);
+            if (!spec.groupBy.empty()) checkName(names, spec.groupBy);
+
+            AggregateResult result;
+            result.spec = spec;
+            result.total.histogram.resize(std::max(spec.binEdges.size(), size_t(1)) - 1, 0);
+            results_.push_back(result);
+        }
+    }
+
+    void Aggregator::add(const ResultSetImpl& results)
+    {
+        if (results.columns_.empty()) return;
+
+        // The columns are found the first time there is data (they follow the targets).
+        if (fieldIdxs_.empty())
+        {
+            for (const auto& result : results_)
+            {
+                const auto& spec = result.spec;
+                fieldIdxs_.push_back(results.targetIdx(spec.field));
+                groupIdxs_.push_back(spec.groupBy.empty() ?
+                                     -1 : static_cast<int>(results.targetIdx(spec.groupBy)));
+            }
+        }
+
+        for (size_t specIdx = 0; specIdx < results_.size(); ++specIdx)
+        {
+            auto& result = results_[specIdx];
+            const auto& binEdges = result.spec.binEdges;
+            const auto& column = results.columns_[fieldIdxs_[specIdx]];
+            const auto& values = column.values();
+            checkNumeric(values, result.spec.field);
+
+            if (groupIdxs_[specIdx] < 0)
+            {
+                // Values past the last subset belong to one that is still being collected.
+                const auto end = column.valuesOffset(column.size());
+                for (size_t valueIdx = 0; valueIdx < end; ++valueIdx)
+                {
+                    if (!values.isMissing(valueIdx))
+                    {
+                        addValue(result.total, binEdges, values.value.octets[valueIdx]);
+                    }
+                }
+
+                continue;
+            }
+
+            const auto& groupColumn = results.columns_[groupIdxs_[specIdx]];
+            const auto& groupValues = groupColumn.values();
+            checkNumeric(groupValues, result.spec.groupBy);
+
+            for (size_t subsetIdx = 0; subsetIdx < results.size(); ++subsetIdx)
+            {
+                const auto numValues = column.numValues(subsetIdx);
+                const auto numGroups = groupColumn.numValues(subsetIdx);
+                if (numValues == 0) continue;
+
+                if (numGroups > 1 && numGroups != numValues)
+                {
+                    std::ostringstream errStr;
+                    errStr << "Can't group " << result.spec.field << " by ";
+                    errStr << result.spec.groupBy << ", a subset has " << numValues;
+                    errStr << " values of one and " << numGroups << " of the other.";
+                    throw eckit::BadValue(errStr.str());
+                }
+
+                const auto offset = column.valuesOffset(subsetIdx);
+                const auto groupOffset = groupColumn.valuesOffset(subsetIdx);
+                for (size_t idx = 0; idx < numValues; ++idx)
+                {
+                    if (values.isMissing(offset + idx)) continue;
+
+                    const auto value = values.value.octets[offset + idx];
+                    addValue(result.total, binEdges, value);
+
+                    // Values without a group only count towards the total.
+                    const auto groupIdx = groupOffset + ((numGroups > 1) ? idx : 0);
+                    if (numGroups == 0 || groupValues.isMissing(groupIdx)) continue;
+
+                    auto groupIt = result.groups.find(groupValues.value.octets[groupIdx]);
+                    if (groupIt == result.groups.end())
+                    {
+                        AggregateStats stats;
+                        stats.histogram.resize(result.total.histogram.size(), 0);
+                        groupIt = result.groups.emplace(groupValues.value.octets[groupIdx],
+                                                        stats).first;
+                    }
+
+                    addValue(groupIt->second, binEdges, value);
+                }
+            }
+        }
+    }
+
+    void Aggregator::addValue(AggregateStats& stats,
+                              const std::vector<double>& binEdges,
+                              double value) const
+    {
+        stats.count++;
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+        stats.sum += value;
+
+        if (stats.histogram.empty() || value < binEdges.front() || value > binEdges.back())
+        {
+            return;
+        }
+
+        // The bins include their lower edge, and the last one its upper edge as well.
+        auto binIdx = static_cast<size_t>(std::upper_bound(binEdges.begin(), binEdges.end(), value)
+                                          - binEdges.begin()) - 1;
+        stats.histogram[std::min(binIdx, stats.histogram.size() - 1)]++;
+    }
+}  // namespace bufr
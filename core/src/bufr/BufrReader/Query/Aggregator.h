@@ -0,0 +1,40 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <vector>
+
+#include "bufr/Aggregate.h"
+#include "bufr/QuerySet.h"
+#include "ResultSetImpl.h"
+
+
+namespace bufr {
+    /// \brief Computes the statistics of File::aggregate. The subsets are folded in as they are
+    /// collected (see QueryRunner::aggregate), so only the statistics themselves (one entry per
+    /// group) are kept from one message to the next.
+    class Aggregator
+    {
+     public:
+        /// \brief Constructor.
+        /// \param querySet The QuerySet the subsets are collected with.
+        /// \param specs What to compute.
+        Aggregator(const QuerySet& querySet, const std::vector<AggregateSpec>& specs);
+
+        /// \brief Add the subsets in a ResultSetImpl to the statistics.
+        /// \param results The collected subsets.
+        void add(const ResultSetImpl& results);
+
+        /// \brief Get the statistics for each AggregateSpec.
+        std::vector<AggregateResult> results() const { return results_; }
+
+     private:
+        std::vector<AggregateResult> results_;
+        std::vector<size_t> fieldIdxs_;  // Column of the field for each spec
+        std::vector<int> groupIdxs_;  // Column of the groupBy field for each spec (-1 if none)
+
+        /// \brief Add a value to some statistics.
+        void addValue(AggregateStats& stats, const std::vector<double>& binEdges,
+                      double value) const;
+    };
+}  // namespace bufr
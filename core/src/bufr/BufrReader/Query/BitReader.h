@@ -0,0 +1,94 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace bufr {
+
+    /// \brief Reads big endian bit fields (as found in BUFR section 4) from a block of memory.
+    ///        Reading past the end does not fail right away. Instead the reader is flagged as
+    ///        overrun (see ok()) and returns zeros, so callers only need to check once.
+    class BitReader
+    {
+     public:
+        BitReader(const uint8_t* data, size_t numBits) :
+            data_(data),
+            numBits_(numBits)
+        {
+        }
+
+        /// \brief Current position in bits.
+        size_t position() const { return pos_; }
+
+        /// \brief Total number of bits available.
+        size_t size() const { return numBits_; }
+
+        /// \brief Have all reads so far been inside the data?
+        bool ok() const { return !overrun_; }
+
+        /// \brief Move to an absolute bit position.
+        void seek(size_t bitPos)
+        {
+            pos_ = bitPos;
+            if (pos_ > numBits_) overrun_ = true;
+        }
+
+        /// \brief Skip over some bits.
+        void skip(size_t numBits)
+        {
+            pos_ += numBits;
+            if (pos_ > numBits_) overrun_ = true;
+        }
+
+        /// \brief Read an unsigned integer of up to 64 bits.
+        /// \param numBits Width of the field in bits.
+        uint64_t read(unsigned int numBits)
+        {
+            if (numBits == 0) return 0;
+
+            if (pos_ + numBits > numBits_)
+            {
+                overrun_ = true;
+                pos_ += numBits;
+                return 0;
+            }
+
+            uint64_t value;
+            const size_t byteIdx = pos_ >> 3;
+            const unsigned int bitIdx = pos_ & 7;
+
+            if (numBits <= 57 && byteIdx + 8 <= (numBits_ + 7) / 8)
+            {
+                // Fast path, one unaligned big endian load holds the whole field.
+                uint64_t word = 0;
+                for (size_t idx = 0; idx < 8; ++idx)
+                {
+                    word = (word << 8) | data_[byteIdx + idx];
+                }
+
+                value = (word << bitIdx) >> (64 - numBits);
+            }
+            else
+            {
+                value = 0;
+                size_t bitPos = pos_;
+                for (unsigned int bit = 0; bit < numBits; ++bit, ++bitPos)
+                {
+                    value = (value << 1) | ((data_[bitPos >> 3] >> (7 - (bitPos & 7))) & 1);
+                }
+            }
+
+            pos_ += numBits;
+            return value;
+        }
+
+     private:
+        const uint8_t* data_;
+        const size_t numBits_;
+        size_t pos_ = 0;
+        bool overrun_ = false;
+    };
+}  // namespace bufr
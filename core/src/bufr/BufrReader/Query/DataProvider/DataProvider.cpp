@@ -1,11 +1,15 @@
 // (C) Copyright 2022 NOAA/NWS/NCEP/EMC
 
 #include "bufr/DataProvider.h"
+#include "bufr/MessageIndexCache.h"
 #include "bufr_interface.h"
+#include "message_reader_interface.h"
 
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <tuple>
 #include <unordered_map>
 
 #include "eckit/exception/Exceptions.h"
@@ -25,45 +29,192 @@ namespace bufr {
             throw eckit::BadParameter(errStr.str());
         }
 
-        static int SubsetLen = 9;
-        char subsetChars[SubsetLen];
-        int iddate;
+        // NCEPLIB-bufr can only work on one file at a time.
+        auto lock = FortranUnits::lock();
+        activateTables();
+
+        // Seeking is only worth building the index for if we would otherwise need to skip over
+        // messages. The section 1 filters also need it (they are checked against the index so
+        // the messages they exclude are never unpacked).
+        if (offset > 0 || querySet.filtersMessages()) getIndex();
 
         int bufrLoc;
         int il, im;  // throw away
 
-        size_t msgCnt = 0;
         bool foundBufrMsg = false;
         bool foundBufrSubset = false;
 
-        while (ireadmg_f(FileUnit, subsetChars, &iddate, SubsetLen) == 0)
+        // The subset reader (if any) can take over after the first subset of a message whose
+        // headers are known (header is null otherwise). fileData is the start of the mapped file.
+        auto processSubsets = [&](const MessageHeader* header, const uint8_t* fileData)
         {
-            foundBufrMsg = true;
-            subset_ = std::string(subsetChars);
-            subset_.erase(std::remove_if(subset_.begin(), subset_.end(), isspace), subset_.end());
+            bool isFirstSubset = true;
+            while (ireadsb_f(fileUnit_) == 0)
+            {
+                foundBufrSubset = true;
+                status_f(fileUnit_, &bufrLoc, &il, &im);
+                updateData(bufrLoc);
+
+                processSubset();
+                if (!continueProcessing()) break;
 
-            if (!querySet.includesSubset(subset_)) continue;
+                if (isFirstSubset && subsetReader_ && header != nullptr && header->numSubsets > 1)
+                {
+                    if (subsetReader_(*header, fileData + header->offset)) break;
+                }
 
-            msgCnt++;
-            if (msgCnt <= offset)
+                isFirstSubset = false;
+            }
+
+            processMsg();
+        };
+
+        if (index_ == nullptr && subsetReader_)
+        {
+            // The subset reader needs the message data, so the messages are framed here as the
+            // run gets to them (rather than indexing the whole file up front). If the run gets to
+            // the end of the file, the entries make up the index of the file.
+            const auto reader = std::make_shared<MessageReader>(filePath_);
+            std::vector<MessageInfo> messages;
+            bool foundDataMsg = false;
+            bool keepRunning = true;
+            size_t msgCnt = 0;
+
+            size_t fileOffset = 0;
+            MessageHeader header;
+            while (keepRunning && reader->next(fileOffset, header))
             {
-                processMsg();
-                if (!continueProcessing()) break;
-                continue;
+                const uint8_t* msgData = reader->data() + header.offset;
+                fileOffset += header.length;
+
+                messages.push_back(MessageIndex::infoFor(header));
+                auto& msg = messages.back();
+
+                // The tables at the start of the file were read when it was opened.
+                if (msg.isDictionary())
+                {
+                    if (foundDataMsg) loadMessage(msgData, msg.length);
+                    continue;
+                }
+
+                foundDataMsg = true;
+                msg.subset = loadMessage(msgData, msg.length);
+                if (msg.subset.empty()) continue;
+
+                foundBufrMsg = true;
+                subset_ = msg.subset;
+                if (!querySet.includesSubset(subset_)) continue;
+
+                msgCnt++;
+                if (msgCnt <= offset)
+                {
+                    processMsg();
+                    keepRunning = continueProcessing();
+                    continue;
+                }
+
+                processSubsets(&header, reader->data());
+                keepRunning = continueProcessing();
             }
 
-            while (ireadsb_f(FileUnit) == 0)
+            if (keepRunning)
             {
-                foundBufrSubset = true;
-                status_f(FileUnit, &bufrLoc, &il, &im);
-                updateData(bufrLoc);
+                index_ = std::make_shared<MessageIndex>(filePath_, std::move(messages));
+                MessageIndexCache::save(*index_, typeName(), tablePath());
+            }
+        }
+        else if (index_ == nullptr)
+        {
+            static int SubsetLen = 9;
+            char subsetChars[SubsetLen];
+            int iddate;
 
-                processSubset();
+            size_t msgCnt = 0;
+            while (ireadmg_f(fileUnit_, subsetChars, &iddate, SubsetLen) == 0)
+            {
+                foundBufrMsg = true;
+                subset_ = std::string(subsetChars);
+                subset_.erase(std::remove_if(subset_.begin(), subset_.end(), isspace),
+                              subset_.end());
+
+                if (!querySet.includesSubset(subset_)) continue;
+
+                msgCnt++;
+                if (msgCnt <= offset)
+                {
+                    processMsg();
+                    if (!continueProcessing()) break;
+                    continue;
+                }
+
+                processSubsets(nullptr, nullptr);
                 if (!continueProcessing()) break;
             }
+        }
+        else
+        {
+            const auto& index = *index_;
+            const auto msgIdxs = index.messagesFor(querySet);
+            foundBufrMsg = std::any_of(index.messages().begin(),
+                                       index.messages().end(),
+                                       [](const MessageInfo& msg)
+                                       {
+                                           return !msg.isDictionary() && !msg.subset.empty();
+                                       });
+
+            // Account for the skipped messages without reading them.
+            bool keepRunning = true;
+            for (size_t msgCnt = 0; msgCnt < std::min(offset, msgIdxs.size()); ++msgCnt)
+            {
+                processMsg();
+                if (!(keepRunning = continueProcessing())) break;
+            }
 
-            processMsg();
-            if (!continueProcessing()) break;
+            if (keepRunning && offset < msgIdxs.size())
+            {
+                // The tables at the start of the file were read when it was opened, but any table
+                // messages that come later on still need to be loaded (in order).
+                bool foundDataMsg = false;
+                for (size_t msgIdx = 0; msgIdx < msgIdxs[offset]; ++msgIdx)
+                {
+                    if (!index[msgIdx].isDictionary())
+                    {
+                        foundDataMsg = true;
+                    }
+                    else if (foundDataMsg)
+                    {
+                        loadMessage(index, msgIdx);
+                    }
+                }
+
+                for (size_t msgIdx = msgIdxs[offset]; msgIdx < index.size(); ++msgIdx)
+                {
+                    const auto& msg = index[msgIdx];
+                    if (msg.isDictionary())
+                    {
+                        loadMessage(index, msgIdx);
+                        continue;
+                    }
+
+                    if (msg.subset.empty() ||
+                        !querySet.includesSubset(msg.subset) ||
+                        !querySet.includesMessage(msg.dataCategory, msg.dataSubCategory, msg.date))
+                    {
+                        continue;
+                    }
+
+                    subset_ = loadMessage(index, msgIdx);
+                    if (subset_.empty()) continue;
+
+                    // The full headers are only needed if the subset reader can be used.
+                    MessageHeader header;
+                    const bool hasHeader = subsetReader_ && msg.numSubsets > 1;
+                    if (hasHeader) header = index.header(msgIdx);
+
+                    processSubsets(hasHeader ? &header : nullptr, index.getReader()->data());
+                    if (!continueProcessing()) break;
+                }
+            }
         }
 
         deleteData();
@@ -83,6 +234,12 @@ namespace bufr {
             errStr << "No valid BUFR subsets were found from your queries! ";
             errStr << "Please make sure you are querying for valid subsets that exist in ";
             errStr << filePath_ << ". ";
+            if (querySet.filtersMessages())
+            {
+                errStr << "Also check that the time window and message types of the QuerySet ";
+                errStr << "match some of the messages. ";
+            }
+
             errStr << "Otherwise there might be a problem with the BUFR file (no subsets).";
             throw eckit::BadValue(errStr.str());
         }
@@ -97,25 +254,100 @@ namespace bufr {
         throw eckit::BadParameter(errStr.str());
       }
 
-      static int SubsetLen = 9;
-      char subsetChars[SubsetLen];
-      int iddate;
+      return getIndex()->messagesFor(querySet).size();
+    }
 
-      size_t numMsgs = 0;
-      while (ireadmg_f(FileUnit, subsetChars, &iddate, SubsetLen) == 0)
-      {
-        subset_ = std::string(subsetChars);
-        subset_.erase(std::remove_if(subset_.begin(), subset_.end(), isspace), subset_.end());
+    std::shared_ptr<MessageIndex> DataProvider::getIndex()
+    {
+        if (index_ != nullptr) return index_;
 
-        if (querySet.includesSubset(subset_))
+        if (!isOpen_)
         {
-          numMsgs++;
+            std::ostringstream errStr;
+            errStr << "Tried to call DataProvider::getIndex, but the file is not open!";
+            throw eckit::BadParameter(errStr.str());
         }
-      }
 
-      rewind();
+        if (auto cachedIndex = MessageIndexCache::load(filePath_, typeName(), tablePath()))
+        {
+            index_ = cachedIndex;
+            return index_;
+        }
+
+        auto lock = FortranUnits::lock();
+        activateTables();
+
+        auto index = std::make_shared<MessageIndex>(filePath_);
+
+        // NCEPLIB-bufr works out the subset of a message from its data category, subcategory and
+        // first section 3 descriptor. So we only need to read one message of each kind to label
+        // all of them. Table messages that come after the data starts can redefine things, so
+        // start over whenever we see one.
+        typedef std::tuple<int, int, int> MessageKey;
+        std::map<MessageKey, std::string> subsetMap;
+
+        bool foundDataMsg = false;
+        for (size_t msgIdx = 0; msgIdx < index->size(); ++msgIdx)
+        {
+            const auto& msg = (*index)[msgIdx];
+            if (msg.isDictionary())
+            {
+                if (foundDataMsg)
+                {
+                    loadMessage(*index, msgIdx);
+                    subsetMap.clear();
+                }
+
+                continue;
+            }
+
+            foundDataMsg = true;
+
+            const auto key = MessageKey(msg.dataCategory, msg.dataSubCategory, msg.tableDescriptor);
+            if (subsetMap.find(key) == subsetMap.end())
+            {
+                subsetMap[key] = loadMessage(*index, msgIdx);
+            }
+
+            index->setSubset(msgIdx, subsetMap[key]);
+        }
 
-      return numMsgs;
+        if (foundDataMsg) rewind();
+
+        MessageIndexCache::save(*index, typeName(), tablePath());
+
+        index_ = index;
+        return index_;
+    }
+
+    std::string DataProvider::loadMessage(const MessageIndex& index, size_t msgIdx)
+    {
+        index.read(msgIdx, msgBuffer_);
+        return loadMessageBuffer();
+    }
+
+    std::string DataProvider::loadMessage(const uint8_t* msg, size_t length)
+    {
+        msgBuffer_.resize((length + sizeof(int) - 1) / sizeof(int));
+        msgBuffer_.back() = 0;
+        std::memcpy(msgBuffer_.data(), msg, length);
+        return loadMessageBuffer();
+    }
+
+    std::string DataProvider::loadMessageBuffer()
+    {
+        static int SubsetLen = 9;
+        char subsetChars[SubsetLen];
+        int iddate;
+        int iret;
+
+        readerme_f(msgBuffer_.data(), fileUnit_, subsetChars, &iddate, SubsetLen, &iret);
+
+        if (iret != 0) return "";
+
+        auto subset = std::string(subsetChars);
+        subset.erase(std::remove_if(subset.begin(), subset.end(), isspace), subset.end());
+        return subset;
     }
 
     void DataProvider::updateData(int bufrLoc)
@@ -148,7 +380,9 @@ namespace bufr {
         int retVal;
         TypeInfo info;
 
-        nemdefs_f(FileUnit,
+        auto lock = FortranUnits::lock();
+
+        nemdefs_f(fileUnit_,
                   getTag(idx).c_str(),
                    unitCStr,
                    UNIT_STR_LEN,
@@ -197,7 +431,9 @@ namespace bufr {
         static int MaxLongStrLen = 120;
         char charPtr[MaxLongStrLen];
 
-        readlc_f(FileUnit, longStrId.c_str(), charPtr, MaxLongStrLen);
+        auto lock = FortranUnits::lock();
+
+        readlc_f(fileUnit_, longStrId.c_str(), charPtr, MaxLongStrLen);
 
         if (charPtr[0] == '\xff')
         {
@@ -0,0 +1,61 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "bufr/FortranUnits.h"
+
+#include <new>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    int FortranUnits::acquire()
+    {
+        auto guard = lock();
+        auto& units = instance().units_;
+
+        for (int unit = FirstUnit; unit <= LastUnit; ++unit)
+        {
+            if (units.find(unit) == units.end())
+            {
+                units.insert(unit);
+                return unit;
+            }
+        }
+
+        std::ostringstream errStr;
+        errStr << "Ran out of Fortran units for BUFR files (" << units.size() << " in use). ";
+        errStr << "Please close some of the open files.";
+        throw eckit::BadValue(errStr.str());
+    }
+
+    void FortranUnits::release(int unit)
+    {
+        auto guard = lock();
+        instance().units_.erase(unit);
+    }
+
+    size_t FortranUnits::numAcquired()
+    {
+        auto guard = lock();
+        return instance().units_.size();
+    }
+
+    void FortranUnits::afterFork()
+    {
+        // The old mutex can't be unlocked from here (its owner is a thread of the parent).
+        new (&instance().mutex_) std::recursive_mutex();
+    }
+
+    size_t FortranUnits::tableGeneration()
+    {
+        auto guard = lock();
+        return instance().tableGeneration_;
+    }
+
+    void FortranUnits::tablesChanged()
+    {
+        auto guard = lock();
+        instance().tableGeneration_++;
+    }
+}  // namespace bufr
@@ -13,18 +13,32 @@ namespace bufr {
     {
     }
 
+    NcepDataProvider::~NcepDataProvider()
+    {
+        if (isOpen_) close();
+    }
+
     void NcepDataProvider::open()
     {
-        open_f(FileUnit, filePath_.c_str());
-        openbf_f(FileUnit, "IN", FileUnit);
+        auto lock = FortranUnits::lock();
+
+        fileUnit_ = FortranUnits::acquire();
+        open_f(fileUnit_, filePath_.c_str());
+        openbf_f(fileUnit_, "IN", fileUnit_);
+        FortranUnits::tablesChanged();
 
         isOpen_ = true;
     }
 
     void NcepDataProvider::close()
     {
-      closbf_f(FileUnit);
-      close_f(FileUnit);
+      auto lock = FortranUnits::lock();
+
+      closbf_f(fileUnit_);
+      close_f(fileUnit_);
+      FortranUnits::release(fileUnit_);
+      FortranUnits::tablesChanged();
+
       isOpen_ = false;
       currentTableData_ = nullptr;
     }
@@ -36,8 +50,11 @@ namespace bufr {
         int strLen = 0;
         char *charPtr = nullptr;
 
-        if (currentTableData_ == nullptr)
+        // The tables are shared with any other open files, so they have to be copied again if
+        // one of them was opened or closed.
+        if (currentTableData_ == nullptr || tableGeneration_ != FortranUnits::tableGeneration())
         {
+            tableGeneration_ = FortranUnits::tableGeneration();
             currentTableData_ = std::make_shared<TableData>();
 
             get_isc_f(&intPtr, &size);
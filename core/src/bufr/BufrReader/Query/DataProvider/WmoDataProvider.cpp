@@ -21,22 +21,47 @@ namespace bufr {
     {
     }
 
+    WmoDataProvider::~WmoDataProvider()
+    {
+        if (isOpen_) close();
+    }
+
     void WmoDataProvider::open()
     {
-        open_f(FileUnit, filePath_.c_str());
-        openbf_f(FileUnit, "SEC3", FileUnit);
-        mtinfo_f(tableFilePath_.c_str(), FileUnitTable1, FileUnitTable2);
+        auto lock = FortranUnits::lock();
+
+        fileUnit_ = FortranUnits::acquire();
+        tableUnit1_ = FortranUnits::acquire();
+        tableUnit2_ = FortranUnits::acquire();
+
+        open_f(fileUnit_, filePath_.c_str());
+        openbf_f(fileUnit_, "SEC3", fileUnit_);
+        activateTables();
+        FortranUnits::tablesChanged();
 
         isOpen_ = true;
     }
 
     void WmoDataProvider::close()
     {
-        closbf_f(FileUnit);
-        close_f(FileUnit);
+        auto lock = FortranUnits::lock();
+
+        closbf_f(fileUnit_);
+        close_f(fileUnit_);
+        FortranUnits::release(fileUnit_);
+        FortranUnits::release(tableUnit1_);
+        FortranUnits::release(tableUnit2_);
+        FortranUnits::tablesChanged();
+
         isOpen_ = false;
     }
 
+    void WmoDataProvider::activateTables()
+    {
+        // The master table location is a global NCEPLIB-bufr setting.
+        mtinfo_f(tableFilePath_.c_str(), tableUnit1_, tableUnit2_);
+    }
+
     void WmoDataProvider::updateTableData(const std::string& subset)
     {
         deleteData();
@@ -54,6 +79,14 @@ namespace bufr {
         get_tag_f(&tagData.ptr, &tagData.strLen, &tagData.size);
         tagData.tagStr = std::string(&tagData.ptr[0], tagData.size * tagData.strLen);
 
+        // The tables are shared with any other open files, so anything cached from before one of
+        // them was opened or closed may point at the wrong nodes.
+        if (tableGeneration_ != FortranUnits::tableGeneration())
+        {
+            tableGeneration_ = FortranUnits::tableGeneration();
+            tableCache_.clear();
+        }
+
         std::shared_ptr<TableData> tableData;
         if (tableCache_.find(tagData.tagStr) == tableCache_.end())
         {
@@ -94,12 +127,26 @@ namespace bufr {
             get_irf_f(&intPtr, &size);
             tableData->irf = std::vector<int>(intPtr, intPtr + size);
 
-            if (variantCount_.find(subset) == variantCount_.end())
+            // The variant is identified by the tags of the subset itself (the rest of the table
+            // belongs to the other open files), so it survives the table being rebuilt.
+            std::string subsetTags;
+            for (int nodeIdx = inode_; nodeIdx <= tableData->isc[inode_ - 1]; nodeIdx++)
             {
-                variantCount_.insert({subset, 0});
+                subsetTags += tableData->tag[nodeIdx - 1] + " ";
             }
-            variantCount_.at(subset) += 1;
-            tableData->varientNumber = variantCount_.at(subset);
+
+            auto variantKey = subset + ":" + subsetTags;
+            if (variantIds_.find(variantKey) == variantIds_.end())
+            {
+                if (variantCount_.find(subset) == variantCount_.end())
+                {
+                    variantCount_.insert({subset, 0});
+                }
+                variantCount_.at(subset) += 1;
+                variantIds_[variantKey] = variantCount_.at(subset);
+            }
+
+            tableData->varientNumber = variantIds_.at(variantKey);
 
             tableCache_[tagData.tagStr] = tableData;
         }
@@ -0,0 +1,37 @@
+
+module message_reader_c_interface_mod
+
+  use iso_c_binding
+
+  implicit none
+
+  private
+  public:: readerme_c
+
+contains
+
+  subroutine readerme_c(mesg, bufr_unit, c_subset, jdate, subset_str_len, iret) &
+                        bind(C, name='readerme_f')
+
+    integer(c_int),                intent(in)    :: mesg(*)
+    integer(c_int), value,         intent(in)    :: bufr_unit
+    character(kind=c_char, len=1), intent(inout) :: c_subset(*)
+    integer(c_int),                intent(out)   :: jdate
+    integer(c_int), value,         intent(in)    :: subset_str_len
+    integer(c_int),                intent(out)   :: iret
+
+    character(len=8) :: f_subset
+    integer :: idx, str_len
+
+    f_subset = ' '
+    call readerme(mesg, bufr_unit, f_subset, jdate, iret)
+
+    str_len = min(len(f_subset), subset_str_len - 1)
+    do idx = 1, str_len
+      c_subset(idx) = f_subset(idx:idx)
+    end do
+    c_subset(str_len + 1) = c_null_char
+
+  end subroutine readerme_c
+
+end module message_reader_c_interface_mod
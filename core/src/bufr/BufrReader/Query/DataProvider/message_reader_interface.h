@@ -0,0 +1,20 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+/** @file
+    @brief Define signature to enable NCEPLIB-bufr's readerme (read a BUFR message from a
+    memory buffer) to be called via wrapper functions from C and C++ application programs.
+
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  void readerme_f(const int* mesg, int bufr_unit, char* subset, int* jdate, int subset_str_len,
+                  int* iret);
+
+#ifdef __cplusplus
+}
+#endif
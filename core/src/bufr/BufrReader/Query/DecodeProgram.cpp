@@ -0,0 +1,658 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "DecodeProgram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    namespace
+    {
+        const uint32_t MaxNumberBits = 64;
+        const uint32_t MaxCharBits = 64;
+        const double RelativeTolerance = 1.0e-10;
+        const uint32_t IncrementWidthBits = 6;  // Compressed data, width of the increments
+
+        /// \brief Number of bits used for the replication count of a delayed replication node.
+        ///        NCEPLIB-bufr marks the kind of replication with the brackets around the tag.
+        /// \return The number of bits (0 if unknown).
+        uint32_t countBits(const std::string& tag)
+        {
+            if (tag.find("16BIT") != std::string::npos) return 16;
+            if (tag.find("8BIT") != std::string::npos) return 8;
+            if (tag.find("1BIT") != std::string::npos) return 1;
+
+            if (tag.empty()) return 0;
+
+            switch (tag[0])
+            {
+                case '{': return 8;
+                case '(': return 16;
+                case '[': return 8;
+                case '<': return 1;
+                default: return 0;
+            }
+        }
+
+        /// \brief 10^-scale computed the way NCEPLIB-bufr does it (integer powers of 10).
+        double scaleFactor(int scale)
+        {
+            double power = 1.0;
+            for (int idx = 0; idx < std::abs(scale); ++idx)
+            {
+                power *= 10.0;
+            }
+
+            return (scale >= 0) ? 1.0 / power : power;
+        }
+
+        /// \brief Collects everything a trace program emits.
+        struct TraceSink
+        {
+            std::vector<size_t> nodes;
+            std::vector<double> values;
+
+            void count(size_t nodeId, int count)
+            {
+                nodes.push_back(nodeId);
+                values.push_back(static_cast<double>(count));
+            }
+
+            void value(size_t nodeId, double value)
+            {
+                nodes.push_back(nodeId);
+                values.push_back(value);
+            }
+        };
+
+        /// \brief Compare the elements NCEPLIB-bufr read for the current subset with the ones
+        ///        that were traced.
+        bool compareTrace(const DataProvider& dataProvider,
+                          const std::unordered_set<size_t>& longStrNodes,
+                          const TraceSink& sink)
+        {
+            size_t traceIdx = 0;
+            for (size_t cursor = 1; cursor <= static_cast<size_t>(dataProvider.getNVal()); ++cursor)
+            {
+                const auto nodeId = static_cast<size_t>(dataProvider.getInv(cursor));
+                const auto typ = dataProvider.getTyp(nodeId);
+
+                // Only the elements and delayed replication counts come from the data section.
+                if (typ != Typ::Number && typ != Typ::Character && typ != Typ::DelayedRep &&
+                    typ != Typ::DelayedRepStacked && typ != Typ::DelayedBinary)
+                {
+                    continue;
+                }
+
+                if (longStrNodes.find(nodeId) != longStrNodes.end()) continue;
+
+                if (traceIdx >= sink.nodes.size() || sink.nodes[traceIdx] != nodeId) return false;
+
+                const double expected = dataProvider.getVal(cursor);
+                const double actual = sink.values[traceIdx];
+                if (typ == Typ::Character)
+                {
+                    if (std::memcmp(&expected, &actual, sizeof(double)) != 0) return false;
+                }
+                else if (std::fabs(expected - actual) >
+                         RelativeTolerance * std::fmax(std::fabs(expected), std::fabs(actual)))
+                {
+                    return false;
+                }
+
+                ++traceIdx;
+            }
+
+            return traceIdx == sink.nodes.size();
+        }
+    }  // namespace
+
+    std::shared_ptr<DecodeProgram> DecodeProgram::compile(const std::shared_ptr<BufrNode>& root,
+                                                          size_t lastNodeId,
+                                                          const Targets& targets,
+                                                          bool compressed)
+    {
+        std::unordered_set<size_t> dataNodes;
+        std::unordered_set<size_t> countNodes;
+        for (const auto& target : targets)
+        {
+            if (target->nodeIdx == 0) continue;
+
+            dataNodes.insert(target->nodeIdx);
+            for (const auto& component : target->path)
+            {
+                if (component.isContainer()) countNodes.insert(component.nodeId);
+            }
+        }
+
+        auto program = std::shared_ptr<DecodeProgram>(new DecodeProgram());
+        program->firstNodeId_ = root->nodeIdx;
+        program->lastNodeId_ = lastNodeId;
+        program->isCompressed_ = compressed;
+        program->emitSubsetCount_ = countNodes.find(root->nodeIdx) != countNodes.end();
+
+        for (const auto& child : root->children)
+        {
+            if (!program->compileNode(child, dataNodes, countNodes, false)) return nullptr;
+        }
+
+        return program;
+    }
+
+    std::shared_ptr<DecodeProgram>
+    DecodeProgram::compileTrace(const std::shared_ptr<BufrNode>& root,
+                                size_t lastNodeId,
+                                bool compressed)
+    {
+        auto program = std::shared_ptr<DecodeProgram>(new DecodeProgram());
+        program->firstNodeId_ = root->nodeIdx;
+        program->lastNodeId_ = lastNodeId;
+        program->isCompressed_ = compressed;
+
+        for (const auto& child : root->children)
+        {
+            if (!program->compileNode(child, {}, {}, true)) return nullptr;
+        }
+
+        return program;
+    }
+
+    bool DecodeProgram::matches(const DataProvider& dataProvider, BitReader& reader) const
+    {
+        TraceSink sink;
+        if (!run(reader, sink)) return false;
+
+        return compareTrace(dataProvider, longStrNodes_, sink);
+    }
+
+    bool DecodeProgram::matches(const DataProvider& dataProvider,
+                                const MessageColumns& columns) const
+    {
+        if (columns.numColumns == 0) return false;
+
+        TraceSink sink;
+        for (const auto& entry : columns.entries)
+        {
+            if (entry.isCount)
+            {
+                sink.count(entry.nodeId, entry.count);
+            }
+            else
+            {
+                sink.value(entry.nodeId, columns.values[entry.valuesIdx]);
+            }
+        }
+
+        return compareTrace(dataProvider, longStrNodes_, sink);
+    }
+
+    void DecodeProgram::serialize(BufferWriter& writer) const
+    {
+        writer.value<uint64_t>(firstNodeId_);
+        writer.value<uint64_t>(lastNodeId_);
+        writer.value<uint8_t>(emitSubsetCount_ ? 1 : 0);
+        writer.value<uint8_t>(isCompressed_ ? 1 : 0);
+
+        writer.value<uint64_t>(longStrNodes_.size());
+        for (const auto nodeId : longStrNodes_)
+        {
+            writer.value<uint64_t>(nodeId);
+        }
+
+        writer.value<uint64_t>(ops_.size());
+        for (const auto& op : ops_)
+        {
+            writer.value<uint8_t>(static_cast<uint8_t>(op.code));
+            writer.value<uint8_t>(op.emit ? 1 : 0);
+            writer.value<uint8_t>(op.skipBody ? 1 : 0);
+            writer.value<uint32_t>(op.nodeId);
+            writer.value<uint32_t>(op.bits);
+            writer.value<uint32_t>(op.count);
+            writer.value<int64_t>(op.reference);
+            writer.value<double>(op.factor);
+            writer.value<uint64_t>(op.jump);
+            writer.value<uint64_t>(op.bodyBits);
+        }
+    }
+
+    std::shared_ptr<DecodeProgram> DecodeProgram::deserialize(BufferReader& reader)
+    {
+        auto program = std::shared_ptr<DecodeProgram>(new DecodeProgram());
+        program->firstNodeId_ = reader.value<uint64_t>();
+        program->lastNodeId_ = reader.value<uint64_t>();
+        program->emitSubsetCount_ = reader.value<uint8_t>() != 0;
+        program->isCompressed_ = reader.value<uint8_t>() != 0;
+
+        const auto numLongStrNodes = reader.value<uint64_t>();
+        for (size_t nodeIdx = 0; nodeIdx < numLongStrNodes; ++nodeIdx)
+        {
+            program->longStrNodes_.insert(reader.value<uint64_t>());
+        }
+
+        const auto numOps = reader.value<uint64_t>();
+        for (size_t opIdx = 0; opIdx < numOps; ++opIdx)
+        {
+            DecodeOp op;
+            op.code = static_cast<DecodeOp::Code>(reader.value<uint8_t>());
+            op.emit = reader.value<uint8_t>() != 0;
+            op.skipBody = reader.value<uint8_t>() != 0;
+            op.nodeId = reader.value<uint32_t>();
+            op.bits = reader.value<uint32_t>();
+            op.count = reader.value<uint32_t>();
+            op.reference = reader.value<int64_t>();
+            op.factor = reader.value<double>();
+            op.jump = reader.value<uint64_t>();
+            op.bodyBits = reader.value<uint64_t>();
+
+            // The jumps have to stay inside the program (run relies on it).
+            if ((op.code == DecodeOp::Code::Repeat || op.code == DecodeOp::Code::EndRepeat) &&
+                op.jump >= numOps)
+            {
+                std::ostringstream errStr;
+                errStr << "Serialized decode program is corrupt.";
+                throw eckit::BadValue(errStr.str());
+            }
+
+            program->ops_.push_back(op);
+        }
+
+        return program;
+    }
+
+    bool DecodeProgram::runCompressed(BitReader& reader,
+                                      size_t numSubsets,
+                                      size_t numColumns,
+                                      MessageColumns& columns) const
+    {
+        struct Loop
+        {
+            size_t start;
+            uint64_t remaining;
+        };
+
+        Loop loops[32];
+        size_t depth = 0;
+
+        numColumns = std::min(numColumns, numSubsets);
+        columns.clear();
+        columns.numColumns = numColumns;
+
+        if (emitSubsetCount_) columns.entries.push_back({firstNodeId_, true, 1, 0});
+
+        const size_t numOps = ops_.size();
+        size_t pc = 0;
+        while (pc < numOps)
+        {
+            const auto& op = ops_[pc];
+            switch (op.code)
+            {
+                case DecodeOp::Code::Skip:
+                {
+                    // Never generated for compressed data (elements don't have a fixed width).
+                    return false;
+                }
+                case DecodeOp::Code::Number:
+                case DecodeOp::Code::Chars:
+                {
+                    const bool isChars = (op.code == DecodeOp::Code::Chars);
+
+                    // The reference value for the element is followed by the width of the
+                    // increments (in bytes for characters).
+                    const size_t refPos = reader.position();
+                    const uint64_t ref = isChars ? 0 : reader.read(op.bits);
+                    if (isChars) reader.skip(op.bits);
+
+                    const auto incBits = static_cast<uint32_t>(reader.read(IncrementWidthBits)) *
+                                         (isChars ? 8 : 1);
+
+                    if (!reader.ok()) return false;
+
+                    if (!op.emit)
+                    {
+                        reader.skip(incBits * numSubsets);
+                        ++pc;
+                        break;
+                    }
+
+                    if ((isChars && incBits != 0 && incBits != op.bits) ||
+                        (!isChars && incBits > MaxNumberBits))
+                    {
+                        return false;
+                    }
+
+                    const size_t valuesIdx = columns.values.size();
+                    columns.entries.push_back({op.nodeId, false, 0, valuesIdx});
+                    columns.values.resize(valuesIdx + numColumns);
+                    double* column = columns.values.data() + valuesIdx;
+
+                    if (isChars)
+                    {
+                        // Characters are stored in the bytes of a double (blank padded)
+                        auto readChars = [&reader, &op]()
+                        {
+                            char chars[8] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+                            for (size_t charIdx = 0; charIdx < op.bits / 8; ++charIdx)
+                            {
+                                chars[charIdx] = static_cast<char>(reader.read(8));
+                            }
+
+                            double value;
+                            std::memcpy(&value, chars, sizeof(double));
+                            return value;
+                        };
+
+                        if (incBits == 0)
+                        {
+                            const size_t endPos = reader.position();
+                            reader.seek(refPos);
+                            std::fill(column, column + numColumns, readChars());
+                            reader.seek(endPos);
+                        }
+                        else
+                        {
+                            for (size_t subsetIdx = 0; subsetIdx < numColumns; ++subsetIdx)
+                            {
+                                column[subsetIdx] = readChars();
+                            }
+
+                            reader.skip(incBits * (numSubsets - numColumns));
+                        }
+                    }
+                    else
+                    {
+                        const uint64_t allOnes = (op.bits >= 64) ?
+                            ~uint64_t(0) : ((uint64_t(1) << op.bits) - 1);
+
+                        if (incBits == 0)
+                        {
+                            const double value = (ref == allOnes) ? MissingOctetValue :
+                                static_cast<double>(static_cast<int64_t>(ref) + op.reference)
+                                    * op.factor;
+
+                            std::fill(column, column + numColumns, value);
+                        }
+                        else
+                        {
+                            const uint64_t incMissing = (incBits >= 64) ?
+                                ~uint64_t(0) : ((uint64_t(1) << incBits) - 1);
+
+                            const int64_t base = static_cast<int64_t>(ref) + op.reference;
+                            for (size_t subsetIdx = 0; subsetIdx < numColumns; ++subsetIdx)
+                            {
+                                const uint64_t inc = reader.read(incBits);
+                                column[subsetIdx] = (inc == incMissing) ? MissingOctetValue :
+                                    static_cast<double>(base + static_cast<int64_t>(inc))
+                                        * op.factor;
+                            }
+
+                            reader.skip(incBits * (numSubsets - numColumns));
+                        }
+                    }
+
+                    ++pc;
+                    break;
+                }
+                case DecodeOp::Code::Repeat:
+                {
+                    uint64_t count = op.count;
+                    if (op.bits > 0)
+                    {
+                        // Delayed replication counts have to be the same for all the subsets.
+                        count = reader.read(op.bits);
+                        const auto incBits = static_cast<uint32_t>(reader.read(IncrementWidthBits));
+                        for (size_t subsetIdx = 0; subsetIdx < numSubsets && incBits > 0;
+                             ++subsetIdx)
+                        {
+                            if (reader.read(incBits) != 0) return false;
+                        }
+                    }
+
+                    if (!reader.ok()) return false;
+
+                    if (op.emit)
+                    {
+                        columns.entries.push_back({op.nodeId, true, static_cast<int>(count), 0});
+                    }
+
+                    if (count == 0)
+                    {
+                        pc = op.jump + 1;
+                    }
+                    else
+                    {
+                        if (depth == sizeof(loops) / sizeof(Loop)) return false;
+                        loops[depth++] = {pc, count};
+                        ++pc;
+                    }
+
+                    break;
+                }
+                case DecodeOp::Code::EndRepeat:
+                {
+                    auto& loop = loops[depth - 1];
+                    if (--loop.remaining > 0)
+                    {
+                        pc = loop.start + 1;
+                    }
+                    else
+                    {
+                        --depth;
+                        ++pc;
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return reader.ok();
+    }
+
+    bool DecodeProgram::compileNode(const std::shared_ptr<BufrNode>& node,
+                                    const std::unordered_set<size_t>& dataNodes,
+                                    const std::unordered_set<size_t>& countNodes,
+                                    bool traceAll)
+    {
+        switch (node->type)
+        {
+            case Typ::Number:
+            case Typ::Character:
+            {
+                const bool isNeeded = dataNodes.find(node->nodeIdx) != dataNodes.end();
+                const auto bits = static_cast<uint32_t>(node->typeInfo.bits);
+                if (node->typeInfo.bits <= 0) return false;
+
+                if (node->type == Typ::Character)
+                {
+                    if (bits % 8 != 0) return false;
+
+                    if (bits > MaxCharBits)
+                    {
+                        // Long strings are read with readlc, so they can only be skipped.
+                        if (isNeeded) return false;
+                        if (traceAll) longStrNodes_.insert(node->nodeIdx);
+
+                        addUnused(DecodeOp::Code::Chars, node->nodeIdx, bits);
+                        return true;
+                    }
+                }
+                else if (bits > MaxNumberBits)
+                {
+                    return false;
+                }
+
+                if (!isNeeded && !traceAll)
+                {
+                    addUnused((node->type == Typ::Number) ? DecodeOp::Code::Number :
+                                                            DecodeOp::Code::Chars,
+                              node->nodeIdx,
+                              bits);
+                    return true;
+                }
+
+                DecodeOp op;
+                op.code = (node->type == Typ::Number) ? DecodeOp::Code::Number :
+                                                        DecodeOp::Code::Chars;
+                op.emit = true;
+                op.nodeId = static_cast<uint32_t>(node->nodeIdx);
+                op.bits = bits;
+                op.reference = node->typeInfo.reference;
+                op.factor = scaleFactor(node->typeInfo.scale);
+                ops_.push_back(op);
+                return true;
+            }
+            case Typ::DelayedRep:
+            case Typ::DelayedRepStacked:
+            case Typ::DelayedBinary:
+            case Typ::FixedRep:
+            {
+                DecodeOp op;
+                op.code = DecodeOp::Code::Repeat;
+                op.nodeId = static_cast<uint32_t>(node->nodeIdx);
+
+                const bool isCounted = countNodes.find(node->nodeIdx) != countNodes.end();
+                if (node->type == Typ::FixedRep)
+                {
+                    // The counts for fixed replications come from the subset table, which only
+                    // knows them when they are more than 1.
+                    if (isCounted && node->fixedRepCount <= 1) return false;
+
+                    op.count = static_cast<uint32_t>(node->fixedRepCount);
+                    op.emit = isCounted;
+                }
+                else
+                {
+                    op.bits = countBits(node->mnemonic);
+                    if (op.bits == 0) return false;
+
+                    op.emit = isCounted || traceAll;
+                }
+
+                const size_t repeatIdx = ops_.size();
+                ops_.push_back(op);
+
+                for (const auto& child : node->children)
+                {
+                    if (!compileNode(child, dataNodes, countNodes, traceAll)) return false;
+                }
+
+                size_t bodyBits = 0;
+                if (isSkippable(repeatIdx + 1, ops_.size(), bodyBits))
+                {
+                    ops_.resize(repeatIdx + 1);
+
+                    if (node->type == Typ::FixedRep && !op.emit)
+                    {
+                        // Nothing to collect and the size is known, so it is just a skip.
+                        ops_.pop_back();
+                        addSkip(bodyBits * op.count);
+                        return true;
+                    }
+
+                    ops_[repeatIdx].skipBody = true;
+                    ops_[repeatIdx].bodyBits = bodyBits;
+                }
+
+                DecodeOp endOp;
+                endOp.code = DecodeOp::Code::EndRepeat;
+                endOp.nodeId = op.nodeId;
+                endOp.jump = repeatIdx;
+                ops_[repeatIdx].jump = ops_.size();
+                ops_.push_back(endOp);
+                return true;
+            }
+            case Typ::Subset:
+            case Typ::Sequence:
+            case Typ::Repeat:
+            case Typ::StackedRepeat:
+            {
+                for (const auto& child : node->children)
+                {
+                    if (!compileNode(child, dataNodes, countNodes, traceAll)) return false;
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void DecodeProgram::addSkip(size_t bits)
+    {
+        if (bits == 0) return;
+
+        if (!ops_.empty() && ops_.back().code == DecodeOp::Code::Skip)
+        {
+            ops_.back().bits += static_cast<uint32_t>(bits);
+            return;
+        }
+
+        DecodeOp op;
+        op.code = DecodeOp::Code::Skip;
+        op.bits = static_cast<uint32_t>(bits);
+        ops_.push_back(op);
+    }
+
+    void DecodeProgram::addUnused(DecodeOp::Code code, size_t nodeId, size_t bits)
+    {
+        if (!isCompressed_)
+        {
+            addSkip(bits);
+            return;
+        }
+
+        DecodeOp op;
+        op.code = code;
+        op.nodeId = static_cast<uint32_t>(nodeId);
+        op.bits = static_cast<uint32_t>(bits);
+        ops_.push_back(op);
+    }
+
+    bool DecodeProgram::isSkippable(size_t begin, size_t end, size_t& numBits) const
+    {
+        numBits = 0;
+
+        // The width of compressed elements depends on the data.
+        if (isCompressed_) return false;
+        for (size_t opIdx = begin; opIdx < end; ++opIdx)
+        {
+            const auto& op = ops_[opIdx];
+            if (op.emit) return false;
+
+            switch (op.code)
+            {
+                case DecodeOp::Code::Skip:
+                case DecodeOp::Code::Number:
+                case DecodeOp::Code::Chars:
+                {
+                    numBits += op.bits;
+                    break;
+                }
+                case DecodeOp::Code::Repeat:
+                {
+                    // Delayed replications have a size that changes from subset to subset.
+                    if (op.bits > 0) return false;
+
+                    size_t innerBits = 0;
+                    if (!op.skipBody && !isSkippable(opIdx + 1, op.jump, innerBits)) return false;
+                    if (op.skipBody) innerBits = op.bodyBits;
+
+                    numBits += op.count * innerBits;
+                    opIdx = op.jump;
+                    break;
+                }
+                case DecodeOp::Code::EndRepeat:
+                {
+                    break;
+                }
+            }
+        }
+
+        return true;
+    }
+}  // namespace bufr
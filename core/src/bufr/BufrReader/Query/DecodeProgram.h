@@ -0,0 +1,313 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "bufr/Data.h"
+#include "bufr/MessageReader.h"
+#include "bufr/SubsetTable.h"
+#include "BitReader.h"
+#include "Serialization.h"
+#include "Target.h"
+
+
+namespace bufr {
+
+    /// \brief A single instruction in a DecodeProgram.
+    struct DecodeOp
+    {
+        enum class Code : uint8_t
+        {
+            Skip,       // Skip over "bits" bits (data nobody asked for)
+            Number,     // Numeric element
+            Chars,      // Character element (up to 8 characters)
+            Repeat,     // Start of a replicated block (count is fixed or read with "bits" bits)
+            EndRepeat   // End of a replicated block
+        };
+
+        Code code;
+        bool emit = false;           // Pass the value (or count) on to the sink?
+        bool skipBody = false;       // Repeat: the body is fixed width and has nothing to emit
+        uint32_t nodeId = 0;
+        uint32_t bits = 0;
+        uint32_t count = 0;          // Repeat: the fixed repeat count (when bits == 0)
+        int64_t reference = 0;
+        double factor = 1.0;         // 10^-scale
+        size_t jump = 0;             // Repeat: idx of the EndRepeat. EndRepeat: idx of the Repeat
+        size_t bodyBits = 0;         // Repeat: width of one repetition of the body (if skipBody)
+    };
+
+    /// \brief How the subsets of an uncompressed message are laid out in section 4.
+    enum class SubsetLayout
+    {
+        ByteCounted,  // Each subset starts with a 16 bit byte count and is padded (NCEP)
+        Packed        // The subsets follow each other directly (WMO standard)
+    };
+
+    /// \brief The data of a compressed message decoded element by element (a column of values
+    ///        per element, with one value per subset).
+    struct MessageColumns
+    {
+        struct Entry
+        {
+            size_t nodeId;
+            bool isCount;       // Replication count (the same for every subset)
+            int count;
+            size_t valuesIdx;   // Start of the column in values
+        };
+
+        size_t numColumns = 0;  // Number of subsets that were collected
+        std::vector<Entry> entries;
+        std::vector<double> values;
+
+        void clear()
+        {
+            entries.clear();
+            values.clear();
+        }
+    };
+
+    /// \brief A flat list of instructions that decodes one subset of a specific SubsetVariant
+    ///        straight from the section 4 bits. Elements that are not part of the query are
+    ///        merged into Skip instructions, so they only move the bit position forward.
+    ///
+    /// \par The program only knows what the subset table says about each element (Table B bit
+    ///      widths, scales and references). Things that NCEPLIB-bufr applies on top of that
+    ///      (operator descriptors for example) are not modeled, so a program has to be checked
+    ///      against what NCEPLIB-bufr decodes (see matches) before it is trusted.
+    ///
+    /// \par Compressed messages store each element for all the subsets together (a reference
+    ///      value followed by an increment per subset), so the elements don't have a fixed
+    ///      width. Programs compiled for compressed data keep an instruction per element and
+    ///      are run with runCompressed.
+    class DecodeProgram
+    {
+     public:
+        /// \brief Compile the program that collects the data for the targets.
+        /// \param root The root node of the SubsetTable.
+        /// \param lastNodeId The id of the last table node in the subset.
+        /// \param targets The targets of the query.
+        /// \param compressed Compile the program for compressed messages.
+        /// \return The program, or nullptr if the subset uses features that can't be decoded.
+        static std::shared_ptr<DecodeProgram> compile(const std::shared_ptr<BufrNode>& root,
+                                                      size_t lastNodeId,
+                                                      const Targets& targets,
+                                                      bool compressed = false);
+
+        /// \brief Compile the program that emits every value in the subset (used to check the
+        ///        decoding against NCEPLIB-bufr).
+        /// \param root The root node of the SubsetTable.
+        /// \param lastNodeId The id of the last table node in the subset.
+        /// \param compressed Compile the program for compressed messages.
+        /// \return The program, or nullptr if the subset uses features that can't be decoded.
+        static std::shared_ptr<DecodeProgram> compileTrace(const std::shared_ptr<BufrNode>& root,
+                                                           size_t lastNodeId,
+                                                           bool compressed = false);
+
+        /// \brief Id of the first (subset) table node.
+        size_t firstNodeId() const { return firstNodeId_; }
+
+        /// \brief Id of the last table node in the subset.
+        size_t lastNodeId() const { return lastNodeId_; }
+
+        /// \brief Was the program compiled for compressed messages?
+        bool isCompressed() const { return isCompressed_; }
+
+        /// \brief Decode one subset. The sink needs the methods count(nodeId, count) and
+        ///        value(nodeId, value).
+        /// \param reader Reader positioned at the start of the subset data.
+        /// \param sink Receives the counts and values.
+        /// \return False if the data ran out before the end of the subset.
+        template<typename Sink>
+        bool run(BitReader& reader, Sink& sink) const;
+
+        /// \brief Check that the program decodes the subset NCEPLIB-bufr has loaded in the
+        ///        DataProvider exactly like NCEPLIB-bufr did. Only valid for trace programs.
+        /// \param dataProvider The DataProvider with the current subset loaded.
+        /// \param reader Reader positioned at the start of the subset data.
+        /// \return True if every element matches.
+        bool matches(const DataProvider& dataProvider, BitReader& reader) const;
+
+        /// \brief Decode the data section of a compressed message, one element at a time for
+        ///        all the subsets. Only valid for programs compiled for compressed messages.
+        /// \param reader Reader positioned at the start of the section 4 data.
+        /// \param numSubsets The number of subsets in the message.
+        /// \param numColumns The number of subsets to collect values for (starting with the
+        ///                   first one). The increments for the others are skipped.
+        /// \param[out] columns The decoded counts and values.
+        /// \return False if the data ran out or isn't laid out like the program expects.
+        bool runCompressed(BitReader& reader,
+                           size_t numSubsets,
+                           size_t numColumns,
+                           MessageColumns& columns) const;
+
+        /// \brief Check that the first subset of the decoded columns matches the subset
+        ///        NCEPLIB-bufr has loaded in the DataProvider. Only valid for trace programs.
+        /// \param dataProvider The DataProvider with the first subset loaded.
+        /// \param columns The columns decoded with runCompressed.
+        /// \return True if every element matches.
+        bool matches(const DataProvider& dataProvider, const MessageColumns& columns) const;
+
+        /// \brief Write the program (see TargetsCache).
+        void serialize(BufferWriter& writer) const;
+
+        /// \brief Read a program written with serialize.
+        static std::shared_ptr<DecodeProgram> deserialize(BufferReader& reader);
+
+     private:
+        std::vector<DecodeOp> ops_;
+        size_t firstNodeId_ = 0;
+        size_t lastNodeId_ = 0;
+        bool emitSubsetCount_ = false;
+        bool isCompressed_ = false;
+
+        // Character elements that are too long to decode (only skipped in trace programs)
+        std::unordered_set<size_t> longStrNodes_;
+
+        DecodeProgram() = default;
+
+        /// \brief Recursively add the instructions for a node.
+        /// \return False if the node can't be decoded.
+        bool compileNode(const std::shared_ptr<BufrNode>& node,
+                         const std::unordered_set<size_t>& dataNodes,
+                         const std::unordered_set<size_t>& countNodes,
+                         bool traceAll);
+
+        /// \brief Add a skip instruction (merging it with the previous one if possible).
+        void addSkip(size_t bits);
+
+        /// \brief Add the instruction for an element whose value isn't needed.
+        void addUnused(DecodeOp::Code code, size_t nodeId, size_t bits);
+
+        /// \brief Work out if the instructions in a range emit anything and how many bits they
+        ///        take up.
+        /// \param[out] numBits The number of bits (only valid if the width is fixed).
+        /// \return True if the range is fixed width and emits nothing.
+        bool isSkippable(size_t begin, size_t end, size_t& numBits) const;
+    };
+
+    /// \brief The compiled programs for a subset variant (nullptr if it can't be decoded).
+    struct DecodePrograms
+    {
+        std::shared_ptr<DecodeProgram> program;  // Collects the data for the targets
+        std::shared_ptr<DecodeProgram> trace;  // Emits everything (to check the decoding)
+        std::shared_ptr<DecodeProgram> compressedProgram;  // Same for compressed messages
+        std::shared_ptr<DecodeProgram> compressedTrace;
+    };
+
+    template<typename Sink>
+    bool DecodeProgram::run(BitReader& reader, Sink& sink) const
+    {
+        struct Loop
+        {
+            size_t start;
+            uint64_t remaining;
+        };
+
+        // Replications can be nested but not very deeply.
+        Loop loops[32];
+        size_t depth = 0;
+
+        if (emitSubsetCount_) sink.count(firstNodeId_, 1);
+
+        const size_t numOps = ops_.size();
+        size_t pc = 0;
+        while (pc < numOps)
+        {
+            const auto& op = ops_[pc];
+            switch (op.code)
+            {
+                case DecodeOp::Code::Skip:
+                {
+                    reader.skip(op.bits);
+                    ++pc;
+                    break;
+                }
+                case DecodeOp::Code::Number:
+                {
+                    const uint64_t raw = reader.read(op.bits);
+                    if (op.emit)
+                    {
+                        const uint64_t allOnes = (op.bits >= 64) ?
+                            ~uint64_t(0) : ((uint64_t(1) << op.bits) - 1);
+
+                        sink.value(op.nodeId,
+                                   (raw == allOnes) ? MissingOctetValue :
+                                   static_cast<double>(static_cast<int64_t>(raw) + op.reference)
+                                       * op.factor);
+                    }
+
+                    ++pc;
+                    break;
+                }
+                case DecodeOp::Code::Chars:
+                {
+                    // Characters are stored in the bytes of a double (blank padded) just like
+                    // NCEPLIB-bufr does it.
+                    char chars[8] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+                    for (size_t charIdx = 0; charIdx < op.bits / 8; ++charIdx)
+                    {
+                        chars[charIdx] = static_cast<char>(reader.read(8));
+                    }
+
+                    if (op.emit)
+                    {
+                        double value;
+                        std::memcpy(&value, chars, sizeof(double));
+                        sink.value(op.nodeId, value);
+                    }
+
+                    ++pc;
+                    break;
+                }
+                case DecodeOp::Code::Repeat:
+                {
+                    const uint64_t count = (op.bits > 0) ? reader.read(op.bits) : op.count;
+                    if (op.emit) sink.count(op.nodeId, static_cast<int>(count));
+
+                    if (!reader.ok()) return false;
+
+                    if (count == 0)
+                    {
+                        pc = op.jump + 1;
+                    }
+                    else if (op.skipBody)
+                    {
+                        reader.skip(count * op.bodyBits);
+                        pc = op.jump + 1;
+                    }
+                    else
+                    {
+                        if (depth == sizeof(loops) / sizeof(Loop)) return false;
+                        loops[depth++] = {pc, count};
+                        ++pc;
+                    }
+
+                    break;
+                }
+                case DecodeOp::Code::EndRepeat:
+                {
+                    auto& loop = loops[depth - 1];
+                    if (--loop.remaining > 0)
+                    {
+                        pc = loop.start + 1;
+                    }
+                    else
+                    {
+                        --depth;
+                        ++pc;
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return reader.ok();
+    }
+}  // namespace bufr
@@ -0,0 +1,237 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "ExtractionPlan.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "Gather.h"
+
+
+namespace bufr {
+    ExtractionPlan::ExtractionPlan(const Targets& targets,
+                                   size_t firstNodeId,
+                                   size_t lastNodeId,
+                                   bool dropAll) :
+        firstNodeId_(firstNodeId),
+        nodes_(lastNodeId - firstNodeId + 1),
+        longStrIds_(lastNodeId - firstNodeId + 1),
+        filterIdxs_(targets.size(), -1),
+        predicates_(targets.size()),
+        dropAll_(dropAll),
+        positions_(targets.size()),
+        predicateSeen_(targets.size(), false)
+    {
+        std::vector<std::vector<CountSlot>> nodeCounts(nodes_.size());
+        std::vector<std::vector<uint32_t>> nodeData(nodes_.size());
+
+        for (size_t targetIdx = 0; targetIdx < targets.size(); ++targetIdx)
+        {
+            const auto& target = *targets[targetIdx];
+            if (target.path.empty()) { continue; }
+
+            if (target.usesFilters)
+            {
+                RepeatFilter filter;
+                filter.filters.resize(target.path.size() - 1);
+                filter.repeats.resize(target.path.size() - 1, 0);
+                filter.kept.resize(target.path.size() - 1, true);
+                for (size_t level = 0; level + 1 < target.path.size(); ++level)
+                {
+                    const auto& component = target.path[level];
+                    if (component.type == TargetComponent::Type::Repeat)
+                    {
+                        filter.filters[level] = component.queryComponent->filter;
+                    }
+                }
+
+                filterIdxs_[targetIdx] = static_cast<int>(filters_.size());
+                filters_.push_back(std::move(filter));
+            }
+
+            // The containers in the path give the counts for each level (the last component is
+            // the element itself).
+            for (size_t level = 0; level + 1 < target.path.size(); ++level)
+            {
+                const auto& component = target.path[level];
+                if (!component.isContainer()) { continue; }
+
+                auto& node = nodes_[component.nodeId - firstNodeId];
+                if (component.type == TargetComponent::Type::Subset)
+                {
+                    node.fixedCount = 1;
+                }
+                else if (component.fixedRepeatCount > 1)
+                {
+                    node.fixedCount = static_cast<int>(component.fixedRepeatCount);
+                }
+
+                nodeCounts[component.nodeId - firstNodeId].push_back(
+                    {static_cast<uint32_t>(targetIdx), static_cast<uint32_t>(level)});
+            }
+
+            const auto nodeIdx = target.nodeIdx - firstNodeId;
+            nodeData[nodeIdx].push_back(static_cast<uint32_t>(targetIdx));
+
+            if (const auto& predicate = target.path.back().queryComponent->predicate)
+            {
+                if (target.typeInfo.isLongString())
+                {
+                    std::ostringstream errStr;
+                    errStr << "The query " << target.queryStr << " for " << target.name;
+                    errStr << " has a value predicate but its element is a long string.";
+                    throw eckit::BadParameter(errStr.str());
+                }
+
+                nodes_[nodeIdx].hasPredicate = true;
+                predicates_[targetIdx] = predicate;
+                predicateColumns_.push_back(static_cast<uint32_t>(targetIdx));
+            }
+            if (target.typeInfo.isLongString())
+            {
+                nodes_[nodeIdx].isLongStr = true;
+                longStrIds_[nodeIdx] = target.longStrId;
+            }
+            else
+            {
+                gatherColumns_.push_back(static_cast<uint32_t>(targetIdx));
+            }
+        }
+
+        for (size_t nodeIdx = 0; nodeIdx < nodes_.size(); ++nodeIdx)
+        {
+            auto& node = nodes_[nodeIdx];
+
+            node.countsBegin = static_cast<uint32_t>(countSlots_.size());
+            countSlots_.insert(countSlots_.end(),
+                               nodeCounts[nodeIdx].begin(),
+                               nodeCounts[nodeIdx].end());
+            node.countsEnd = static_cast<uint32_t>(countSlots_.size());
+
+            node.dataBegin = static_cast<uint32_t>(dataSlots_.size());
+            dataSlots_.insert(dataSlots_.end(), nodeData[nodeIdx].begin(), nodeData[nodeIdx].end());
+            node.dataEnd = static_cast<uint32_t>(dataSlots_.size());
+        }
+    }
+
+    bool ExtractionPlan::collect(const DataProvider& dataProvider,
+                                 std::vector<TargetColumn>& columns) const
+    {
+        if (dropAll_) { return false; }
+        resetPredicates();
+
+        for (const auto columnIdx : gatherColumns_)
+        {
+            positions_[columnIdx].clear();
+        }
+
+        for (FortranIdx cursor = 1; cursor <= dataProvider.getNVal(); ++cursor)
+        {
+            const auto nodeIdx = dataProvider.getInv(cursor) - firstNodeId_;
+            if (nodeIdx >= nodes_.size())
+            {
+                std::ostringstream errStr;
+                errStr << "The subset has table node " << dataProvider.getInv(cursor);
+                errStr << ", which isn't part of its extraction plan (were the NCEPLIB-bufr ";
+                errStr << "tables rebuilt?).";
+                throw eckit::BadValue(errStr.str());
+            }
+
+            const auto& node = nodes_[nodeIdx];
+
+            if (node.countsBegin != node.countsEnd)
+            {
+                const int count = (node.fixedCount > 0) ?
+                    node.fixedCount : static_cast<int>(dataProvider.getVal(cursor));
+
+                for (auto slotIdx = node.countsBegin; slotIdx < node.countsEnd; ++slotIdx)
+                {
+                    const auto& slot = countSlots_[slotIdx];
+                    const auto slotCount = filterCount(slot, count);
+                    if (slotCount >= 0) columns[slot.columnIdx].addCount(slot.level, slotCount);
+                }
+            }
+
+            if (node.dataBegin == node.dataEnd) { continue; }
+
+            if (node.isLongStr)
+            {
+                const auto longStr = dataProvider.getLongStr(longStrIds_[nodeIdx]);
+                for (auto slotIdx = node.dataBegin; slotIdx < node.dataEnd; ++slotIdx)
+                {
+                    const auto columnIdx = dataSlots_[slotIdx];
+                    if (keepValue(columnIdx)) columns[columnIdx].addValue(longStr);
+                }
+            }
+            else
+            {
+                const auto position = static_cast<uint32_t>(cursor - 1);
+                for (auto slotIdx = node.dataBegin; slotIdx < node.dataEnd; ++slotIdx)
+                {
+                    const auto columnIdx = dataSlots_[slotIdx];
+                    if (!keepValue(columnIdx)) { continue; }
+
+                    // The rest of the subset isn't worth going over once a predicate fails.
+                    if (node.hasPredicate && !testValue(columnIdx, dataProvider.getVal(cursor)))
+                    {
+                        return false;
+                    }
+
+                    positions_[columnIdx].push_back(position);
+                }
+            }
+        }
+
+        if (!predicatesSeen()) { return false; }
+
+        const auto vals = dataProvider.getVals();
+        for (const auto columnIdx : gatherColumns_)
+        {
+            const auto& positions = positions_[columnIdx];
+            if (positions.empty()) { continue; }
+
+            if (auto dst = columns[columnIdx].growValues(positions.size()))
+            {
+                gather(vals.data(), positions.data(), positions.size(), dst);
+            }
+        }
+
+        return true;
+    }
+
+    int ExtractionPlan::RepeatFilter::count(size_t level, int count)
+    {
+        // The count of a level comes at the start of each repeat of the level above.
+        if (level > 0) { nextRepeat(level - 1); }
+        repeats[level] = 0;
+
+        if (level > 0 && !kept[level - 1]) { return -1; }
+
+        // Only the filter indices up to the count are there, and the kept repeats are stored
+        // one after the other in the order of the filter.
+        const auto& filter = filters[level];
+        if (filter.empty() || count <= 0) { return count; }
+
+        return static_cast<int>(std::upper_bound(filter.begin(),
+                                                 filter.end(),
+                                                 static_cast<size_t>(count)) - filter.begin());
+    }
+
+    bool ExtractionPlan::RepeatFilter::value()
+    {
+        const auto level = repeats.size() - 1;
+        nextRepeat(level);
+        return kept[level];
+    }
+
+    void ExtractionPlan::RepeatFilter::nextRepeat(size_t level)
+    {
+        const auto repeat = ++repeats[level];
+        const auto& filter = filters[level];
+
+        kept[level] = (level == 0 || kept[level - 1]) &&
+                      (filter.empty() || std::binary_search(filter.begin(), filter.end(), repeat));
+    }
+}  // namespace bufr
@@ -0,0 +1,206 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bufr/DataProvider.h"
+#include "Target.h"
+#include "TargetColumn.h"
+
+
+namespace bufr {
+
+    /// \brief Says where the counts and values of each node of a subset variant go in the
+    /// ResultSet columns. It only depends on the targets, so it is made once per SubsetVariant
+    /// (see QueryRunner::getTargets) and every subset is then collected with a single pass over
+    /// the NCEPLIB-bufr inv/val arrays (or over what a DecodeProgram emits). The numeric values
+    /// are not copied in that pass, their positions in val are noted instead and each column is
+    /// then filled with one gather (see Gather.h). Repeats left out by a query filter (ex:
+    /// */BRIT{1-5,10}/TMBR) are dropped in that pass as well, so they are never stored. Queries
+    /// with a value predicate (ex: */CLAT[-30:30]) are checked as soon as their values come up,
+    /// and the pass stops at the first one that fails (the subset is then dropped).
+    class ExtractionPlan
+    {
+     public:
+        /// \brief Receives the counts and values of a DecodeProgram (see DecodeProgram::run).
+        class Sink
+        {
+         public:
+            Sink(const ExtractionPlan& plan, std::vector<TargetColumn>& columns) :
+                plan_(plan),
+                columns_(columns),
+                keep_(!plan.dropAll_)
+            {
+                plan_.resetPredicates();
+            }
+
+            void count(size_t nodeId, int count)
+            {
+                if (!keep_) return;
+
+                const auto& node = plan_.nodes_[nodeId - plan_.firstNodeId_];
+                for (auto slotIdx = node.countsBegin; slotIdx < node.countsEnd; ++slotIdx)
+                {
+                    const auto& slot = plan_.countSlots_[slotIdx];
+                    const auto slotCount = plan_.filterCount(slot, count);
+                    if (slotCount >= 0) columns_[slot.columnIdx].addCount(slot.level, slotCount);
+                }
+            }
+
+            void value(size_t nodeId, double value)
+            {
+                if (!keep_) return;
+
+                const auto& node = plan_.nodes_[nodeId - plan_.firstNodeId_];
+                for (auto slotIdx = node.dataBegin; slotIdx < node.dataEnd; ++slotIdx)
+                {
+                    const auto columnIdx = plan_.dataSlots_[slotIdx];
+                    if (!plan_.keepValue(columnIdx)) continue;
+
+                    if (node.hasPredicate && !plan_.testValue(columnIdx, value))
+                    {
+                        keep_ = false;
+                        return;
+                    }
+
+                    columns_[columnIdx].addValue(value);
+                }
+            }
+
+            /// \brief Did the subset pass the value predicates (see ResultSetImpl::dropSubset)?
+            bool keep() const { return keep_ && plan_.predicatesSeen(); }
+
+         private:
+            const ExtractionPlan& plan_;
+            std::vector<TargetColumn>& columns_;
+            bool keep_;
+        };
+
+        /// \brief Make the plan.
+        /// \param targets The targets for the subset variant.
+        /// \param firstNodeId The id of the first (subset) table node.
+        /// \param lastNodeId The id of the last table node in the subset.
+        /// \param dropAll Drop every subset (a query with a value predicate doesn't apply to the
+        ///        subset variant, so its subsets can't pass).
+        ExtractionPlan(const Targets& targets,
+                       size_t firstNodeId,
+                       size_t lastNodeId,
+                       bool dropAll = false);
+
+        /// \brief Collect the counts and values of the subset NCEPLIB-bufr has loaded.
+        /// \param dataProvider The DataProvider with the subset loaded.
+        /// \param columns The columns of the ResultSet (see ResultSetImpl::beginSubset).
+        /// \return True if the subset passed the value predicates. Otherwise the subset is left
+        ///         part way collected and has to be dropped (see ResultSetImpl::dropSubset).
+        bool collect(const DataProvider& dataProvider, std::vector<TargetColumn>& columns) const;
+
+        /// \brief Are all the subsets of the variant dropped (see the constructor)?
+        bool dropsAll() const { return dropAll_; }
+
+     private:
+        /// \brief A count level of a column.
+        struct CountSlot
+        {
+            uint32_t columnIdx;
+            uint32_t level;
+        };
+
+        /// \brief Keeps track of the repeats of a column whose query has filters. The counts and
+        /// values of a column come in order, every count (but the subset one) starts a new
+        /// repeat of the level above and every value a new repeat of the last level, so the
+        /// repeat numbers can be followed as the subset is collected.
+        struct RepeatFilter
+        {
+            std::vector<std::vector<size_t>> filters;  // For each count level (sorted, 1 based)
+            std::vector<size_t> repeats;  // The current repeat number at each level
+            std::vector<char> kept;  // Is the current repeat at each level (and above) kept
+
+            /// \brief The count to store for a level, or -1 if the level is filtered out.
+            int count(size_t level, int count);
+
+            /// \brief Should the next value be stored?
+            bool value();
+
+         private:
+            void nextRepeat(size_t level);
+        };
+
+        /// \brief The slots a node fills (ranges in countSlots_ and dataSlots_).
+        struct NodeSlots
+        {
+            uint32_t countsBegin = 0;
+            uint32_t countsEnd = 0;
+            uint32_t dataBegin = 0;
+            uint32_t dataEnd = 0;
+            int fixedCount = 0;  // The count of subsets and fixed replications (0 if in val)
+            bool isLongStr = false;
+            bool hasPredicate = false;  // Does one of the columns have a value predicate
+        };
+
+        /// \brief The count to store for a count slot (-1 if its repeat was filtered out).
+        int filterCount(const CountSlot& slot, int count) const
+        {
+            const auto filterIdx = filterIdxs_[slot.columnIdx];
+            return (filterIdx < 0) ? count : filters_[filterIdx].count(slot.level, count);
+        }
+
+        /// \brief Should the next value of a column be stored?
+        bool keepValue(uint32_t columnIdx) const
+        {
+            const auto filterIdx = filterIdxs_[columnIdx];
+            return filterIdx < 0 || filters_[filterIdx].value();
+        }
+
+        /// \brief Check a value of a column against its value predicate (if any).
+        bool testValue(uint32_t columnIdx, double value) const
+        {
+            const auto& predicate = predicates_[columnIdx];
+            if (predicate == nullptr) return true;
+
+            predicateSeen_[columnIdx] = true;
+            return predicate->test(value);
+        }
+
+        /// \brief Start checking the value predicates of a new subset.
+        void resetPredicates() const
+        {
+            for (const auto columnIdx : predicateColumns_)
+            {
+                predicateSeen_[columnIdx] = false;
+            }
+        }
+
+        /// \brief Did every column with a value predicate have a value in the subset? Subsets
+        ///        without one can't pass.
+        bool predicatesSeen() const
+        {
+            for (const auto columnIdx : predicateColumns_)
+            {
+                if (!predicateSeen_[columnIdx]) return false;
+            }
+
+            return true;
+        }
+
+        size_t firstNodeId_;
+        std::vector<NodeSlots> nodes_;  // Indexed by nodeId - firstNodeId_
+        std::vector<CountSlot> countSlots_;
+        std::vector<uint32_t> dataSlots_;  // Column idxs
+        std::vector<std::string> longStrIds_;  // Indexed like nodes_ (long strings only)
+        std::vector<uint32_t> gatherColumns_;  // Column idxs of the numeric targets
+        std::vector<int> filterIdxs_;  // Index in filters_ for each column (-1 if unfiltered)
+        std::vector<std::shared_ptr<ValuePredicate>> predicates_;  // For each column (or null)
+        std::vector<uint32_t> predicateColumns_;  // Column idxs of the ones with predicates
+        bool dropAll_;
+
+        // Scratch space for collect (positions in val for each column, the repeat numbers of
+        // the filtered ones and which predicates were checked). Plans belong to one QueryRunner
+        // so it is never used by two subsets at once.
+        mutable std::vector<std::vector<uint32_t>> positions_;
+        mutable std::vector<RepeatFilter> filters_;
+        mutable std::vector<char> predicateSeen_;
+    };
+}  // namespace bufr
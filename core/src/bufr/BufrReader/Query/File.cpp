@@ -4,7 +4,9 @@
 
 #include <algorithm>
 
+#include "Aggregator.h"
 #include "QueryRunner.h"
+#include "WorkerPool.h"
 #include "bufr/QuerySet.h"
 #include "bufr/DataProvider.h"
 #include "bufr/NcepDataProvider.h"
@@ -12,7 +14,8 @@
 
 
 namespace bufr {
-    File::File(const std::string &filename, const std::string &wmoTablePath)
+    File::File(const std::string &filename, const std::string &wmoTablePath) :
+        wmoTablePath_(wmoTablePath)
     {
         if (wmoTablePath.empty())
         {
@@ -31,6 +34,11 @@ namespace bufr {
       return dataProvider_->numMessages(querySet);
     }
 
+    std::shared_ptr<MessageIndex> File::index()
+    {
+        return dataProvider_->getIndex();
+    }
+
     void File::close()
     {
         dataProvider_->close();
@@ -41,8 +49,34 @@ namespace bufr {
         dataProvider_->rewind();
     }
 
-    ResultSet File::execute(const QuerySet &querySet, size_t offset, size_t numMessages)
+    ResultSet File::execute(const QuerySet &querySet,
+                            size_t offset,
+                            size_t numMessages,
+                            size_t numWorkers)
     {
+        // The sampling goes by the order of the subsets in the file, so it isn't split up.
+        if (numWorkers > 1 && !querySet.sampling().isActive())
+        {
+            const size_t totalMessages = size(querySet);
+            const size_t begin = std::min(offset, totalMessages);
+            const size_t end = (numMessages > 0) ? std::min(totalMessages, begin + numMessages)
+                                                 : totalMessages;
+
+            if (end - begin > 1)
+            {
+                // Each worker needs a file of its own (the file position is shared with the
+                // parent otherwise), but the index doesn't have to be built again.
+                auto worker = [this, &querySet](size_t workerOffset, size_t workerMessages)
+                {
+                    File file(dataProvider_->getFilepath(), wmoTablePath_);
+                    file.dataProvider_->setIndex(dataProvider_->getIndex());
+                    return file.execute(querySet, workerOffset, workerMessages);
+                };
+
+                return WorkerPool(numWorkers).run(querySet, begin, end, worker);
+            }
+        }
+
         size_t msgCnt = 0;
         auto resultSet = ResultSet();
         auto queryRunner = QueryRunner(querySet, resultSet, dataProvider_);
@@ -67,13 +101,108 @@ namespace bufr {
             return true;
         };
 
-        dataProvider_->run(querySet,
-                           processSubset,
-                           processMsg,
-                           continueProcessing,
-                           offset);
+        // Subsets after the first one in each message are decoded directly from the message
+        // data when possible.
+        auto subsetReader = [&queryRunner](const MessageHeader& header, const uint8_t* msg)
+        {
+            return queryRunner.accumulateRemaining(header, msg);
+        };
+
+        dataProvider_->setSubsetReader(subsetReader);
 
-        return resultSet;
+        try
+        {
+            dataProvider_->run(querySet,
+                               processSubset,
+                               processMsg,
+                               continueProcessing,
+                               offset);
+        }
+        catch (...)
+        {
+            dataProvider_->setSubsetReader(nullptr);
+            throw;
+        }
+
+        dataProvider_->setSubsetReader(nullptr);
+
+        // Drops the subsets that were replaced by the grid thinning.
+        return queryRunner.takeResults();
     }
 
+    ResultSetIterator File::executeChunks(const QuerySet& querySet,
+                                          size_t chunkMessages,
+                                          size_t chunkBytes,
+                                          size_t offset,
+                                          size_t numMessages)
+    {
+        return ResultSetIterator(dataProvider_,
+                                 querySet,
+                                 offset,
+                                 numMessages,
+                                 chunkMessages,
+                                 chunkBytes);
+    }
+
+    std::vector<AggregateResult> File::aggregate(const QuerySet& querySet,
+                                                 const std::vector<AggregateSpec>& specs,
+                                                 size_t offset,
+                                                 size_t numMessages)
+    {
+        // Check the specs before anything is read.
+        auto aggregator = Aggregator(querySet, specs);
+
+        size_t msgCnt = 0;
+        auto resultSet = ResultSet();
+        auto queryRunner = QueryRunner(querySet, resultSet, dataProvider_);
+
+        auto processMsg = [&msgCnt] () mutable
+        {
+            msgCnt++;
+        };
+
+        auto processSubset = [&queryRunner, &aggregator]() mutable
+        {
+            queryRunner.accumulate();
+            queryRunner.aggregate(aggregator);
+        };
+
+        auto continueProcessing = [numMessages, &msgCnt, offset]() -> bool
+        {
+            if (numMessages > 0 && msgCnt > offset)
+            {
+              return  (msgCnt - offset) < numMessages;
+            }
+
+            return true;
+        };
+
+        auto subsetReader = [&queryRunner, &aggregator](const MessageHeader& header,
+                                                        const uint8_t* msg)
+        {
+            const bool collected = queryRunner.accumulateRemaining(header, msg);
+            if (collected) queryRunner.aggregate(aggregator);
+            return collected;
+        };
+
+        dataProvider_->setSubsetReader(subsetReader);
+
+        try
+        {
+            dataProvider_->run(querySet,
+                               processSubset,
+                               processMsg,
+                               continueProcessing,
+                               offset);
+        }
+        catch (...)
+        {
+            dataProvider_->setSubsetReader(nullptr);
+            throw;
+        }
+
+        dataProvider_->setSubsetReader(nullptr);
+
+        return aggregator.results();
+    }
 }  // namespace bufr
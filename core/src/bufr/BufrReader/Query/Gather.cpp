@@ -0,0 +1,113 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "Gather.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #include <immintrin.h>
+    #define BUFR_GATHER_X86
+#endif
+
+
+namespace bufr {
+namespace {
+    // Runs shorter than this aren't worth the setup of the wide kernels.
+    constexpr size_t MinRunLength = 8;
+
+    using StridedCopy = void (*)(const double*, int64_t, size_t, double*);
+
+    void stridedCopyScalar(const double* src, int64_t stride, size_t num, double* dst)
+    {
+        for (size_t idx = 0; idx < num; ++idx)
+        {
+            dst[idx] = src[static_cast<int64_t>(idx) * stride];
+        }
+    }
+
+#ifdef BUFR_GATHER_X86
+    __attribute__((target("avx2")))
+    void stridedCopyAvx2(const double* src, int64_t stride, size_t num, double* dst)
+    {
+        const __m256i step = _mm256_set1_epi64x(4 * stride);
+        __m256i indices = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+
+        size_t idx = 0;
+        for (; idx + 4 <= num; idx += 4)
+        {
+            _mm256_storeu_pd(dst + idx, _mm256_i64gather_pd(src, indices, 8));
+            indices = _mm256_add_epi64(indices, step);
+        }
+
+        stridedCopyScalar(src + static_cast<int64_t>(idx) * stride, stride, num - idx, dst + idx);
+    }
+
+    __attribute__((target("avx512f")))
+    void stridedCopyAvx512(const double* src, int64_t stride, size_t num, double* dst)
+    {
+        const __m512i step = _mm512_set1_epi64(8 * stride);
+        __m512i indices = _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                                           3 * stride, 2 * stride, stride, 0);
+
+        size_t idx = 0;
+        for (; idx + 8 <= num; idx += 8)
+        {
+            _mm512_storeu_pd(dst + idx, _mm512_i64gather_pd(indices, src, 8));
+            indices = _mm512_add_epi64(indices, step);
+        }
+
+        stridedCopyScalar(src + static_cast<int64_t>(idx) * stride, stride, num - idx, dst + idx);
+    }
+#endif
+
+    StridedCopy selectStridedCopy()
+    {
+#ifdef BUFR_GATHER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return stridedCopyAvx512;
+        if (__builtin_cpu_supports("avx2")) return stridedCopyAvx2;
+#endif
+        return stridedCopyScalar;
+    }
+}  // namespace
+
+    void gather(const double* src, const uint32_t* positions, size_t num, double* dst)
+    {
+        static const StridedCopy stridedCopy = selectStridedCopy();
+
+        size_t begin = 0;
+        while (begin < num)
+        {
+            // Find the end of the run of positions with the same stride.
+            size_t end = begin + 1;
+            int64_t stride = 0;
+            if (end < num)
+            {
+                stride = static_cast<int64_t>(positions[end]) - positions[begin];
+                for (++end; end < num; ++end)
+                {
+                    if (static_cast<int64_t>(positions[end]) - positions[end - 1] != stride) break;
+                }
+            }
+
+            const auto runLength = end - begin;
+            if (runLength < MinRunLength)
+            {
+                for (auto idx = begin; idx < end; ++idx)
+                {
+                    dst[idx] = src[positions[idx]];
+                }
+            }
+            else if (stride == 1)
+            {
+                std::memcpy(dst + begin, src + positions[begin], runLength * sizeof(double));
+            }
+            else
+            {
+                stridedCopy(src + positions[begin], stride, runLength, dst + begin);
+            }
+
+            begin = end;
+        }
+    }
+}  // namespace bufr
@@ -0,0 +1,20 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace bufr {
+
+    /// \brief Copy src[positions[i]] to dst[i] for every position. Runs of positions with a
+    ///        constant stride (typical for the channels of radiance subsets) are copied with
+    ///        memcpy when contiguous and with a wide gather kernel (AVX-512 or AVX2, picked at
+    ///        runtime) otherwise. Short or irregular runs are copied one value at a time.
+    /// \param src The values to gather from (ex: the NCEPLIB-bufr val array).
+    /// \param positions The (0 based) positions in src to copy.
+    /// \param num The number of positions.
+    /// \param dst Where to copy the values to (room for num values).
+    void gather(const double* src, const uint32_t* positions, size_t num, double* dst);
+}  // namespace bufr
@@ -0,0 +1,104 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "bufr/MessageIndex.h"
+
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    MessageIndex::MessageIndex(const std::string& filePath) :
+        filePath_(filePath),
+        reader_(std::make_shared<MessageReader>(filePath))
+    {
+        // If the file can't be opened the index is left empty, which is what the callers report
+        // on (no BUFR messages found).
+        size_t offset = 0;
+        MessageHeader header;
+        while (reader_->next(offset, header, false))
+        {
+            messages_.push_back(infoFor(header));
+            offset += header.length;
+        }
+    }
+
+    MessageIndex::MessageIndex(const std::string& filePath, std::vector<MessageInfo>&& messages) :
+        filePath_(filePath),
+        messages_(std::move(messages)),
+        reader_(std::make_shared<MessageReader>(filePath))
+    {
+    }
+
+    MessageInfo MessageIndex::infoFor(const MessageHeader& header)
+    {
+        MessageInfo info;
+        info.offset = header.offset;
+        info.length = header.length;
+        info.edition = header.edition;
+        info.dataCategory = header.dataCategory;
+        info.dataSubCategory = header.dataSubCategory;
+        info.date = header.date();
+        info.numSubsets = header.numSubsets;
+        info.isCompressed = header.isCompressed;
+        info.tableDescriptor = header.descriptors.empty() ? 0 : header.descriptors.front();
+        return info;
+    }
+
+    std::vector<size_t> MessageIndex::messagesFor(const QuerySet& querySet) const
+    {
+        std::vector<size_t> msgIdxs;
+        msgIdxs.reserve(messages_.size());
+
+        for (size_t msgIdx = 0; msgIdx < messages_.size(); ++msgIdx)
+        {
+            const auto& msg = messages_[msgIdx];
+            if (msg.isDictionary() || msg.subset.empty()) continue;
+
+            if (querySet.includesSubset(msg.subset) &&
+                querySet.includesMessage(msg.dataCategory, msg.dataSubCategory, msg.date))
+            {
+                msgIdxs.push_back(msgIdx);
+            }
+        }
+
+        return msgIdxs;
+    }
+
+    void MessageIndex::read(size_t msgIdx, std::vector<int>& buffer) const
+    {
+        const auto& msg = messages_.at(msgIdx);
+
+        if (msg.offset + msg.length > reader_->size())
+        {
+            std::ostringstream errStr;
+            errStr << "Failed to read BUFR message " << msgIdx << " from " << filePath_ << ". ";
+            errStr << "The file is shorter than expected (has it changed since it was indexed?)";
+            throw eckit::BadValue(errStr.str());
+        }
+
+        buffer.resize((msg.length + sizeof(int) - 1) / sizeof(int));
+        buffer.back() = 0;
+        std::memcpy(buffer.data(), reader_->data() + msg.offset, msg.length);
+    }
+
+    MessageHeader MessageIndex::header(size_t msgIdx) const
+    {
+        const auto& msg = messages_.at(msgIdx);
+
+        MessageHeader header;
+        if (msg.offset + msg.length > reader_->size() ||
+            !MessageReader::parse(reader_->data() + msg.offset, msg.length, header))
+        {
+            std::ostringstream errStr;
+            errStr << "Failed to read the headers of BUFR message " << msgIdx << " from ";
+            errStr << filePath_ << ".";
+            throw eckit::BadValue(errStr.str());
+        }
+
+        header.offset = msg.offset;
+        return header;
+    }
+}  // namespace bufr
@@ -0,0 +1,307 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "bufr/MessageIndexCache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "../../Log.h"
+
+
+namespace bufr {
+    namespace
+    {
+        const char* IndexMagic = "BUFR-QUERY-INDEX";
+        const int IndexVersion = 3;
+        const char* IndexExtension = ".bufridx";
+        const char* NoSubset = "-";
+
+        // The smallest possible BUFR message (sections 0, 1, 3, 4 and 5 with nothing in them).
+        const size_t MinMessageLength = 8 + 17 + 7 + 4 + 4;
+
+        /// \brief Identifies the exact version of a file an index was built from.
+        struct FileSignature
+        {
+            std::string path;
+            size_t size = 0;
+            int64_t mtime = 0;
+            int64_t mtimeNsec = 0;  // A file can be rewritten within the same second
+            uint64_t inode = 0;
+            std::string tablePath;
+            uint64_t hash = 0;
+
+            bool operator==(const FileSignature& other) const
+            {
+                return path == other.path &&
+                       size == other.size &&
+                       mtime == other.mtime &&
+                       mtimeNsec == other.mtimeNsec &&
+                       inode == other.inode &&
+                       tablePath == other.tablePath;
+            }
+        };
+
+        std::string absolutePath(const std::string& filePath)
+        {
+            char resolved[PATH_MAX];
+            if (realpath(filePath.c_str(), resolved) == nullptr) return filePath;
+            return std::string(resolved);
+        }
+
+        std::string baseName(const std::string& filePath)
+        {
+            const auto pos = filePath.find_last_of('/');
+            return (pos == std::string::npos) ? filePath : filePath.substr(pos + 1);
+        }
+
+        /// \brief 64 bit FNV-1a hash.
+        uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+        {
+            for (size_t idx = 0; idx < size; ++idx)
+            {
+                hash ^= static_cast<unsigned char>(data[idx]);
+                hash *= 1099511628211ULL;
+            }
+
+            return hash;
+        }
+
+        uint64_t hashFile(const std::string& filePath)
+        {
+            std::ifstream file(filePath, std::ios::binary);
+            std::vector<char> chunk(1 << 20);
+
+            uint64_t hash = fnv1a(nullptr, 0);
+            while (file)
+            {
+                file.read(chunk.data(), chunk.size());
+                hash = fnv1a(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+            }
+
+            return hash;
+        }
+
+        bool makeSignature(const std::string& filePath,
+                           const std::string& tablePath,
+                           bool useHash,
+                           FileSignature& signature)
+        {
+            struct stat fileStat;
+            if (stat(filePath.c_str(), &fileStat) != 0) return false;
+
+            signature.path = absolutePath(filePath);
+            signature.size = static_cast<size_t>(fileStat.st_size);
+            signature.mtime = static_cast<int64_t>(fileStat.st_mtime);
+#ifdef __APPLE__
+            signature.mtimeNsec = static_cast<int64_t>(fileStat.st_mtimespec.tv_nsec);
+#else
+            signature.mtimeNsec = static_cast<int64_t>(fileStat.st_mtim.tv_nsec);
+#endif
+            signature.inode = static_cast<uint64_t>(fileStat.st_ino);
+            signature.tablePath = tablePath.empty() ? "" : absolutePath(tablePath);
+            signature.hash = useHash ? hashFile(filePath) : 0;
+
+            return true;
+        }
+
+        bool isTrue(const char* value)
+        {
+            const auto str = std::string(value);
+            return !(str.empty() || str == "0" || str == "off" || str == "OFF" ||
+                     str == "false" || str == "FALSE" || str == "no" || str == "NO");
+        }
+    }  // namespace
+
+    MessageIndexCache::MessageIndexCache()
+    {
+        if (const char* enabled = std::getenv("BUFR_INDEX_CACHE"))
+        {
+            enabled_ = isTrue(enabled);
+            writable_ = enabled_;
+        }
+
+        if (const char* directory = std::getenv("BUFR_INDEX_CACHE_DIR"))
+        {
+            directory_ = std::string(directory);
+            if (!directory_.empty()) writable_ = true;
+        }
+
+        if (const char* useHash = std::getenv("BUFR_INDEX_CACHE_HASH"))
+        {
+            useHash_ = isTrue(useHash);
+        }
+    }
+
+    std::string MessageIndexCache::pathFor(const std::string& filePath)
+    {
+        const auto& directory = instance().directory_;
+        if (directory.empty())
+        {
+            return filePath + IndexExtension;
+        }
+
+        // Files with the same name can live in different directories, so the name of the index
+        // file includes a hash of the full path.
+        const auto fullPath = absolutePath(filePath);
+        std::ostringstream path;
+        path << directory << "/" << baseName(filePath) << "."
+             << std::hex << std::setw(16) << std::setfill('0')
+             << fnv1a(fullPath.data(), fullPath.size())
+             << IndexExtension;
+
+        return path.str();
+    }
+
+    std::shared_ptr<MessageIndex> MessageIndexCache::load(const std::string& filePath,
+                                                          const std::string& providerType,
+                                                          const std::string& tablePath)
+    {
+        if (!isEnabled()) return nullptr;
+
+        std::ifstream indexFile(pathFor(filePath));
+        if (!indexFile.is_open()) return nullptr;
+
+        std::string magic;
+        int version;
+        indexFile >> magic >> version;
+        if (!indexFile || magic != IndexMagic || version != IndexVersion) return nullptr;
+
+        FileSignature stored;
+        std::string storedProvider;
+        size_t numMessages;
+        std::string key;
+
+        indexFile >> key >> std::quoted(stored.path)
+                  >> key >> stored.size
+                  >> key >> stored.mtime >> stored.mtimeNsec
+                  >> key >> stored.inode
+                  >> key >> std::quoted(stored.tablePath)
+                  >> key >> std::hex >> stored.hash >> std::dec
+                  >> key >> storedProvider
+                  >> key >> numMessages;
+
+        if (!indexFile || storedProvider != providerType) return nullptr;
+
+        // Only compute the hash if we need to compare it.
+        const bool checkHash = instance().useHash_ && stored.hash != 0;
+
+        FileSignature current;
+        if (!makeSignature(filePath, tablePath, checkHash, current) ||
+            !(current == stored) ||
+            (checkHash && current.hash != stored.hash))
+        {
+            log::debug() << "Ignoring out of date message index for " << filePath << std::endl;
+            return nullptr;
+        }
+
+        // Don't trust the count (or the messages) of a damaged index file.
+        if (numMessages > current.size / MinMessageLength)
+        {
+            log::warning() << "Ignoring the damaged message index file " << pathFor(filePath)
+                           << std::endl;
+            return nullptr;
+        }
+
+        std::vector<MessageInfo> messages(numMessages);
+        for (auto& msg : messages)
+        {
+            indexFile >> msg.offset
+                      >> msg.length
+                      >> msg.edition
+                      >> msg.dataCategory
+                      >> msg.dataSubCategory
+                      >> msg.date
+                      >> msg.numSubsets
+                      >> msg.isCompressed
+                      >> msg.tableDescriptor
+                      >> msg.subset;
+
+            if (msg.subset == NoSubset) msg.subset = "";
+
+            if (msg.offset + msg.length > current.size) indexFile.setstate(std::ios::failbit);
+        }
+
+        if (!indexFile)
+        {
+            log::warning() << "Could not read the message index file " << pathFor(filePath)
+                           << std::endl;
+            return nullptr;
+        }
+
+        return std::make_shared<MessageIndex>(filePath, std::move(messages));
+    }
+
+    bool MessageIndexCache::save(const MessageIndex& index,
+                                 const std::string& providerType,
+                                 const std::string& tablePath)
+    {
+        if (!isWritable()) return false;
+
+        const auto filePath = index.getFilepath();
+
+        FileSignature signature;
+        if (!makeSignature(filePath, tablePath, instance().useHash_, signature)) return false;
+
+        // Write to a temporary file and then move it into place, so that concurrent readers
+        // never see a partially written index.
+        const auto indexPath = pathFor(filePath);
+        const auto tmpPath = indexPath + ".tmp" + std::to_string(getpid());
+
+        {
+            std::ofstream indexFile(tmpPath);
+            if (!indexFile.is_open())
+            {
+                log::debug() << "Could not write the message index file " << indexPath
+                             << std::endl;
+                return false;
+            }
+
+            indexFile << IndexMagic << " " << IndexVersion << "\n"
+                      << "path " << std::quoted(signature.path) << "\n"
+                      << "size " << signature.size << "\n"
+                      << "mtime " << signature.mtime << " " << signature.mtimeNsec << "\n"
+                      << "inode " << signature.inode << "\n"
+                      << "tables " << std::quoted(signature.tablePath) << "\n"
+                      << "hash " << std::hex << signature.hash << std::dec << "\n"
+                      << "provider " << providerType << "\n"
+                      << "messages " << index.size() << "\n";
+
+            for (const auto& msg : index.messages())
+            {
+                indexFile << msg.offset << " "
+                          << msg.length << " "
+                          << msg.edition << " "
+                          << msg.dataCategory << " "
+                          << msg.dataSubCategory << " "
+                          << msg.date << " "
+                          << msg.numSubsets << " "
+                          << msg.isCompressed << " "
+                          << msg.tableDescriptor << " "
+                          << (msg.subset.empty() ? NoSubset : msg.subset) << "\n";
+            }
+
+            if (!indexFile)
+            {
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmpPath.c_str(), indexPath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+}  // namespace bufr
@@ -0,0 +1,213 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "bufr/MessageReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+
+namespace bufr {
+    namespace
+    {
+        const char* BufrMarker = "BUFR";
+        const char* EndMarker = "7777";
+        const size_t MarkerLen = 4;
+        const size_t Section0Len = 8;
+        const size_t MinSection1Len = 17;
+        const size_t MinSection1LenEd4 = 22;
+        const size_t MinSection3Len = 7;
+
+        inline size_t read3(const uint8_t* bytes)
+        {
+            return (static_cast<size_t>(bytes[0]) << 16) |
+                   (static_cast<size_t>(bytes[1]) << 8) |
+                    static_cast<size_t>(bytes[2]);
+        }
+
+        inline int read2(const uint8_t* bytes)
+        {
+            return (static_cast<int>(bytes[0]) << 8) | static_cast<int>(bytes[1]);
+        }
+    }  // namespace
+
+    MessageReader::MessageReader(const std::string& filePath) :
+        filePath_(filePath)
+    {
+        int fd = ::open(filePath_.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+        {
+            void* mapped = mmap(nullptr,
+                                static_cast<size_t>(fileStat.st_size),
+                                PROT_READ,
+                                MAP_PRIVATE,
+                                fd,
+                                0);
+
+            if (mapped != MAP_FAILED)
+            {
+                data_ = static_cast<const uint8_t*>(mapped);
+                size_ = static_cast<size_t>(fileStat.st_size);
+
+                // Messages are mostly visited in order.
+                madvise(mapped, size_, MADV_SEQUENTIAL);
+            }
+        }
+
+        ::close(fd);
+    }
+
+    MessageReader::~MessageReader()
+    {
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+    }
+
+    bool MessageReader::next(size_t& offset, MessageHeader& header, bool readDescriptors) const
+    {
+        while (offset + MarkerLen <= size_)
+        {
+            const auto* found = static_cast<const uint8_t*>(
+                memmem(data_ + offset, size_ - offset, BufrMarker, MarkerLen));
+
+            if (found == nullptr) break;
+
+            offset = static_cast<size_t>(found - data_);
+            if (parse(found, size_ - offset, header, readDescriptors))
+            {
+                header.offset = offset;
+                return true;
+            }
+
+            // Not a real message (or a truncated one), so resync on the next marker.
+            offset += MarkerLen;
+        }
+
+        offset = size_;
+        return false;
+    }
+
+    bool MessageReader::parse(const uint8_t* msg,
+                              size_t available,
+                              MessageHeader& header,
+                              bool readDescriptors)
+    {
+        // Section 0
+        if (available < Section0Len || std::memcmp(msg, BufrMarker, MarkerLen) != 0) return false;
+
+        header.length = read3(msg + 4);
+        header.edition = msg[7];
+
+        // Editions before 2 don't store the total message length, so we can't frame them.
+        if (header.edition < 2 ||
+            header.length < Section0Len + MinSection1Len + MinSection3Len + MarkerLen ||
+            header.length > available ||
+            std::memcmp(msg + header.length - MarkerLen, EndMarker, MarkerLen) != 0)
+        {
+            return false;
+        }
+
+        // Section 1
+        size_t pos = Section0Len;
+        const uint8_t* sec1 = msg + pos;
+        const size_t sec1Len = read3(sec1);
+        const size_t minSec1Len = (header.edition < 4) ? MinSection1Len : MinSection1LenEd4;
+        if (sec1Len < minSec1Len || pos + sec1Len >= header.length) return false;
+
+        if (header.edition < 4)
+        {
+            header.masterTable = sec1[3];
+            header.subCentre = sec1[4];
+            header.centre = sec1[5];
+            header.updateSequence = sec1[6];
+            header.hasSection2 = (sec1[7] & 0x80) != 0;
+            header.dataCategory = sec1[8];
+            header.intlSubCategory = 0;
+            header.dataSubCategory = sec1[9];
+            header.masterTableVersion = sec1[10];
+            header.localTableVersion = sec1[11];
+
+            // Year of century (a value of 100 is also used for the year 2000)
+            header.year = sec1[12] % 100;
+            header.year += (header.year > 40) ? 1900 : 2000;
+            header.month = sec1[13];
+            header.day = sec1[14];
+            header.hour = sec1[15];
+            header.minute = sec1[16];
+            header.second = 0;
+        }
+        else
+        {
+            header.masterTable = sec1[3];
+            header.centre = read2(sec1 + 4);
+            header.subCentre = read2(sec1 + 6);
+            header.updateSequence = sec1[8];
+            header.hasSection2 = (sec1[9] & 0x80) != 0;
+            header.dataCategory = sec1[10];
+            header.intlSubCategory = sec1[11];
+            header.dataSubCategory = sec1[12];
+            header.masterTableVersion = sec1[13];
+            header.localTableVersion = sec1[14];
+            header.year = read2(sec1 + 15);
+            header.month = sec1[17];
+            header.day = sec1[18];
+            header.hour = sec1[19];
+            header.minute = sec1[20];
+            header.second = sec1[21];
+        }
+
+        pos += sec1Len;
+
+        // Section 2 (optional)
+        if (header.hasSection2)
+        {
+            if (pos + 3 > header.length) return false;
+            pos += read3(msg + pos);
+        }
+
+        // Section 3
+        if (pos + MinSection3Len > header.length) return false;
+
+        const uint8_t* sec3 = msg + pos;
+        const size_t sec3Len = read3(sec3);
+        if (sec3Len < MinSection3Len || pos + sec3Len > header.length) return false;
+
+        header.numSubsets = static_cast<size_t>(read2(sec3 + 4));
+        header.isObserved = (sec3[6] & 0x80) != 0;
+        header.isCompressed = (sec3[6] & 0x40) != 0;
+
+        header.descriptors.clear();
+        const size_t numDescriptors = (sec3Len - MinSection3Len) / 2;
+        if (readDescriptors)
+        {
+            header.descriptors.reserve(numDescriptors);
+            for (size_t descIdx = 0; descIdx < numDescriptors; ++descIdx)
+            {
+                header.descriptors.push_back(read2(sec3 + MinSection3Len + 2 * descIdx));
+            }
+        }
+        else if (numDescriptors > 0)
+        {
+            header.descriptors.push_back(read2(sec3 + MinSection3Len));
+        }
+
+        pos += sec3Len;
+
+        // Section 4
+        if (pos + 4 > header.length) return false;
+
+        header.dataOffset = pos;
+        header.dataLength = read3(msg + pos);
+        if (pos + header.dataLength + MarkerLen > header.length) return false;
+
+        return true;
+    }
+}  // namespace bufr
@@ -44,6 +44,13 @@ namespace bufr {
                 {
                     path.push_back(PathComponent::parse(*compIt));
                 }
+
+                // Only the element itself can have a value predicate.
+                if (path.back()->predicate && compIt + 1 != componentTokens.end())
+                {
+                    throw eckit::BadParameter("QueryParser::parse: Value predicates can only "
+                                              "follow the last element of a query: " + queryStr);
+                }
             }
 
             queries.emplace_back(path);
@@ -4,36 +4,336 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 #include "../../Log.h"
 #include "bufr/SubsetTable.h"
 #include "VectorMath.h"
-#include "SubsetLookupTable.h"
 #include "ResultSetImpl.h"
+#include "TargetsCache.h"
 
 
 namespace bufr {
+    namespace
+    {
+        const size_t Section4HeaderBytes = 4;  // Section length and a reserved byte
+        const size_t SubsetLengthBits = 16;  // NCEP subsets start with their length in bytes
+        const size_t MaxPaddingBits = 16;  // Section 4 is padded to an even number of bytes
+        const size_t PadCountBits = 8;  // NCEP subsets end with the number of pad bits
+
+        /// \brief Check that the reader stopped right at the padding of an NCEP subset (an 8 bit
+        ///        count of the zero bits that follow it and fill up the last byte).
+        bool atSubsetPadding(BitReader reader, size_t endPos)
+        {
+            if (reader.position() + PadCountBits > endPos) return false;
+
+            const auto numPadBits = reader.read(PadCountBits);
+            return reader.position() + numPadBits == endPos;
+        }
+
+        /// \brief Sink for the subsets that are sampled out (only decoded to find the next one).
+        struct SkipSink
+        {
+            void count(size_t, int) {}
+            void value(size_t, double) {}
+        };
+    }  // namespace
+
     QueryRunner::QueryRunner(const QuerySet& querySet, ResultSet& resultSet,
                              const DataProviderType &dataProvider) :
         querySet_(querySet),
         resultSet_(resultSet),
-        dataProvider_(dataProvider)
+        dataProvider_(dataProvider),
+        tableGeneration_(FortranUnits::tableGeneration()),
+        sampler_(querySet)
     {
     }
 
     void QueryRunner::accumulate()
     {
-      resultSet_.impl_->frames_.push_back(SubsetLookupTable(dataProvider_, getTargets()));
+        if (!sampler_.sample()) return;
+
+        // The subsets replaced by the grid thinning are dropped once they are a good part of
+        // the results.
+        if (sampler_.numReplaced() > resultSet_.impl_->size() / 2)
+        {
+            sampler_.dropReplaced(*resultSet_.impl_);
+        }
+
+        const auto targets = getTargets();
+        const auto& plan = *planCache_.at(dataProvider_->getSubsetVariant());
+
+        finishSubset(plan.collect(*dataProvider_, resultSet_.impl_->beginSubset(targets)));
+    }
+
+    bool QueryRunner::accumulateRemaining(const MessageHeader& header, const uint8_t* msg)
+    {
+        // NCEPLIB-bufr reads the subsets again if they can't be decoded here, so the sampling
+        // decisions for them are undone.
+        sampler_.checkpoint();
+        const bool collected = collectRemaining(header, msg);
+        resultSet_.impl_->addDecodedMessage(collected);
+        if (collected)
+        {
+            sampler_.commit();
+        }
+        else
+        {
+            sampler_.rollback();
+        }
+
+        return collected;
+    }
+
+    bool QueryRunner::collectRemaining(const MessageHeader& header, const uint8_t* msg)
+    {
+        if (header.numSubsets < 2 || header.dataLength <= Section4HeaderBytes) return false;
+
+        const auto targets = getTargets();
+        const auto& programs = programCache_.at(dataProvider_->getSubsetVariant());
+        const auto& plan = *planCache_.at(dataProvider_->getSubsetVariant());
+
+        // None of the subsets could pass the value predicates, so there is nothing to decode
+        // (the sampling still has to count them, as when NCEPLIB-bufr reads them).
+        if (plan.dropsAll())
+        {
+            sampler_.skip(header.numSubsets - 1);
+            return true;
+        }
+
+        const uint8_t* data = msg + header.dataOffset + Section4HeaderBytes;
+        const size_t numBits = (header.dataLength - Section4HeaderBytes) * 8;
+
+        if (header.isCompressed)
+        {
+            return accumulateCompressed(programs, plan, targets, header.numSubsets, data, numBits);
+        }
+
+        if (programs.program == nullptr || programs.trace == nullptr) return false;
+
+        SubsetLayout layout;
+        size_t pos;
+        if (!findSubsetLayout(*programs.trace, data, numBits, layout, pos)) return false;
+
+        // The subsets are added as they are decoded and dropped again if any of them fails to
+        // decode (subsets that fail a value predicate are simply left out).
+        auto& results = *resultSet_.impl_;
+        const size_t numCollected = results.size();
+        for (size_t subsetIdx = 1; subsetIdx < header.numSubsets; ++subsetIdx)
+        {
+            auto reader = BitReader(data, numBits);
+            reader.seek(pos);
+
+            size_t endPos = 0;
+            if (layout == SubsetLayout::ByteCounted)
+            {
+                endPos = pos + reader.read(SubsetLengthBits) * 8;
+            }
+
+            if (!sampler_.sample())
+            {
+                auto skipSink = SkipSink();
+                if (layout == SubsetLayout::Packed && !programs.program->run(reader, skipSink))
+                {
+                    results.truncate(numCollected);
+                    return false;
+                }
+
+                pos = (layout == SubsetLayout::ByteCounted) ? endPos : reader.position();
+                continue;
+            }
+
+            auto sink = ExtractionPlan::Sink(plan, results.beginSubset(targets));
+            // Reading into the padding (or past it), or stopping short of it, means the program
+            // doesn't match the data.
+            if (!programs.program->run(reader, sink) ||
+                (layout == SubsetLayout::ByteCounted && !atSubsetPadding(reader, endPos)))
+            {
+                results.truncate(numCollected);
+                return false;
+            }
+
+            finishSubset(sink.keep());
+            pos = (layout == SubsetLayout::ByteCounted) ? endPos : reader.position();
+        }
+
+        // Anything left over has to be padding, otherwise the layout wasn't what we thought.
+        if (pos > numBits || (layout == SubsetLayout::Packed && numBits - pos >= MaxPaddingBits))
+        {
+            results.truncate(numCollected);
+            return false;
+        }
+
+        return true;
+    }
+
+    size_t QueryRunner::collectedBytes() const
+    {
+        return resultSet_.impl_->memoryStats().usedBytes;
+    }
+
+    ResultSet QueryRunner::takeResults(bool reserveNext)
+    {
+        sampler_.dropReplaced(*resultSet_.impl_);
+
+        auto resultSet = ResultSet();
+        std::swap(resultSet.impl_, resultSet_.impl_);
+        sampler_.resultsTaken();
+
+        // The next chunk is likely to be about as big, so its buffers are allocated in one go
+        // rather than grown (and copied) subset by subset.
+        if (reserveNext) resultSet_.impl_->reserve(*resultSet.impl_);
+
+        return resultSet;
+    }
+
+    void QueryRunner::aggregate(Aggregator& aggregator)
+    {
+        sampler_.dropReplaced(*resultSet_.impl_);
+        aggregator.add(*resultSet_.impl_);
+        resultSet_.impl_->truncate(0);
+        sampler_.resultsTaken();
+    }
+
+    void QueryRunner::finishSubset(bool keep)
+    {
+        auto& results = *resultSet_.impl_;
+        if (!keep)
+        {
+            results.dropSubset();
+            return;
+        }
+
+        results.endSubset();
+        if (!sampler_.keepThinned(results)) results.truncate(results.size() - 1);
+    }
+
+    bool QueryRunner::accumulateCompressed(const DecodePrograms& programs,
+                                           const ExtractionPlan& plan,
+                                           const std::shared_ptr<Targets>& targets,
+                                           size_t numSubsets,
+                                           const uint8_t* data,
+                                           size_t numBits)
+    {
+        if (programs.compressedProgram == nullptr || programs.compressedTrace == nullptr)
+        {
+            return false;
+        }
+
+        // Check the layout with the first subset (NCEPLIB-bufr has it loaded). Only the first
+        // column is needed for that, the rest of the increments are skipped over.
+        {
+            auto reader = BitReader(data, numBits);
+            MessageColumns traceColumns;
+            if (!programs.compressedTrace->runCompressed(reader, numSubsets, 1, traceColumns) ||
+                !programs.compressedTrace->matches(*dataProvider_, traceColumns) ||
+                numBits - reader.position() >= MaxPaddingBits)
+            {
+                return false;
+            }
+        }
+
+        auto reader = BitReader(data, numBits);
+        MessageColumns columns;
+        if (!programs.compressedProgram->runCompressed(reader, numSubsets, numSubsets, columns))
+        {
+            return false;
+        }
+
+        auto& results = *resultSet_.impl_;
+        for (size_t subsetIdx = 1; subsetIdx < numSubsets; ++subsetIdx)
+        {
+            if (!sampler_.sample()) continue;
+
+            auto sink = ExtractionPlan::Sink(plan, results.beginSubset(targets));
+            for (const auto& entry : columns.entries)
+            {
+                if (entry.isCount)
+                {
+                    sink.count(entry.nodeId, entry.count);
+                }
+                else
+                {
+                    sink.value(entry.nodeId, columns.values[entry.valuesIdx + subsetIdx]);
+                }
+            }
+
+            finishSubset(sink.keep());
+        }
+
+        return true;
+    }
+
+    bool QueryRunner::findSubsetLayout(const DecodeProgram& trace,
+                                       const uint8_t* data,
+                                       size_t numBits,
+                                       SubsetLayout& layout,
+                                       size_t& nextPos) const
+    {
+        // NCEP messages, each subset starts with its length in bytes and is padded.
+        {
+            auto reader = BitReader(data, numBits);
+            const size_t subsetBits = reader.read(SubsetLengthBits) * 8;
+            if (trace.matches(*dataProvider_, reader) &&
+                subsetBits <= numBits &&
+                atSubsetPadding(reader, subsetBits))
+            {
+                layout = SubsetLayout::ByteCounted;
+                nextPos = subsetBits;
+                return true;
+            }
+        }
+
+        // Standard messages, the subsets follow each other directly.
+        {
+            auto reader = BitReader(data, numBits);
+            if (trace.matches(*dataProvider_, reader))
+            {
+                layout = SubsetLayout::Packed;
+                nextPos = reader.position();
+                return true;
+            }
+        }
+
+        return false;
     }
 
     std::shared_ptr<Targets> QueryRunner::getTargets()
     {
+        // The node ids change when NCEPLIB-bufr rebuilds its tables (ex: the file is rewound
+        // between the chunks of executeChunks, or another file is opened or closed), so
+        // everything made from the old ones has to be made again.
+        if (tableGeneration_ != FortranUnits::tableGeneration())
+        {
+            tableGeneration_ = FortranUnits::tableGeneration();
+            targetsCache_.clear();
+            programCache_.clear();
+            planCache_.clear();
+        }
+
         // Attempt to get targets from the cache
         if (targetsCache_.find(dataProvider_->getSubsetVariant()) != targetsCache_.end())
         {
             return targetsCache_.at(dataProvider_->getSubsetVariant());
         }
 
+        // Other files (or earlier runs) with the same tables may have found them already
+        const bool useSharedCache = TargetsCache::isEnabled();
+        uint64_t cacheKey = 0;
+        if (useSharedCache)
+        {
+            cacheKey = TargetsCache::keyFor(*dataProvider_, querySet_);
+            const auto entry = TargetsCache::get(cacheKey, querySet_);
+            if (entry != nullptr && typeInfoMatches(*entry->targets))
+            {
+                warnMissingTargets(*entry->targets);
+                targetsCache_.insert({dataProvider_->getSubsetVariant(), entry->targets});
+                programCache_.insert({dataProvider_->getSubsetVariant(), entry->programs});
+                addPlan(*entry->targets);
+                return entry->targets;
+            }
+        }
+
         auto table = SubsetTable(dataProvider_);
 
         const auto targets = std::make_shared<Targets>();
@@ -70,14 +370,6 @@ namespace bufr {
                 target->typeInfo = TypeInfo();
                 target->exportDimIdxs = {0};
                 targets->push_back(target);
-
-                // Print message to inform the user of the missing targets
-                log::warning() << "Warning: Query String ";
-                log::warning() << querySet_.queriesFor(name)[0].str();
-                log::warning() << " did not apply to subset ";
-                log::warning() << dataProvider_->getSubsetVariant().str();
-                log::warning() << std::endl;
-
                 continue;
             }
 
@@ -120,6 +412,80 @@ namespace bufr {
         // Cache the targets and masks we just found
         targetsCache_.insert({dataProvider_->getSubsetVariant(), targets});
 
+        // Compile the programs used to decode the subset data directly (see accumulateRemaining)
+        const auto lastNodeId = dataProvider_->getIsc(dataProvider_->getInode());
+        const auto& root = table.getRoot();
+        programCache_.insert({dataProvider_->getSubsetVariant(),
+                              {DecodeProgram::compile(root, lastNodeId, *targets),
+                               DecodeProgram::compileTrace(root, lastNodeId),
+                               DecodeProgram::compile(root, lastNodeId, *targets, true),
+                               DecodeProgram::compileTrace(root, lastNodeId, true)}});
+
+        addPlan(*targets);
+        warnMissingTargets(*targets);
+
+        if (useSharedCache)
+        {
+            TargetsCache::put(cacheKey,
+                              {targets, programCache_.at(dataProvider_->getSubsetVariant())});
+        }
+
         return targets;
     }
+
+    void QueryRunner::addPlan(const Targets& targets)
+    {
+        // A subset can only pass a value predicate if the query applies to it.
+        bool dropAll = false;
+        for (const auto& target : targets)
+        {
+            if (target->nodeIdx != 0) continue;
+
+            for (const auto& query : querySet_.queriesFor(target->name))
+            {
+                if (query.hasPredicate()) dropAll = true;
+            }
+        }
+
+        const auto firstNodeId = dataProvider_->getInode();
+        planCache_.insert({dataProvider_->getSubsetVariant(),
+                           std::make_shared<ExtractionPlan>(targets,
+                                                            firstNodeId,
+                                                            dataProvider_->getIsc(firstNodeId),
+                                                            dropAll)});
+    }
+
+    bool QueryRunner::typeInfoMatches(const Targets& targets) const
+    {
+        for (const auto& target : targets)
+        {
+            if (target->nodeIdx == 0) continue;
+
+            const auto typeInfo = dataProvider_->getTypeInfo(target->nodeIdx);
+            if (typeInfo.scale != target->typeInfo.scale ||
+                typeInfo.reference != target->typeInfo.reference ||
+                typeInfo.bits != target->typeInfo.bits ||
+                typeInfo.unit != target->typeInfo.unit)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void QueryRunner::warnMissingTargets(const Targets& targets) const
+    {
+        for (const auto& target : targets)
+        {
+            if (target->nodeIdx != 0) continue;
+
+            // Print message to inform the user of the missing targets
+            log::warning() << "Warning: Query String ";
+            log::warning() << target->queryStr;
+            log::warning() << " did not apply to subset ";
+            log::warning() << dataProvider_->getSubsetVariant().str();
+            log::warning() << std::endl;
+        }
+    }
 }  // namespace bufr
@@ -8,9 +8,14 @@
 #include <vector>
 
 #include "bufr/DataProvider.h"
+#include "bufr/MessageReader.h"
 #include "bufr/SubsetVariant.h"
 #include "bufr/QuerySet.h"
 #include "bufr/ResultSet.h"
+#include "Aggregator.h"
+#include "DecodeProgram.h"
+#include "ExtractionPlan.h"
+#include "SubsetSampler.h"
 #include "Target.h"
 
 namespace bufr {
@@ -26,19 +31,106 @@ namespace bufr {
                     const DataProviderType& dataProvider);
 
         /// \brief Run the queries against the currently open BUFR message subset. Collect the
-        /// results into the ResultSet.
+        /// results into the ResultSet (unless the subset is sampled out, see SubsetSampling).
         void accumulate();
 
+        /// \brief Decode the subsets that come after the currently open one (the first subset of
+        /// the message) directly from the message data and collect the results into the
+        /// ResultSet. Compressed messages are decoded for all the subsets at once. The decoding
+        /// is checked against the subset NCEPLIB-bufr just read, and nothing is collected unless
+        /// all the subsets could be decoded.
+        /// \param[in] header The headers of the message.
+        /// \param[in] msg Pointer to the start of the message.
+        /// \return True if the remaining subsets were collected.
+        bool accumulateRemaining(const MessageHeader& header, const uint8_t* msg);
+
+        /// \brief Amount of memory taken up by the data collected so far (not counting space
+        ///        that is reserved but still empty).
+        /// \return The size in bytes.
+        size_t collectedBytes() const;
+
+        /// \brief Move the data collected so far into a new ResultSet. The cached targets and
+        /// decode programs are kept, so the QueryRunner can carry on with the next messages.
+        /// \param reserveNext Size the buffers for the next messages like the ones taken (for
+        ///        when more chunks of about the same size follow).
+        /// \return The ResultSet with the collected data.
+        ResultSet takeResults(bool reserveNext = false);
+
+        /// \brief Fold the subsets collected so far into the aggregates and drop them, so the
+        /// memory used doesn't grow with the number of subsets.
+        /// \param[in, out] aggregator The aggregates to update.
+        void aggregate(Aggregator& aggregator);
+
      private:
         const QuerySet querySet_;
         ResultSet& resultSet_;
         const DataProviderType& dataProvider_;
 
+        // These hold NCEPLIB-bufr table node ids, so they are only good for the table
+        // generation they were made in (see FortranUnits::tableGeneration).
         std::unordered_map<SubsetVariant, std::shared_ptr<Targets>> targetsCache_;
+        std::unordered_map<SubsetVariant, DecodePrograms> programCache_;
+        std::unordered_map<SubsetVariant, std::shared_ptr<ExtractionPlan>> planCache_;
+        size_t tableGeneration_;
+
+        SubsetSampler sampler_;
+
+        /// \brief Collect the subsets after the first one (see accumulateRemaining).
+        bool collectRemaining(const MessageHeader& header, const uint8_t* msg);
+
+        /// \brief Finish the subset that is being collected, or drop it.
+        /// \param[in] keep Keep the subset (it passed the value predicates)? It can still be
+        ///            dropped by the grid thinning.
+        void finishSubset(bool keep);
 
         /// \brief Look for the list of targets for the currently active BUFR message subset that
         /// apply to the QuerySet and cache them.
         /// \param[in, out] targets The list of targets to populate.
         std::shared_ptr<Targets> getTargets();
+
+        /// \brief Make the extraction plan for the currently active subset variant.
+        /// \param[in] targets The targets for the subset variant.
+        void addPlan(const Targets& targets);
+
+        /// \brief Check that the type info of the targets (found in the TargetsCache) is what
+        /// NCEPLIB-bufr has for the currently active subset.
+        /// \param[in] targets The targets to check.
+        /// \return True if the type info of every target matches.
+        bool typeInfoMatches(const Targets& targets) const;
+
+        /// \brief Tell the user about the queries that didn't apply to the active subset.
+        /// \param[in] targets The targets for the active subset.
+        void warnMissingTargets(const Targets& targets) const;
+
+        /// \brief Decode all the subsets of a compressed message column by column and collect
+        /// the ones after the first subset into the ResultSet.
+        /// \param[in] programs The decode programs for the subset variant.
+        /// \param[in] plan The extraction plan for the subset variant.
+        /// \param[in] targets The targets for the subset variant.
+        /// \param[in] numSubsets The number of subsets in the message.
+        /// \param[in] data Pointer to the start of the section 4 data.
+        /// \param[in] numBits The number of bits of section 4 data.
+        /// \return True if the first subset decoded exactly like NCEPLIB-bufr decoded it and the
+        /// rest of the subsets were collected.
+        bool accumulateCompressed(const DecodePrograms& programs,
+                                  const ExtractionPlan& plan,
+                                  const std::shared_ptr<Targets>& targets,
+                                  size_t numSubsets,
+                                  const uint8_t* data,
+                                  size_t numBits);
+
+        /// \brief Work out where the subset after the first one starts by decoding the first
+        /// subset and comparing it to what NCEPLIB-bufr read.
+        /// \param[in] trace The trace program for the subset variant.
+        /// \param[in] data Pointer to the start of the subset data in section 4.
+        /// \param[in] numBits The number of bits of subset data.
+        /// \param[out] layout The layout of the subsets.
+        /// \param[out] nextPos The bit position of the second subset.
+        /// \return True if the first subset decoded exactly like NCEPLIB-bufr decoded it.
+        bool findSubsetLayout(const DecodeProgram& trace,
+                              const uint8_t* data,
+                              size_t numBits,
+                              SubsetLayout& layout,
+                              size_t& nextPos) const;
     };
 }  // namespace bufr
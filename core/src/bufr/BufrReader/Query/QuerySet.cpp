@@ -52,4 +52,64 @@ namespace bufr {
   {
     return impl_->queriesFor(name);
   }
+
+  void QuerySet::setTimeWindow(int start, int end)
+  {
+    impl_->setTimeWindow(start, end);
+  }
+
+  void QuerySet::addMessageType(int dataCategory, int dataSubCategory)
+  {
+    impl_->addMessageType(dataCategory, dataSubCategory);
+  }
+
+  bool QuerySet::filtersMessages() const
+  {
+    return impl_->filtersMessages();
+  }
+
+  bool QuerySet::includesMessage(int dataCategory, int dataSubCategory, int date) const
+  {
+    return impl_->includesMessage(dataCategory, dataSubCategory, date);
+  }
+
+  void QuerySet::setSampleStride(size_t stride)
+  {
+    auto sampling = impl_->sampling();
+    sampling.stride = stride;
+    impl_->setSampling(sampling);
+  }
+
+  void QuerySet::setSampleFraction(double fraction, uint64_t seed)
+  {
+    auto sampling = impl_->sampling();
+    sampling.fraction = fraction;
+    sampling.seed = seed;
+    impl_->setSampling(sampling);
+  }
+
+  void QuerySet::setGridThinning(const std::string& latitudeName,
+                                 const std::string& longitudeName,
+                                 double cellSize,
+                                 const std::string& qualityName,
+                                 bool lowerIsBetter)
+  {
+    auto sampling = impl_->sampling();
+    sampling.latitude = latitudeName;
+    sampling.longitude = longitudeName;
+    sampling.cellSize = cellSize;
+    sampling.quality = qualityName;
+    sampling.lowerIsBetter = lowerIsBetter;
+    impl_->setSampling(sampling);
+  }
+
+  void QuerySet::setSampling(const SubsetSampling& sampling)
+  {
+    impl_->setSampling(sampling);
+  }
+
+  const SubsetSampling& QuerySet::sampling() const
+  {
+    return impl_->sampling();
+  }
 }  // namespace bufr
@@ -1,6 +1,9 @@
 // (C) Copyright 2022 NOAA/NWS/NCEP/EMC
 
 #include <algorithm>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
 
 #include "QuerySetImpl.h"
 
@@ -107,4 +110,65 @@ namespace bufr {
     {
         return queryMap_.at(name);
     }
+
+    void QuerySetImpl::setTimeWindow(int start, int end)
+    {
+        if (start > end)
+        {
+            std::ostringstream errStr;
+            errStr << "The start of the time window (" << start << ") is after its end (";
+            errStr << end << ").";
+            throw eckit::BadParameter(errStr.str());
+        }
+
+        hasTimeWindow_ = true;
+        windowStart_ = start;
+        windowEnd_ = end;
+    }
+
+    void QuerySetImpl::addMessageType(int dataCategory, int dataSubCategory)
+    {
+        messageTypes_.push_back({dataCategory, dataSubCategory});
+    }
+
+    void QuerySetImpl::setSampling(const SubsetSampling& sampling)
+    {
+        std::ostringstream errStr;
+        if (sampling.stride == 0)
+        {
+            errStr << "The sample stride has to be at least 1.";
+        }
+        else if (!(sampling.fraction > 0 && sampling.fraction <= 1))
+        {
+            errStr << "The sample fraction (" << sampling.fraction << ") has to be in (0, 1].";
+        }
+        else if (sampling.cellSize < 0 ||
+                 (sampling.thins() && (sampling.latitude.empty() || sampling.longitude.empty())))
+        {
+            errStr << "Grid thinning needs a positive cell size and the names of the latitude ";
+            errStr << "and longitude queries.";
+        }
+
+        if (!errStr.str().empty()) throw eckit::BadParameter(errStr.str());
+
+        sampling_ = sampling;
+    }
+
+    bool QuerySetImpl::includesMessage(int dataCategory, int dataSubCategory, int date) const
+    {
+        if (hasTimeWindow_ && (date < windowStart_ || date > windowEnd_)) return false;
+
+        if (messageTypes_.empty()) return true;
+
+        for (const auto& messageType : messageTypes_)
+        {
+            if (messageType.first == dataCategory &&
+                (messageType.second < 0 || messageType.second == dataSubCategory))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
 }  // namespace bufr
@@ -7,8 +7,10 @@
 #include <set>
 #include <string>
 #include <map>
+#include <utility>
 
 #include "bufr/QueryParser.h"
+#include "bufr/QuerySet.h"
 
 namespace bufr {
     typedef std::set<std::string> Subsets;
@@ -43,11 +45,44 @@ namespace bufr {
         /// \return A vector of queries.
         std::vector<Query> queriesFor(const std::string& name) const;
 
+        /// \brief Only read the messages whose section 1 date is in the time window.
+        /// \param[in] start The start of the window in the form YYYYMMDDHH (inclusive).
+        /// \param[in] end The end of the window in the form YYYYMMDDHH (inclusive).
+        void setTimeWindow(int start, int end);
+
+        /// \brief Only read the messages with the given data category and sub-category.
+        /// \param[in] dataCategory The data category.
+        /// \param[in] dataSubCategory The local data sub-category (-1 for any).
+        void addMessageType(int dataCategory, int dataSubCategory);
+
+        /// \brief Is there a time window or a list of message types?
+        bool filtersMessages() const { return hasTimeWindow_ || !messageTypes_.empty(); }
+
+        /// \brief Should a message with the given section 1 data be read?
+        /// \param[in] dataCategory The data category of the message.
+        /// \param[in] dataSubCategory The local data sub-category of the message.
+        /// \param[in] date The date of the message in the form YYYYMMDDHH.
+        bool includesMessage(int dataCategory, int dataSubCategory, int date) const;
+
+        /// \brief Set the sampling options (they are checked first).
+        /// \param[in] sampling The sampling options.
+        void setSampling(const SubsetSampling& sampling);
+
+        /// \brief Get the sampling options.
+        const SubsetSampling& sampling() const { return sampling_; }
+
      private:
         std::unordered_map<std::string, std::vector<Query>> queryMap_;
         bool includesAllSubsets_;
         bool addHasBeenCalled_;
         const Subsets limitSubsets_;
         Subsets presentSubsets_;
+
+        bool hasTimeWindow_ = false;
+        int windowStart_ = 0;
+        int windowEnd_ = 0;
+        std::vector<std::pair<int, int>> messageTypes_;  // (category, sub-category or -1)
+
+        SubsetSampling sampling_;
     };
 }  // namespace bufr
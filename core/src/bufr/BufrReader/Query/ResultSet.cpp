@@ -20,4 +20,26 @@ namespace bufr {
         return impl_->get(fieldName, groupByFieldName, overrideType);
   }
 
+  std::vector<std::shared_ptr<DataObjectBase>>
+  ResultSet::getMany(const std::vector<FieldRequest>& fields, size_t numThreads) const
+  {
+        return impl_->getMany(fields, numThreads);
+  }
+
+  RaggedData ResultSet::getRagged(const std::string& fieldName,
+                                  const std::string& overrideType) const
+  {
+        return impl_->getRagged(fieldName, overrideType);
+  }
+
+  MemoryStats ResultSet::memoryStats() const
+  {
+        return impl_->memoryStats();
+  }
+
+  DecodeStats ResultSet::decodeStats() const
+  {
+        return impl_->decodeStats();
+  }
+
 }  // namespace bufr
@@ -5,164 +5,594 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "eckit/exception/Exceptions.h"
 
 #include "VectorMath.h"
 #include "bufr/DataObject.h"
 #include "../../DataObjectBuilder.h"
+#include "../../ThreadPool.h"
 
 
 namespace bufr {
+  namespace {
+    // What the assembly needs from a buffer, for the raw values (Data) and for values that are
+    // converted to the type of the DataObject as they are copied (std::vector<T>).
+
+    void initBuffer(Data& buffer, bool isLongStr, size_t size) {
+      buffer.isLongStr(isLongStr);
+      buffer.resize(size);
+    }
+
+    template <typename T>
+    void initBuffer(std::vector<T>& buffer, bool, size_t size) {
+      buffer.assign(size, DataObject<T>::missingValue());
+    }
+
+    bool isLongStr(const Data& buffer) { return buffer.isLongStr(); }
+
+    template <typename T>
+    bool isLongStr(const std::vector<T>&) { return false; }
+
+    void copyValues(Data& buffer, size_t outputOffset, const Data& values, size_t inputOffset,
+                    size_t numValues) {
+      if (values.isLongStr()) {
+        std::copy(values.value.strings.begin() + inputOffset,
+                  values.value.strings.begin() + inputOffset + numValues,
+                  buffer.value.strings.begin() + outputOffset);
+      } else {
+        std::copy(values.value.octets.begin() + inputOffset,
+                  values.value.octets.begin() + inputOffset + numValues,
+                  buffer.value.octets.begin() + outputOffset);
+      }
+    }
+
+    template <typename T>
+    void copyValues(std::vector<T>& buffer, size_t outputOffset, const Data& values,
+                    size_t inputOffset, size_t numValues) {
+      const auto* input = values.value.octets.data() + inputOffset;
+      auto* output      = buffer.data() + outputOffset;
+      for (size_t valueIdx = 0; valueIdx < numValues; ++valueIdx) {
+        output[valueIdx] = Data::isMissingOctet(input[valueIdx])
+                             ? DataObject<T>::missingValue()
+                             : static_cast<T>(input[valueIdx]);
+      }
+    }
+
+    void copyValue(Data& to, size_t toIdx, const Data& from, size_t fromIdx) {
+      if (from.isLongStr()) {
+        to.value.strings[toIdx] = from.value.strings[fromIdx];
+      } else {
+        to.value.octets[toIdx] = from.value.octets[fromIdx];
+      }
+    }
+
+    template <typename T>
+    void copyValue(std::vector<T>& to, size_t toIdx, const std::vector<T>& from, size_t fromIdx) {
+      to[toIdx] = from[fromIdx];
+    }
+  }  // namespace
+
   std::shared_ptr<DataObjectBase> ResultSetImpl::get(const std::string& fieldName,
                                                      const std::string& groupByFieldName,
                                                      const std::string& overrideType) const
 {
-    // Make sure we have accumulated frames otherwise something is wrong.
-    if (frames_.size() == 0)
+    // Make sure we have accumulated subsets otherwise something is wrong.
+    if (size() == 0)
     {
       throw eckit::BadValue("ResultSet has no data.");
     }
 
     // Get the metadata for the target
     const auto targetMetaData = analyzeTarget(fieldName);
+    const auto groupByMetaData = groupByFieldName.empty() ? details::TargetMetaDataPtr()
+                                                          : analyzeTarget(groupByFieldName);
+
+    return getField({fieldName, groupByFieldName, overrideType}, targetMetaData, groupByMetaData);
+  }
+
+  std::vector<std::shared_ptr<DataObjectBase>>
+  ResultSetImpl::getMany(const std::vector<FieldRequest>& fields, size_t numThreads) const {
+    if (size() == 0) {
+      throw eckit::BadValue("ResultSet has no data.");
+    }
+
+    // Analyze all the targets (and the group by fields) in one pass over the subsets.
+    std::vector<std::string> names;
+    std::vector<size_t> groupByIdxs(fields.size(), 0);
+    for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx) {
+      names.push_back(fields[fieldIdx].name);
+    }
+
+    for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx) {
+      if (fields[fieldIdx].groupByFieldName.empty()) continue;
+
+      groupByIdxs[fieldIdx] = names.size();
+      names.push_back(fields[fieldIdx].groupByFieldName);
+    }
 
-    // Assemble Result Data
-    auto data = assembleData(targetMetaData);
+    ThreadPool pool(numThreads);
+    const auto metaData = analyzeTargets(names, &pool);
+    const auto groupByMetaData = [&](size_t fieldIdx) {
+      return fields[fieldIdx].groupByFieldName.empty() ? details::TargetMetaDataPtr()
+                                                       : metaData[groupByIdxs[fieldIdx]];
+    };
+
+    // The metadata is all worked out, so the fields only read the ResultSet from here on and
+    // can be assembled at the same time. Each one goes in its own slot. Fields that are big
+    // enough to be split between the threads are done one after the other, and the rest are
+    // spread over the threads a field at a time.
+    std::vector<std::shared_ptr<DataObjectBase>> objects(fields.size());
+    std::vector<size_t> smallFieldIdxs;
+    for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx) {
+      if (size() * rowLength(*metaData[fieldIdx]) < 2 * MinBlockValues) {
+        smallFieldIdxs.push_back(fieldIdx);
+        continue;
+      }
 
-    if (!groupByFieldName.empty()) {
-      applyGroupBy(data, targetMetaData, groupByFieldName);
+      objects[fieldIdx] = getField(fields[fieldIdx], metaData[fieldIdx], groupByMetaData(fieldIdx),
+                                   &pool);
     }
 
-    auto object = DataObjectBuilder::make(fieldName,
-                                          groupByFieldName,
-                                          targetMetaData->typeInfo,
-                                          overrideType,
-                                          data.buffer,
-                                          data.dims,
-                                          data.dimPaths);
+    pool.run(smallFieldIdxs.size(), [&](size_t taskIdx) {
+      const auto fieldIdx = smallFieldIdxs[taskIdx];
+      objects[fieldIdx] = getField(fields[fieldIdx], metaData[fieldIdx], groupByMetaData(fieldIdx));
+    });
+
+    return objects;
+  }
+
+  std::shared_ptr<DataObjectBase>
+  ResultSetImpl::getField(const FieldRequest& field,
+                          const details::TargetMetaDataPtr& targetMetaData,
+                          const details::TargetMetaDataPtr& groupByMetaData,
+                          ThreadPool* pool) const {
+    std::shared_ptr<DataObjectBase> object;
+    DataObjectBuilder::visitType(field.name,
+                                 targetMetaData->typeInfo,
+                                 field.overrideType,
+                                 [&](auto tag) {
+      typedef typename decltype(tag)::type T;
+      object = makeField<T>(field, targetMetaData, groupByMetaData, pool);
+    });
 
     return object;
   }
 
-  details::TargetMetaDataPtr ResultSetImpl::analyzeTarget(const std::string& name) const {
-    auto metaData       = std::make_shared<details::TargetMetaData>();
-    metaData->targetIdx = frames_.front().getTargetIdx(name);
-    metaData->missingFrames.resize(frames_.size(), false);
+  template <typename T>
+  std::shared_ptr<DataObjectBase>
+  ResultSetImpl::makeField(const FieldRequest& field,
+                           const details::TargetMetaDataPtr& targetMetaData,
+                           const details::TargetMetaDataPtr& groupByMetaData,
+                           ThreadPool* pool) const {
+    if constexpr (std::is_same<T, std::string>::value) {
+      auto data = assembleData<Data>(targetMetaData, pool);
+      if (groupByMetaData) {
+        applyGroupBy(data, targetMetaData, groupByMetaData);
+      }
 
-    // Loop through the frames to determine the overall parameters for the result data. We will
-    // want to find the dimension information and determine if the array could be jagged which
-    // means we will need to do extra work later (otherwise we can quickly copy the data).
-    size_t frameIdx = 0;
-    for (const auto& frame : frames_) {
-      const auto& target = frame.targetAtIdx(metaData->targetIdx);
+      return DataObjectBuilder::make(field.name,
+                                     field.groupByFieldName,
+                                     targetMetaData->typeInfo,
+                                     field.overrideType,
+                                     data.buffer,
+                                     data.dims,
+                                     data.dimPaths);
+    } else {
+      auto data = assembleData<std::vector<T>>(targetMetaData, pool);
+      if (groupByMetaData) {
+        applyGroupBy(data, targetMetaData, groupByMetaData);
+      }
 
-      if (target->path.size() == 0) {
-        metaData->missingFrames[frameIdx] = true;
-        ++frameIdx;
+      return DataObjectBuilder::make<T>(std::move(data.buffer),
+                                        field.name,
+                                        field.groupByFieldName,
+                                        data.dims,
+                                        "",
+                                        data.dimPaths);
+    }
+  }
+
+  RaggedData ResultSetImpl::getRagged(const std::string& fieldName,
+                                      const std::string& overrideType) const {
+    if (size() == 0) {
+      throw eckit::BadValue("ResultSet has no data.");
+    }
+
+    const auto metaData = analyzeTarget(fieldName);
+    const auto numDims  = metaData->dims.size();
+    const auto& column  = columns_[metaData->targetIdx];
+
+    auto data = details::RaggedResultData();
+    data.buffer.isLongStr(metaData->typeInfo.isLongString());
+    data.buffer.reserve(column.values().size());
+    data.offsets.resize(numDims - 1, std::vector<size_t>{0});
+
+    // The dimension of each count level (or -1), for each subset variant.
+    std::vector<std::vector<int>> levelDims(targets_.size());
+
+    for (size_t subsetIdx = 0; subsetIdx < size(); ++subsetIdx) {
+      const auto& target = targetFor(subsetIdx, metaData->targetIdx);
+
+      // Every subset is an element of the first dimension, even if it has no data.
+      addRaggedElement(data, 0);
+
+      // Subset variants with a different number of dimensions have nowhere to put their data.
+      if (metaData->missingSubsets[subsetIdx] ||
+          target->exportDimIdxs.size() != numDims ||
+          column.values().isLongStr() != data.buffer.isLongStr()) {
         continue;
       }
 
-      if (target->path.size() - 1 > metaData->rawDims.size()) {
-        metaData->rawDims.resize(target->path.size() - 1, 0);
+      auto& dims = levelDims[subsetTargets_[subsetIdx]];
+      if (dims.empty()) {
+        dims.resize(target->path.size() - 1, -1);
+        for (size_t dimIdx = 0; dimIdx < target->exportDimIdxs.size(); ++dimIdx) {
+          dims[target->exportDimIdxs[dimIdx]] = static_cast<int>(dimIdx);
+        }
       }
 
-      // Resize the dims if necessary
-      // Jagged if the dims need a resize (skip first one)
-      if (target->exportDimIdxs.size() > metaData->dims.size()) {
-        metaData->dims.resize(target->exportDimIdxs.size(), 1);
-        metaData->filteredDims.resize(target->exportDimIdxs.size(), 0);
+      size_t inputOffset = column.valuesOffset(subsetIdx);
+      std::vector<size_t> cursors(dims.size(), 0);
+      copyRaggedLevel(data, column, subsetIdx, dims, inputOffset,
+                      inputOffset + column.numValues(subsetIdx), cursors, 0, 1);
+    }
+
+    RaggedData result;
+    result.values = DataObjectBuilder::make(fieldName,
+                                            "",
+                                            metaData->typeInfo,
+                                            overrideType,
+                                            data.buffer,
+                                            {static_cast<int>(data.buffer.size())},
+                                            metaData->dimPaths);
+    result.offsets = std::move(data.offsets);
+
+    return result;
+  }
+
+  std::vector<TargetColumn>& ResultSetImpl::beginSubset(const std::shared_ptr<Targets>& targets) {
+    // Subsets of the same variant usually come one after the other.
+    auto targetsIdx = targets_.size();
+    for (size_t idx = targets_.size(); idx > 0; --idx) {
+      if (targets_[idx - 1] == targets) {
+        targetsIdx = idx - 1;
+        break;
       }
+    }
 
-      // Capture the dimensional information
-      auto pathIdx      = 0;
-      auto exportIdxIdx = 0;
-      for (auto p = target->path.begin(); p != target->path.end() - 1; ++p) {
-        const auto& counts = frame[p->nodeId].counts;
-        if (counts.empty()) {
-          metaData->missingFrames[frameIdx] = true;
-          break;
-        }
+    if (targetsIdx == targets_.size()) targets_.push_back(targets);
+    if (columns_.empty()) columns_.resize(targets->size());
+    metaDataCache_.clear();
+
+    // The last path component is the element itself, it has no counts.
+    for (size_t targetIdx = 0; targetIdx < targets->size(); ++targetIdx) {
+      const auto& path = (*targets)[targetIdx]->path;
+      if (!path.empty()) columns_[targetIdx].addLevels(path.size() - 1);
+    }
+
+    subsetTargets_.push_back(static_cast<uint32_t>(targetsIdx));
+    return columns_;
+  }
+
+  void ResultSetImpl::endSubset() {
+    for (auto& column : columns_) {
+      column.endSubset();
+    }
+  }
+
+  void ResultSetImpl::dropSubset() {
+    subsetTargets_.pop_back();
+    for (auto& column : columns_) {
+      column.truncate(column.size());
+    }
+  }
+
+  void ResultSetImpl::truncate(size_t numSubsets) {
+    if (numSubsets >= size()) return;
+
+    metaDataCache_.clear();
+
+    subsetTargets_.resize(numSubsets);
+    for (auto& column : columns_) {
+      column.truncate(numSubsets);
+    }
+  }
+
+  void ResultSetImpl::keepSubsets(const std::vector<bool>& keep) {
+    metaDataCache_.clear();
+
+    size_t numKept = 0;
+    for (size_t subsetIdx = 0; subsetIdx < size(); ++subsetIdx) {
+      if (keep[subsetIdx]) subsetTargets_[numKept++] = subsetTargets_[subsetIdx];
+    }
+
+    subsetTargets_.resize(numKept);
+    for (auto& column : columns_) {
+      column.keepSubsets(keep);
+    }
+  }
+
+  void ResultSetImpl::append(const ResultSetImpl& other) {
+    decodeStats_.numNativeMessages += other.decodeStats_.numNativeMessages;
+    decodeStats_.numFallbackMessages += other.decodeStats_.numFallbackMessages;
+
+    if (other.size() == 0) return;
+
+    metaDataCache_.clear();
+    if (columns_.empty()) columns_.resize(other.columns_.size());
+
+    if (columns_.size() != other.columns_.size()) {
+      std::ostringstream errStr;
+      errStr << "Can't combine the results of different queries.";
+      throw eckit::BadValue(errStr.str());
+    }
+
+    // The targets stay shared, so they only have to be remapped.
+    std::vector<uint32_t> targetsIdxs(other.targets_.size());
+    for (size_t idx = 0; idx < other.targets_.size(); ++idx) {
+      const auto targetsIt = std::find(targets_.begin(), targets_.end(), other.targets_[idx]);
+      targetsIdxs[idx] = static_cast<uint32_t>(targetsIt - targets_.begin());
+      if (targetsIt == targets_.end()) targets_.push_back(other.targets_[idx]);
+    }
+
+    subsetTargets_.reserve(size() + other.size());
+    for (const auto targetsIdx : other.subsetTargets_) {
+      subsetTargets_.push_back(targetsIdxs[targetsIdx]);
+    }
+
+    for (size_t targetIdx = 0; targetIdx < columns_.size(); ++targetIdx) {
+      columns_[targetIdx].append(other.columns_[targetIdx]);
+    }
+  }
+
+  void ResultSetImpl::reserve(const ResultSetImpl& other) {
+    if (columns_.empty()) columns_.resize(other.columns_.size());
+    if (columns_.size() != other.columns_.size()) return;
+
+    subsetTargets_.reserve(other.size());
+    for (size_t targetIdx = 0; targetIdx < columns_.size(); ++targetIdx) {
+      columns_[targetIdx].reserve(other.columns_[targetIdx]);
+    }
+  }
+
+  MemoryStats ResultSetImpl::memoryStats() const {
+    MemoryStats stats;
+    stats.numSubsets = size();
+    stats.numBuffers = 1;
+    stats.usedBytes = sizeof(ResultSetImpl) + subsetTargets_.size() * sizeof(uint32_t);
+    stats.reservedBytes = sizeof(ResultSetImpl) + subsetTargets_.capacity() * sizeof(uint32_t);
+
+    for (const auto& column : columns_) {
+      column.addMemoryStats(stats);
+    }
+
+    return stats;
+  }
+
+  size_t ResultSetImpl::targetIdx(const std::string& name) const {
+    const auto& targets = *targets_.front();
+    for (size_t idx = 0; idx < targets.size(); ++idx) {
+      if (targets[idx]->name == name) return idx;
+    }
+
+    std::ostringstream errStr;
+    errStr << "The ResultSet has no field called " << name << ".";
+    throw eckit::BadParameter(errStr.str());
+  }
+
+  details::TargetMetaDataPtr ResultSetImpl::analyzeTarget(const std::string& name) const {
+    return analyzeTargets({name}).front();
+  }
+
+  std::vector<details::TargetMetaDataPtr>
+  ResultSetImpl::analyzeTargets(const std::vector<std::string>& names, ThreadPool* pool) const {
+    // The targets that haven't been analyzed yet are all done in the same pass over the subsets.
+    std::unordered_map<std::string, details::TargetMetaDataPtr> newMetaData;
+    std::unordered_map<std::string, details::TargetMetaDataPtr> cachedMetaData;
+    std::vector<details::TargetMetaDataPtr> toAnalyze;
+    for (const auto& name : names) {
+      if (newMetaData.count(name) > 0 || cachedMetaData.count(name) > 0) continue;
+      if (auto cached = metaDataCache_.find(name)) {
+        cachedMetaData.insert({name, cached});
+        continue;
+      }
+
+      auto metaData       = std::make_shared<details::TargetMetaData>();
+      metaData->targetIdx = targetIdx(name);
+      metaData->missingSubsets.resize(size(), false);
+      newMetaData.insert({name, metaData});
+      toAnalyze.push_back(metaData);
+    }
 
-        const auto maxCount = std::max(max(counts), 1);
-        if (maxCount > metaData->rawDims[pathIdx]) {
-          metaData->rawDims[pathIdx] = maxCount;
+    // Loop through the subsets to determine the overall parameters for the result data. We will
+    // want to find the dimension information and determine if the array could be jagged which
+    // means we will need to do extra work later (otherwise we can quickly copy the data).
+    if (pool == nullptr || pool->numBlocks(size(), MinBlockSubsets) < 2) {
+      for (size_t subsetIdx = 0; subsetIdx < size() && !toAnalyze.empty(); ++subsetIdx) {
+        for (const auto& metaData : toAnalyze) {
+          metaData->missingSubsets[subsetIdx] = !analyzeCounts(*metaData, subsetIdx);
+        }
+      }
+    } else if (!toAnalyze.empty()) {
+      // Each block of subsets finds the dimensions in its own copy of the metadata, and the
+      // copies are merged afterwards (each subset has its own missingSubsets entry).
+      std::vector<std::vector<details::TargetMetaData>> blockMetaData(
+        pool->numBlocks(size(), MinBlockSubsets));
+
+      pool->runBlocks(size(), MinBlockSubsets, [&](size_t blockIdx, size_t begin, size_t end) {
+        auto& partial = blockMetaData[blockIdx];
+        partial.resize(toAnalyze.size());
+        for (size_t targetNum = 0; targetNum < toAnalyze.size(); ++targetNum) {
+          partial[targetNum].targetIdx = toAnalyze[targetNum]->targetIdx;
         }
 
-        if (target->exportDimIdxs.size() - 1 < static_cast<size_t>(exportIdxIdx))
-        {
-          ++pathIdx;
-          continue;
+        for (size_t subsetIdx = begin; subsetIdx < end; ++subsetIdx) {
+          for (size_t targetNum = 0; targetNum < toAnalyze.size(); ++targetNum) {
+            toAnalyze[targetNum]->missingSubsets[subsetIdx]
+              = !analyzeCounts(partial[targetNum], subsetIdx);
+          }
         }
+      });
 
-        if (target->exportDimIdxs[exportIdxIdx] != pathIdx)
-        {
-          ++pathIdx;
-          continue;
+      for (const auto& partial : blockMetaData) {
+        for (size_t targetNum = 0; targetNum < toAnalyze.size(); ++targetNum) {
+          mergeDims(*toAnalyze[targetNum], partial[targetNum]);
         }
+      }
+    }
 
-        const auto newDimVal = std::max(metaData->dims[exportIdxIdx], std::max(max(counts), 1));
+    for (size_t subsetIdx = 0; subsetIdx < size() && !toAnalyze.empty(); ++subsetIdx) {
+      for (const auto& metaData : toAnalyze) {
+        analyzeType(*metaData, subsetIdx);
+      }
+    }
 
-        metaData->dims[exportIdxIdx] = newDimVal;
+    // If another thread analyzed the same target meanwhile, its (identical) result is kept.
+    for (const auto& metaData : newMetaData) {
+      if (metaData.second->dimPaths.empty()) {
+        metaData.second->dimPaths = {Query()};
+      }
 
-        // Capture the filtered dimension information
-        if (!p->queryComponent->filter.empty()) {
-          metaData->filteredDims[exportIdxIdx]
-            = std::max(metaData->filteredDims[exportIdxIdx],
-                       static_cast<int>(p->queryComponent->filter.size()));
-        }
+      cachedMetaData.insert({metaData.first,
+                             metaDataCache_.insert(metaData.first, metaData.second)});
+    }
 
-        pathIdx++;
-        exportIdxIdx++;
+    std::vector<details::TargetMetaDataPtr> metaData;
+    metaData.reserve(names.size());
+    for (const auto& name : names) {
+      metaData.push_back(cachedMetaData.at(name));
+    }
+
+    return metaData;
+  }
+
+  bool ResultSetImpl::analyzeCounts(details::TargetMetaData& metaData, size_t subsetIdx) const {
+    const auto& target = targetFor(subsetIdx, metaData.targetIdx);
+    const auto& column = columns_[metaData.targetIdx];
+
+    if (target->path.size() == 0) {
+      return false;
+    }
+
+    if (target->path.size() - 1 > metaData.rawDims.size()) {
+      metaData.rawDims.resize(target->path.size() - 1, 0);
+    }
+
+    // Resize the dims if necessary
+    // Jagged if the dims need a resize (skip first one)
+    if (target->exportDimIdxs.size() > metaData.dims.size()) {
+      metaData.dims.resize(target->exportDimIdxs.size(), 1);
+    }
+
+    // Capture the dimensional information
+    auto pathIdx      = 0;
+    auto exportIdxIdx = 0;
+    for (auto p = target->path.begin(); p != target->path.end() - 1; ++p) {
+      const auto counts = column.counts(pathIdx, subsetIdx);
+      if (counts.empty()) {
+        return false;
       }
 
-      // Fill in the type information
-      metaData->typeInfo.reference
-        = std::min(metaData->typeInfo.reference, target->typeInfo.reference);
-      metaData->typeInfo.bits = std::max(metaData->typeInfo.bits, target->typeInfo.bits);
+      // Filtered repeats were dropped as they were collected, but every filter index keeps
+      // its place in the result even when no subset got that far.
+      auto maxCount = std::max(*std::max_element(counts.begin(), counts.end()), 1);
+      if (p->type == TargetComponent::Type::Repeat && !p->queryComponent->filter.empty()) {
+        maxCount = std::max(maxCount, static_cast<int>(p->queryComponent->filter.size()));
+      }
 
-      if (std::abs(target->typeInfo.scale) > metaData->typeInfo.scale) {
-        metaData->typeInfo.scale = target->typeInfo.scale;
+      if (maxCount > metaData.rawDims[pathIdx]) {
+        metaData.rawDims[pathIdx] = maxCount;
       }
 
-      if (metaData->typeInfo.unit.empty()) metaData->typeInfo.unit = target->typeInfo.unit;
+      if (target->exportDimIdxs.size() - 1 < static_cast<size_t>(exportIdxIdx))
+      {
+        ++pathIdx;
+        continue;
+      }
 
-      // Fill in the dimPaths data
-      if (!target->dimPaths.empty() && metaData->dimPaths.size() < target->dimPaths.size()) {
-        metaData->dimPaths = target->dimPaths;
+      if (target->exportDimIdxs[exportIdxIdx] != pathIdx)
+      {
+        ++pathIdx;
+        continue;
       }
 
-      ++frameIdx;
+      const auto newDimVal = std::max(metaData.dims[exportIdxIdx], maxCount);
+
+      metaData.dims[exportIdxIdx] = newDimVal;
+
+      pathIdx++;
+      exportIdxIdx++;
     }
 
-    if (metaData->dimPaths.empty()) {
-      metaData->dimPaths = {Query()};
+    return true;
+  }
+
+  void ResultSetImpl::analyzeType(details::TargetMetaData& metaData, size_t subsetIdx) const {
+    const auto& target = targetFor(subsetIdx, metaData.targetIdx);
+    if (target->path.size() == 0) {
+      return;
     }
 
-    // Fill the filtered dims array with the raw dims for elements that are not filtered
-    for (size_t dimIdx = 0; dimIdx < metaData->filteredDims.size(); ++dimIdx) {
-      if (metaData->filteredDims[dimIdx] == 0) {
-        metaData->filteredDims[dimIdx] = metaData->dims[dimIdx];
-      }
+    // Fill in the type information
+    metaData.typeInfo.reference
+      = std::min(metaData.typeInfo.reference, target->typeInfo.reference);
+    metaData.typeInfo.bits = std::max(metaData.typeInfo.bits, target->typeInfo.bits);
+
+    if (std::abs(target->typeInfo.scale) > metaData.typeInfo.scale) {
+      metaData.typeInfo.scale = target->typeInfo.scale;
     }
 
-    return metaData;
+    if (metaData.typeInfo.unit.empty()) metaData.typeInfo.unit = target->typeInfo.unit;
+
+    // Fill in the dimPaths data
+    if (!target->dimPaths.empty() && metaData.dimPaths.size() < target->dimPaths.size()) {
+      metaData.dimPaths = target->dimPaths;
+    }
   }
 
-  details::ResultData ResultSetImpl::assembleData(const details::TargetMetaDataPtr& metaData) const {
+  void ResultSetImpl::mergeDims(details::TargetMetaData& metaData,
+                                const details::TargetMetaData& other) {
+    // Same fill values as analyzeCounts uses when a longer target path comes along.
+    if (other.rawDims.size() > metaData.rawDims.size()) {
+      metaData.rawDims.resize(other.rawDims.size(), 0);
+    }
+
+    for (size_t dimIdx = 0; dimIdx < other.rawDims.size(); ++dimIdx) {
+      metaData.rawDims[dimIdx] = std::max(metaData.rawDims[dimIdx], other.rawDims[dimIdx]);
+    }
+
+    if (other.dims.size() > metaData.dims.size()) {
+      metaData.dims.resize(other.dims.size(), 1);
+    }
+
+    for (size_t dimIdx = 0; dimIdx < other.dims.size(); ++dimIdx) {
+      metaData.dims[dimIdx] = std::max(metaData.dims[dimIdx], other.dims[dimIdx]);
+    }
+  }
+
+  size_t ResultSetImpl::rowLength(const details::TargetMetaData& metaData) {
     int rowLength = 1;
-    for (size_t dimIdx = 1; dimIdx < metaData->rawDims.size(); ++dimIdx) {
-      rowLength *= metaData->rawDims[dimIdx];
+    for (size_t dimIdx = 1; dimIdx < metaData.rawDims.size(); ++dimIdx) {
+      rowLength *= metaData.rawDims[dimIdx];
     }
 
     // need to preserve one spot for the MissingValue even if there is no data
-    rowLength = std::max(rowLength, 1);
+    return static_cast<size_t>(std::max(rowLength, 1));
+  }
+
+  template <typename Buffer>
+  details::ResultDataOf<Buffer>
+  ResultSetImpl::assembleData(const details::TargetMetaDataPtr& metaData,
+                              ThreadPool* pool) const {
+    const auto rowLength = ResultSetImpl::rowLength(*metaData);
 
     // Allocate the output data
-    auto totalRows = frames_.size();
-    auto data      = details::ResultData();
-    data.buffer.isLongStr(metaData->typeInfo.isLongString());
-    data.buffer.resize(totalRows * rowLength);
+    auto totalRows = size();
+    auto data      = details::ResultDataOf<Buffer>();
+    initBuffer(data.buffer, metaData->typeInfo.isLongString(), totalRows * rowLength);
     data.dims     = metaData->dims;
     data.rawDims  = metaData->rawDims;
     data.dimPaths = metaData->dimPaths;
@@ -171,111 +601,138 @@ namespace bufr {
     data.dims[0]    = totalRows;
     data.rawDims[0] = totalRows;
 
-    bool needsFiltering = false;
-
-    // Copy the data fragments into the raw data array.
-    for (size_t frameIdx = 0; frameIdx < frames_.size(); ++frameIdx) {
-      if (metaData->missingFrames[frameIdx]) {
-        continue;
-      }
-
-      const auto& frame  = frames_[frameIdx];
-      const auto& target = frame.targetAtIdx(metaData->targetIdx);
-      copyData(data, frame, target, frameIdx * rowLength);
-
-      if (target->usesFilters) needsFiltering = true;
-    }
-
-    if (needsFiltering) {
-      int filteredRowLength = 1;
-      for (size_t dimIdx = 1; dimIdx < metaData->filteredDims.size(); ++dimIdx) {
-        filteredRowLength *= metaData->filteredDims[dimIdx];
-      }
-
-      auto filteredData = details::ResultData();
-      filteredData.buffer.isLongStr(metaData->typeInfo.isLongString());
-      filteredData.buffer.resize(totalRows * filteredRowLength);
-
-      for (size_t frameIdx = 0; frameIdx < frames_.size(); ++frameIdx) {
-        const auto& frame  = frames_[frameIdx];
-        const auto& target = frame.targetAtIdx(metaData->targetIdx);
-
-        size_t inputOffset  = frameIdx * rowLength;
-        size_t outputOffset = frameIdx * filteredRowLength;
-        size_t maxDepth     = target->path.size() - 1;
+    // Copy the data of each subset into its row of the data array.
+    const auto& column = columns_[metaData->targetIdx];
+    const auto copyRows = [&](size_t begin, size_t end) {
+      for (size_t subsetIdx = begin; subsetIdx < end; ++subsetIdx) {
+        if (metaData->missingSubsets[subsetIdx]) {
+          continue;
+        }
 
-        copyFilteredData(filteredData, data, target, inputOffset, outputOffset, 1, maxDepth,
-                         target->filterDataList, false);
+        const auto& target = targetFor(subsetIdx, metaData->targetIdx);
+        copyData(data, column, subsetIdx, target, subsetIdx * rowLength);
       }
+    };
 
-      filteredData.dimPaths = metaData->dimPaths;
-      filteredData.dims     = metaData->filteredDims;
-      filteredData.dims[0]  = data.dims[0];
-
-      data = std::move(filteredData);
+    if (pool == nullptr) {
+      copyRows(0, totalRows);
+    } else {
+      pool->runBlocks(totalRows, std::max<size_t>(1, MinBlockValues / rowLength),
+                      [&](size_t, size_t begin, size_t end) { copyRows(begin, end); });
     }
 
     return data;
   }
 
-  void ResultSetImpl::copyData(details::ResultData& data, const Frame& frame, const TargetPtr& target,
-                           size_t outputOffset) const {
-    size_t inputOffset = 0;
-    size_t dimIdx      = 0;
-    size_t countNumber = 1;
-    size_t countOffset = 0;
-
-    _copyData(data, frame, target, outputOffset, inputOffset, dimIdx, countNumber, countOffset);
+  template <typename Buffer>
+  void ResultSetImpl::copyData(details::ResultDataOf<Buffer>& data,
+                               const TargetColumn& column,
+                               size_t subsetIdx,
+                               const TargetPtr& target,
+                               size_t outputOffset) const {
+    const auto numValues = column.numValues(subsetIdx);
+    if (numValues == 0 || column.values().isLongStr() != isLongStr(data.buffer)) return;
+
+    size_t inputOffset = column.valuesOffset(subsetIdx);
+    std::vector<size_t> cursors(target->path.size() - 1, 0);
+    copyLevel(data, column, subsetIdx, target, outputOffset, inputOffset, inputOffset + numValues,
+              cursors, 0, 1);
   }
 
-  void ResultSetImpl::_copyData(details::ResultData& data, const Frame& frame,
-                            const TargetPtr& target, size_t& outputOffset, size_t& inputOffset,
-                            const size_t dimIdx, const size_t countNumber,
-                            const size_t countOffset) const {
+  template <typename Buffer>
+  void ResultSetImpl::copyLevel(details::ResultDataOf<Buffer>& data,
+                                const TargetColumn& column,
+                                size_t subsetIdx,
+                                const TargetPtr& target,
+                                size_t outputOffset,
+                                size_t& inputOffset,
+                                size_t inputEnd,
+                                std::vector<size_t>& cursors,
+                                size_t dimIdx,
+                                size_t countNumber) const {
     size_t totalDimSize = 1;
     for (size_t i = dimIdx; i < data.rawDims.size(); ++i) {
       totalDimSize *= data.rawDims[i];
     }
 
-    if (!totalDimSize || dimIdx > data.rawDims.size() - 1 || frame[target->nodeIdx].data.empty())
-      return;
+    if (!totalDimSize || dimIdx > data.rawDims.size() - 1) return;
 
-    const auto& counts = frame[target->path[dimIdx].nodeId].counts;
-    if (counts.empty()) {
-      outputOffset += totalDimSize;
-      return;
-    }
-
-    size_t newOffset = 0;
-    for (size_t countIdx = 0; countIdx < countNumber; ++countIdx) {
-      const auto& count = counts[countIdx + countOffset];
-      if (count == 0) {
-        outputOffset += totalDimSize;
-        continue;
-      }
+    // The counts of a level are listed in order, one for each element of the level above, so
+    // the next count to use is simply the one after the last one used.
+    const auto counts = column.counts(dimIdx, subsetIdx);
+    auto& cursor      = cursors[dimIdx];
+    for (size_t countIdx = 0; countIdx < countNumber && cursor < counts.size(); ++countIdx) {
+      const auto count        = static_cast<size_t>(std::max(counts[cursor++], 0));
+      const auto countsOffset = outputOffset + countIdx * totalDimSize;
+      if (count == 0) continue;
 
       // When we reach the last layer of counts then copy the data
       // Ignore the subset path element (reason for -2)
       if (dimIdx == target->path.size() - 2) {
-        const auto& fragment = frame[target->nodeIdx].data;
+        const auto numValues = std::min(count, inputEnd - inputOffset);
+        copyValues(data.buffer, countsOffset, column.values(), inputOffset, numValues);
+        inputOffset += numValues;
+      } else {
+        copyLevel(data, column, subsetIdx, target, countsOffset, inputOffset, inputEnd, cursors,
+                  dimIdx + 1, count);
+      }
+    }
+  }
 
-        if (fragment.isLongStr()) {
-          std::copy(fragment.value.strings.begin() + inputOffset,
-                    fragment.value.strings.begin() + inputOffset + count,
-                    data.buffer.value.strings.begin() + outputOffset);
-        } else {
-          std::copy(fragment.value.octets.begin() + inputOffset,
-                    fragment.value.octets.begin() + inputOffset + count,
-                    data.buffer.value.octets.begin() + outputOffset);
+  void ResultSetImpl::copyRaggedLevel(details::RaggedResultData& data,
+                                      const TargetColumn& column,
+                                      size_t subsetIdx,
+                                      const std::vector<int>& levelDims,
+                                      size_t& inputOffset,
+                                      size_t inputEnd,
+                                      std::vector<size_t>& cursors,
+                                      size_t level,
+                                      size_t countNumber) const {
+    const auto counts      = column.counts(level, subsetIdx);
+    const auto& values     = column.values();
+    const bool isLastLevel = (level == levelDims.size() - 1);
+
+    auto& cursor = cursors[level];
+    for (size_t countIdx = 0; countIdx < countNumber && cursor < counts.size(); ++countIdx) {
+      const auto count = static_cast<size_t>(std::max(counts[cursor++], 0));
+      for (size_t repeatIdx = 0; repeatIdx < count; ++repeatIdx) {
+        // The element for the subset itself was added by getRagged.
+        if (level > 0 && levelDims[level] >= 0) {
+          addRaggedElement(data, static_cast<size_t>(levelDims[level]));
         }
 
-        inputOffset += count;
-        outputOffset += totalDimSize;
-      } else {
-        _copyData(data, frame, target, outputOffset, inputOffset, dimIdx + 1, count, newOffset);
+        if (!isLastLevel) {
+          copyRaggedLevel(data, column, subsetIdx, levelDims, inputOffset, inputEnd, cursors,
+                          level + 1, 1);
+          continue;
+        }
+
+        if (inputOffset == inputEnd) continue;
+
+        if (!data.valueSet) {
+          if (values.isLongStr()) {
+            data.buffer.value.strings.back() = values.value.strings[inputOffset];
+          } else {
+            data.buffer.value.octets.back() = values.value.octets[inputOffset];
+          }
+
+          data.valueSet = true;
+        }
+
+        inputOffset++;
       }
+    }
+  }
 
-      newOffset++;
+  void ResultSetImpl::addRaggedElement(details::RaggedResultData& data, size_t dimIdx) const {
+    if (dimIdx > 0) data.offsets[dimIdx - 1].back()++;
+
+    // The elements of the last dimension are the values themselves.
+    if (dimIdx < data.offsets.size()) {
+      data.offsets[dimIdx].push_back(data.offsets[dimIdx].back());
+    } else {
+      data.buffer.resize(data.buffer.size() + 1);
+      data.valueSet = false;
     }
   }
 
@@ -299,68 +756,19 @@ namespace bufr {
     }
   }
 
-  void ResultSetImpl::copyFilteredData(details::ResultData& resData,
-                                   const details::ResultData& srcData, const TargetPtr& target,
-                                   size_t& inputOffset, size_t& outputOffset, size_t depth,
-                                   size_t maxDepth, const FilterDataList& filterDataList,
-                                   bool skipResult) const {
-    if (depth == maxDepth) {
-      if (!skipResult) {
-        if (resData.buffer.isLongStr()) {
-          resData.buffer.value.strings[outputOffset] = srcData.buffer.value.strings[inputOffset];
-        } else {
-          resData.buffer.value.octets[outputOffset] = srcData.buffer.value.octets[inputOffset];
-        }
-
-        outputOffset++;
-      }
-
-      inputOffset++;
-
-      return;
-    }
-
-    const auto& filterData = filterDataList[depth];
-
-    if (filterData.isEmpty) {
-      for (size_t count = 1; count <= static_cast<size_t>(srcData.rawDims[depth]); count++) {
-        copyFilteredData(resData, srcData, target, inputOffset, outputOffset, depth + 1, maxDepth,
-                         filterDataList, skipResult);
-      }
-    } else {
-      size_t filterIdx     = 0;
-      auto nextFilterCount = filterData.filter[filterIdx];
-      for (size_t count = 1; count <= static_cast<size_t>(srcData.rawDims[depth]); count++) {
-        bool skip = skipResult;
-        if (!skip) {
-          if (nextFilterCount == count) {
-            filterIdx++;
-            if (filterIdx < filterData.filter.size())
-              nextFilterCount = filterData.filter.at(filterIdx);
-          } else {
-            skip = true;
-          }
-        }
-
-        copyFilteredData(resData, srcData, target, inputOffset, outputOffset, depth + 1, maxDepth,
-                         filterDataList, skip);
-      }
-    }
-  }
-
-  void ResultSetImpl::applyGroupBy(details::ResultData& resData,
-                               const details::TargetMetaDataPtr& targetMetaData,
-                               const std::string& groupByFieldName) const {
-    const auto groupByMetaData = analyzeTarget(groupByFieldName);
+  template <typename Buffer>
+  void ResultSetImpl::applyGroupBy(details::ResultDataOf<Buffer>& resData,
+                                   const details::TargetMetaDataPtr& targetMetaData,
+                                   const details::TargetMetaDataPtr& groupByMetaData) const {
     validateGroupByField(targetMetaData, groupByMetaData);
 
     // If the groupby field has more dims than the target then we must duplicate the
     // target values to match the groupby field
     if (groupByMetaData->dims.size() > targetMetaData->dims.size()) {
-      auto newData = details::ResultData();
-      newData.buffer.isLongStr(resData.buffer.isLongStr());
+      auto newData = details::ResultDataOf<Buffer>();
       newData.dims = {resData.dims[0] * product(groupByMetaData->dims)};
-      newData.buffer.resize(resData.dims[0] * product(groupByMetaData->dims));
+      initBuffer(newData.buffer, isLongStr(resData.buffer),
+                 resData.dims[0] * product(groupByMetaData->dims));
 
       const auto numTargetVals = static_cast<size_t>(product(targetMetaData->dims));
 
@@ -375,13 +783,7 @@ namespace bufr {
 
       for (size_t targIdx = 0; targIdx < numTargetVals * resData.dims[0]; targIdx++) {
         for (size_t rep = 0; rep < numReps; rep++) {
-          if (resData.buffer.isLongStr()) {
-            newData.buffer.value.strings[targIdx * numReps + rep]
-              = resData.buffer.value.strings[targIdx];
-          } else {
-            newData.buffer.value.octets[targIdx * numReps + rep]
-              = resData.buffer.value.octets[targIdx];
-          }
+          copyValue(newData.buffer, targIdx * numReps + rep, resData.buffer, targIdx);
         }
       }
 
@@ -408,9 +810,7 @@ namespace bufr {
   }
 
   std::string ResultSetImpl::unit(const std::string& fieldName) const {
-    const auto targetIdx = frames_.front().getTargetIdx(fieldName);
-    const auto& target   = frames_.front().targetAtIdx(targetIdx);
-    return target->typeInfo.unit;
+    return (*targets_.front())[targetIdx(fieldName)]->typeInfo.unit;
   }
 
   std::shared_ptr<DataObjectBase> ResultSetImpl::makeDataObject(
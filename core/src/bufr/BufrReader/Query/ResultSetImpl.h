@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -12,11 +15,13 @@
 #include "bufr/DataObject.h"
 #include "bufr/Data.h"
 #include "bufr/DataProvider.h"
-#include "SubsetLookupTable.h"
 #include "Target.h"
+#include "TargetColumn.h"
 
 
 namespace bufr {
+class ThreadPool;
+
 
 namespace details
 {
@@ -26,33 +31,90 @@ namespace details
         TypeInfo typeInfo;
         std::vector<int> dims = {0};
         std::vector<int> rawDims = {0};
-        std::vector<int> filteredDims = {0};
         std::vector<int> groupedDims = {};
-        std::vector<char> missingFrames;
+        std::vector<char> missingSubsets;
         std::vector<Query> dimPaths;
     };
 
-    struct ResultData
+    /// \brief The assembled data of a target. The buffer holds either the raw values (Data) or
+    ///        the values converted to the type of the DataObject (std::vector<T>).
+    template <typename Buffer>
+    struct ResultDataOf
     {
-        Data buffer;
+        Buffer buffer;
         std::vector<int> dims;
         std::vector<int> rawDims;
         std::vector<Query> dimPaths;
     };
 
+    typedef ResultDataOf<Data> ResultData;
+
+    struct RaggedResultData
+    {
+        Data buffer;
+        std::vector<std::vector<size_t>> offsets;
+        bool valueSet = false;  // Was the value of the last element set?
+    };
+
     typedef std::shared_ptr<TargetMetaData> TargetMetaDataPtr;
 
-}  // namespace details
+    /// \brief The metadata of the targets that were analyzed, by target name. It is locked, so
+    ///        the const getters of a ResultSetImpl can be called from several threads at once.
+    ///        Copies start out empty (the metadata is recomputed when needed).
+    class MetaDataCache
+    {
+     public:
+        MetaDataCache() = default;
+        MetaDataCache(const MetaDataCache&) {}
+        MetaDataCache& operator=(const MetaDataCache&)
+        {
+            clear();
+            return *this;
+        }
+
+        /// \brief Get the metadata of a target (null if it isn't in the cache).
+        TargetMetaDataPtr find(const std::string& name) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto metaDataIt = metaData_.find(name);
+            return (metaDataIt == metaData_.end()) ? nullptr : metaDataIt->second;
+        }
 
-    typedef SubsetLookupTable Frame;
-    typedef std::vector<Frame> Frames;
+        /// \brief Add the metadata of a target, unless another thread added it first.
+        /// \return The metadata in the cache.
+        TargetMetaDataPtr insert(const std::string& name, const TargetMetaDataPtr& metaData)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isEmpty_ = false;
+            return metaData_.insert({name, metaData}).first->second;
+        }
+
+        /// \brief Remove all the metadata. Cheap when there is nothing to remove, as it is
+        ///        called for every subset that is added.
+        void clear()
+        {
+            if (isEmpty_) return;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            metaData_.clear();
+            isEmpty_ = true;
+        }
+
+     private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, TargetMetaDataPtr> metaData_;
+        std::atomic<bool> isEmpty_ = true;
+    };
+
+}  // namespace details
 
     /// \brief This class acts as the container for all the data that is collected during the
-    /// the BUFR querying process in the form of SubsetLookupTable instances.
+    /// the BUFR querying process. The data for each target is stored column wise (see
+    /// TargetColumn), together with the targets of the subset variant of each subset.
     ///
     /// \par The getter functions for the data construct the final output based on the data and
-    /// metadata in these lookup tables. There are many complications. For one the data may be
-    /// jagged (lookup table instances do not necessarily all have the same number of elements
+    /// metadata in these columns. There are many complications. For one the data may be
+    /// jagged (subsets do not necessarily all have the same number of elements
     /// [repeated data could have a different number of repeats per instance]). Another is the
     /// application group_by fields which affect the dimensionality of the data. In order to make
     /// the data into rectangular arrays it may be necessary to strategically fill in missing values
@@ -75,48 +137,244 @@ namespace details
             const std::string& groupByFieldName = "",
             const std::string& overrideType = "") const;
 
+        /// \brief Gets the data for several fields at once (see ResultSet::getMany).
+        /// \param fields The fields to get.
+        /// \param numThreads The number of threads to assemble the fields on (0 for one per core).
+        /// \return The data for each field.
+        std::vector<std::shared_ptr<DataObjectBase>>
+        getMany(const std::vector<FieldRequest>& fields, size_t numThreads = 1) const;
+
+        /// \brief Gets the data for a field without padding (see ResultSet::getRagged).
+        /// \param fieldName The name of the field to get the data for.
+        /// \param overrideType The name of the override type to convert the data to.
+        /// \return The values and the offsets for each dimension.
+        RaggedData getRagged(const std::string& fieldName,
+                             const std::string& overrideType = "") const;
+
+        friend class ResultSet;
+
         friend class QueryRunner;
+        friend class WorkerPool;
+        friend class Aggregator;
+        friend class SubsetSampler;
 
      private:
-        Frames frames_;
+        std::vector<std::shared_ptr<Targets>> targets_;  // The targets for each subset variant
+        std::vector<uint32_t> subsetTargets_;  // The idx in targets_ for each subset
+        std::vector<TargetColumn> columns_;  // The data for each target (query name)
+
+        // The metadata of the targets that were analyzed (cleared when the subsets change).
+        mutable details::MetaDataCache metaDataCache_;
+
+        DecodeStats decodeStats_;
+
+        // Blocks of work smaller than this aren't worth handing to another thread.
+        static constexpr size_t MinBlockSubsets = 4096;  // Subsets per block (analysis)
+        static constexpr size_t MinBlockValues = 1 << 16;  // Values per block (assembly)
+
+        /// \brief Number of subsets collected.
+        size_t size() const { return subsetTargets_.size(); }
+
+        /// \brief Start collecting a subset. The data is added to the columns that are returned
+        ///        (see ExtractionPlan), and the subset is finished with endSubset.
+        /// \param targets The targets for the subset variant.
+        /// \return The columns, one for each target.
+        std::vector<TargetColumn>& beginSubset(const std::shared_ptr<Targets>& targets);
 
-        /// \brief Computes and returns metadata associated with a target.
+        /// \brief Finish the subset that was started with beginSubset.
+        void endSubset();
+
+        /// \brief Drop the subset that was started with beginSubset (ex: it failed a value
+        ///        predicate), along with whatever was collected for it.
+        void dropSubset();
+
+        /// \brief Drop the subsets after the first numSubsets.
+        /// \param numSubsets The number of subsets to keep.
+        void truncate(size_t numSubsets);
+
+        /// \brief Drop the subsets that aren't marked to be kept (see SubsetSampler).
+        /// \param keep Whether to keep each subset (size() entries).
+        void keepSubsets(const std::vector<bool>& keep);
+
+        /// \brief Add the subsets of another ResultSetImpl to the end of this one.
+        /// \param other The ResultSetImpl to add (its queries must be the same).
+        void append(const ResultSetImpl& other);
+
+        /// \brief Make room for as much data as another ResultSetImpl holds (see
+        ///        QueryRunner::takeResults).
+        /// \param other The ResultSetImpl to take the sizes from.
+        void reserve(const ResultSetImpl& other);
+
+        /// \brief Gets statistics on the memory taken up by the collected data.
+        /// \return The MemoryStats.
+        MemoryStats memoryStats() const;
+
+        /// \brief Gets statistics on how the messages were decoded (see QueryRunner).
+        DecodeStats decodeStats() const { return decodeStats_; }
+
+        /// \brief Count a message whose subsets after the first were decoded natively or left
+        ///        to NCEPLIB-bufr.
+        void addDecodedMessage(bool isNative)
+        {
+            if (isNative)
+            {
+                decodeStats_.numNativeMessages++;
+            }
+            else
+            {
+                decodeStats_.numFallbackMessages++;
+            }
+        }
+
+        /// \brief Gets the idx of the target (and column) with the given name.
+        /// \param name The name of the target.
+        /// \return The idx of the target.
+        size_t targetIdx(const std::string& name) const;
+
+        /// \brief Gets the target for a subset.
+        /// \param subsetIdx The idx of the subset.
+        /// \param targetIdx The idx of the target.
+        /// \return The target.
+        const TargetPtr& targetFor(size_t subsetIdx, size_t targetIdx) const
+        {
+            return (*targets_[subsetTargets_[subsetIdx]])[targetIdx];
+        }
+
+        /// \brief Computes and returns metadata associated with a target. The metadata is kept
+        ///        for later calls (see analyzeTargets).
         /// \param name The name of the target to get the metadata for.
         /// \return A TargetMetaData object containing the metadata.
         details::TargetMetaDataPtr analyzeTarget(const std::string& name) const;
 
+        /// \brief Computes the metadata of several targets in one pass over the subsets. Targets
+        ///        that were analyzed before are taken from the cache.
+        /// \param names The names of the targets.
+        /// \param pool Threads to split the subsets between (null to do them all here).
+        /// \return The metadata for each name.
+        std::vector<details::TargetMetaDataPtr>
+        analyzeTargets(const std::vector<std::string>& names, ThreadPool* pool = nullptr) const;
+
+        /// \brief Adds the dimensions of a subset to a target's metadata (see analyzeTargets).
+        ///        The dimensions are maxima over the subsets, so the subsets can be analyzed in
+        ///        any order and the results merged with mergeDims.
+        /// \param metaData The metadata to update.
+        /// \param subsetIdx The idx of the subset.
+        /// \return False if the subset has no data for the target.
+        bool analyzeCounts(details::TargetMetaData& metaData, size_t subsetIdx) const;
+
+        /// \brief Adds the type information and the dimension paths of a subset to a target's
+        ///        metadata (see analyzeTargets). Unlike the dimensions, these depend on the order
+        ///        the subsets are added in.
+        /// \param metaData The metadata to update.
+        /// \param subsetIdx The idx of the subset.
+        void analyzeType(details::TargetMetaData& metaData, size_t subsetIdx) const;
+
+        /// \brief Merges the dimensions found for some of the subsets (see analyzeCounts).
+        /// \param metaData The metadata to update.
+        /// \param other The metadata with the dimensions of the other subsets.
+        static void mergeDims(details::TargetMetaData& metaData,
+                              const details::TargetMetaData& other);
+
+        /// \brief Number of values in each row (subset) of the assembled data of a target.
+        static size_t rowLength(const details::TargetMetaData& metaData);
+
+        /// \brief Makes the DataObject for a field from metadata that was already worked out. It
+        ///        doesn't touch the metadata cache, so it can be called from several threads.
+        /// \param field The field to get.
+        /// \param targetMetaData The metadata for the field.
+        /// \param groupByMetaData The metadata for the group by field (null if there is none).
+        /// \param pool Threads to split the copying between (see assembleData).
+        /// \return The data for the field.
+        std::shared_ptr<DataObjectBase>
+        getField(const FieldRequest& field,
+                 const details::TargetMetaDataPtr& targetMetaData,
+                 const details::TargetMetaDataPtr& groupByMetaData,
+                 ThreadPool* pool = nullptr) const;
+
+        /// \brief Makes the DataObject<T> for a field (see getField). Numbers are converted to T
+        ///        as they are copied out of the columns, straight into the buffer that the
+        ///        DataObject takes over. Strings are assembled as Data first.
+        template <typename T>
+        std::shared_ptr<DataObjectBase>
+        makeField(const FieldRequest& field,
+                  const details::TargetMetaDataPtr& targetMetaData,
+                  const details::TargetMetaDataPtr& groupByMetaData,
+                  ThreadPool* pool) const;
+
         /// \brief Assembles the data fragments for a target into a single ResultData object.
+        ///        Every subset has its own row, so blocks of subsets can be copied at the same
+        ///        time (small targets are copied in one block).
         /// \param targetMetaData The metadata for the target to assemble the data for.
-        /// \return A ResultData object containing the data.
-        details::ResultData assembleData(const details::TargetMetaDataPtr& targetMetaData) const;
+        /// \param pool Threads to split the subsets between (null to copy them all here).
+        /// \return A ResultData object containing the data (with a Data or std::vector<T>
+        ///         buffer).
+        template <typename Buffer>
+        details::ResultDataOf<Buffer>
+        assembleData(const details::TargetMetaDataPtr& targetMetaData,
+                     ThreadPool* pool = nullptr) const;
 
-        /// \brief Copies the data from a frame into a ResultData object.
+        /// \brief Copies the data of a subset into a ResultData object.
         /// \param data The ResultData object to copy the data into.
-        /// \param frame The frame to copy the data from.
-        /// \param target The target to copy the data for.
+        /// \param column The column with the data for the target.
+        /// \param subsetIdx The idx of the subset to copy the data for.
+        /// \param target The target of the subset.
         /// \param outputOffset The offset into the ResultData object to copy the data to.
-        void copyData(details::ResultData& data,
-                      const Frame& frame,
+        template <typename Buffer>
+        void copyData(details::ResultDataOf<Buffer>& data,
+                      const TargetColumn& column,
+                      size_t subsetIdx,
                       const TargetPtr& target,
                       size_t outputOffset) const;
 
-        /// \brief Copies the data from a frame into a ResultData object.
+        /// \brief Copies the data of a subset for one level of counts (the repeats of one
+        ///        dimension) into a ResultData object.
         /// \param data The ResultData object to copy the data into.
-        /// \param frame The frame to copy the data from.
-        /// \param target The target to copy the data for.
-        /// \param outputOffset The offset into the ResultData object to copy the data to.
-        /// \param inputOffset The offset into the frame to copy the data from.
-        /// \param dimIdx The index of the dimension to copy the data for.
-        /// \param countNumber The current count
-        /// \param countOffset The offset into the count array.
-        void _copyData(details::ResultData& data,
-                       const Frame& frame,
+        /// \param column The column with the data for the target.
+        /// \param subsetIdx The idx of the subset to copy the data for.
+        /// \param target The target of the subset.
+        /// \param outputOffset The offset into the ResultData object for the first count.
+        /// \param inputOffset The offset of the next value to copy (in the column values).
+        /// \param inputEnd The offset after the last value of the subset.
+        /// \param cursors The idx of the next count to use for each level.
+        /// \param dimIdx The index of the dimension (count level) to copy the data for.
+        /// \param countNumber The number of counts to use.
+        template <typename Buffer>
+        void copyLevel(details::ResultDataOf<Buffer>& data,
+                       const TargetColumn& column,
+                       size_t subsetIdx,
                        const TargetPtr& target,
-                       size_t& outputOffset,
+                       size_t outputOffset,
                        size_t& inputOffset,
-                       const size_t dimIdx,
-                       const size_t countNumber,
-                       const size_t countOffset) const;
+                       size_t inputEnd,
+                       std::vector<size_t>& cursors,
+                       size_t dimIdx,
+                       size_t countNumber) const;
+
+        /// \brief Adds the data of a subset for one level of counts to a RaggedResultData object
+        ///        (see copyLevel).
+        /// \param data The RaggedResultData object to add the data to.
+        /// \param column The column with the data for the target.
+        /// \param subsetIdx The idx of the subset to copy the data for.
+        /// \param levelDims The dimension for each count level (-1 if it isn't exported).
+        /// \param inputOffset The offset of the next value to copy (in the column values).
+        /// \param inputEnd The offset after the last value of the subset.
+        /// \param cursors The idx of the next count to use for each level.
+        /// \param level The count level to copy the data for.
+        /// \param countNumber The number of counts to use.
+        void copyRaggedLevel(details::RaggedResultData& data,
+                             const TargetColumn& column,
+                             size_t subsetIdx,
+                             const std::vector<int>& levelDims,
+                             size_t& inputOffset,
+                             size_t inputEnd,
+                             std::vector<size_t>& cursors,
+                             size_t level,
+                             size_t countNumber) const;
+
+        /// \brief Adds an element to a dimension of a RaggedResultData object.
+        /// \param data The RaggedResultData object.
+        /// \param dimIdx The index of the dimension.
+        void addRaggedElement(details::RaggedResultData& data, size_t dimIdx) const;
 
         /// \brief Validates that the group_by field is valid for the target. Throws an exception if
         ///        it is not.
@@ -126,34 +384,14 @@ namespace details
                                   const details::TargetMetaDataPtr& groupByMetaData) const;
 
 
-        /// \brief Copies filtered data from a source ResultData object into a destination
-        ///        ResultData object.
-        /// \param resData The ResultData object to copy the data into.
-        /// \param srcData The ResultData object to copy the data from.
-        /// \param target The target to copy the data for.
-        /// \param inputOffset The offset into the source ResultData object to copy the data from.
-        /// \param outputOffset The offset into the destination ResultData object to copy the data
-        ///        to.
-        /// \param depth The depth of the dimension to copy the data for.
-        /// \param filterDataList The list of filter data to apply.
-        /// \param skipResult Whether to skip copying the result data.
-        void copyFilteredData(details::ResultData& resData,
-                              const details::ResultData& srcData,
-                              const TargetPtr& target,
-                              size_t& inputOffset,
-                              size_t& outputOffset,
-                              size_t depth,
-                              size_t maxDepth,
-                              const FilterDataList& filterDataList,
-                              bool skipResult) const;
-
         /// \brief Modify the ResultData object to apply the group_by field.
         /// \param resData The ResultData object to modify.
         /// \param targetMetaData The metadata for the target.
-        /// \param groupByFieldName The name of the field to group the data by.
-        void applyGroupBy(details::ResultData& resData,
+        /// \param groupByMetaData The metadata for the group_by field.
+        template <typename Buffer>
+        void applyGroupBy(details::ResultDataOf<Buffer>& resData,
                           const details::TargetMetaDataPtr& targetMetaData,
-                          const std::string& groupByFieldName) const;
+                          const details::TargetMetaDataPtr& groupByMetaData) const;
 
         /// \brief Is the field a string field?
         /// \param fieldName The name of the field.
@@ -0,0 +1,153 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "bufr/ResultSetIterator.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "QueryRunner.h"
+
+
+namespace bufr {
+    /// \brief The state that is kept from one chunk to the next. The QueryRunner refers to the
+    ///        members, so they must not move around (hence the pimpl).
+    class ResultSetIteratorImpl
+    {
+     public:
+        ResultSetIteratorImpl(const std::shared_ptr<DataProvider>& dataProvider,
+                              const QuerySet& querySet,
+                              size_t offset,
+                              size_t numMessages,
+                              size_t chunkMessages,
+                              size_t chunkBytes) :
+            dataProvider_(dataProvider),
+            querySet_(querySet),
+            queryRunner_(querySet_, resultSet_, dataProvider_),
+            chunkMessages_(chunkMessages),
+            chunkBytes_(chunkBytes)
+        {
+            // The index is what lets each chunk seek straight to its first message.
+            const size_t totalMessages = dataProvider_->numMessages(querySet_);
+            position_ = std::min(offset, totalMessages);
+            end_ = (numMessages > 0) ? std::min(totalMessages, position_ + numMessages)
+                                     : totalMessages;
+        }
+
+        bool hasNext() const { return position_ < end_; }
+
+        size_t position() const { return position_; }
+
+        ResultSet next()
+        {
+            if (!hasNext())
+            {
+                std::ostringstream errStr;
+                errStr << "ResultSetIterator::next was called after the last chunk.";
+                throw eckit::BadValue(errStr.str());
+            }
+
+            const size_t offset = position_;
+            size_t msgCnt = 0;
+            size_t numChunkMessages = 0;
+            bool chunkDone = false;
+
+            // DataProvider::run calls processMsg for the messages before the offset too.
+            auto processMsg = [&]()
+            {
+                if (++msgCnt <= offset) return;
+
+                numChunkMessages++;
+                chunkDone = (offset + numChunkMessages >= end_) ||
+                            (chunkMessages_ > 0 && numChunkMessages >= chunkMessages_) ||
+                            (chunkBytes_ > 0 && queryRunner_.collectedBytes() >= chunkBytes_);
+            };
+
+            auto processSubset = [this]()
+            {
+                queryRunner_.accumulate();
+            };
+
+            // Only ever false right after a message was finished, so chunks hold whole messages.
+            auto continueProcessing = [&chunkDone]() -> bool
+            {
+                return !chunkDone;
+            };
+
+            auto subsetReader = [this](const MessageHeader& header, const uint8_t* msg)
+            {
+                return queryRunner_.accumulateRemaining(header, msg);
+            };
+
+            dataProvider_->setSubsetReader(subsetReader);
+
+            try
+            {
+                dataProvider_->run(querySet_,
+                                   processSubset,
+                                   processMsg,
+                                   continueProcessing,
+                                   offset);
+            }
+            catch (...)
+            {
+                dataProvider_->setSubsetReader(nullptr);
+                queryRunner_.takeResults();
+                throw;
+            }
+
+            dataProvider_->setSubsetReader(nullptr);
+
+            // Stop if the file ran out early, rather than asking for the same messages again.
+            position_ = (numChunkMessages > 0) ? offset + numChunkMessages : end_;
+
+            return queryRunner_.takeResults(hasNext());
+        }
+
+     private:
+        const std::shared_ptr<DataProvider> dataProvider_;
+        const QuerySet querySet_;
+        ResultSet resultSet_;
+        QueryRunner queryRunner_;
+
+        const size_t chunkMessages_;
+        const size_t chunkBytes_;
+        size_t position_ = 0;
+        size_t end_ = 0;
+    };
+
+    ResultSetIterator::ResultSetIterator(const std::shared_ptr<DataProvider>& dataProvider,
+                                         const QuerySet& querySet,
+                                         size_t offset,
+                                         size_t numMessages,
+                                         size_t chunkMessages,
+                                         size_t chunkBytes) :
+        impl_(std::make_unique<ResultSetIteratorImpl>(dataProvider,
+                                                      querySet,
+                                                      offset,
+                                                      numMessages,
+                                                      chunkMessages,
+                                                      chunkBytes))
+    {
+    }
+
+    ResultSetIterator::ResultSetIterator(ResultSetIterator&&) = default;
+    ResultSetIterator::~ResultSetIterator() = default;
+    ResultSetIterator& ResultSetIterator::operator=(ResultSetIterator&&) = default;
+
+    bool ResultSetIterator::hasNext() const
+    {
+        return impl_->hasNext();
+    }
+
+    ResultSet ResultSetIterator::next()
+    {
+        return impl_->next();
+    }
+
+    size_t ResultSetIterator::position() const
+    {
+        return impl_->position();
+    }
+}  // namespace bufr
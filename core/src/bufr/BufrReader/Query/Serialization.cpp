@@ -0,0 +1,84 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "Serialization.h"
+
+
+namespace bufr {
+    void writeTarget(BufferWriter& writer, const Target& target)
+    {
+        writer.string(target.name);
+        writer.string(target.queryStr);
+        writer.value<uint64_t>(target.nodeIdx);
+        writer.string(target.longStrId);
+        writer.value<int32_t>(target.typeInfo.scale);
+        writer.value<int32_t>(target.typeInfo.reference);
+        writer.value<int32_t>(target.typeInfo.bits);
+        writer.string(target.typeInfo.unit);
+        writer.string(target.typeInfo.description);
+
+        writer.value<uint64_t>(target.path.size());
+        for (const auto& component : target.path)
+        {
+            writer.value<int32_t>(static_cast<int32_t>(component.type));
+            writer.value<uint64_t>(component.nodeId);
+            writer.value<uint64_t>(component.parentNodeId);
+            writer.value<uint64_t>(component.parentDimensionNodeId);
+            writer.value<uint64_t>(component.fixedRepeatCount);
+        }
+    }
+
+    std::shared_ptr<Target> readTarget(BufferReader& reader, const QuerySet& querySet)
+    {
+        auto target = std::make_shared<Target>();
+        target->name = reader.string();
+        target->queryStr = reader.string();
+        target->nodeIdx = reader.value<uint64_t>();
+        target->longStrId = reader.string();
+        target->typeInfo.scale = reader.value<int32_t>();
+        target->typeInfo.reference = reader.value<int32_t>();
+        target->typeInfo.bits = reader.value<int32_t>();
+        target->typeInfo.unit = reader.string();
+        target->typeInfo.description = reader.string();
+
+        std::vector<TargetComponent> path(reader.value<uint64_t>());
+        for (auto& component : path)
+        {
+            component.type = static_cast<TargetComponent::Type>(reader.value<int32_t>());
+            component.nodeId = reader.value<uint64_t>();
+            component.parentNodeId = reader.value<uint64_t>();
+            component.parentDimensionNodeId = reader.value<uint64_t>();
+            component.fixedRepeatCount = reader.value<uint64_t>();
+        }
+
+        // Empty target (the query didn't apply to the subset, see QueryRunner::getTargets)
+        if (path.empty())
+        {
+            target->dimPaths.push_back({Query()});
+            target->exportDimIdxs = {0};
+            return target;
+        }
+
+        // The path components point into the parsed query, so take them from the QuerySet.
+        for (const auto& query : querySet.queriesFor(target->name))
+        {
+            if (query.str() != target->queryStr || query.path.size() + 1 != path.size())
+            {
+                continue;
+            }
+
+            path[0].queryComponent = query.subset;
+            for (size_t pathIdx = 1; pathIdx < path.size(); ++pathIdx)
+            {
+                path[pathIdx].queryComponent = query.path[pathIdx - 1];
+            }
+
+            target->setPath(path);
+            return target;
+        }
+
+        std::ostringstream errStr;
+        errStr << "The serialized query " << target->queryStr << " for " << target->name;
+        errStr << " is not part of the QuerySet.";
+        throw eckit::BadValue(errStr.str());
+    }
+}  // namespace bufr
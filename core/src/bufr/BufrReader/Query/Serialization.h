@@ -0,0 +1,116 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "bufr/QuerySet.h"
+#include "Target.h"
+
+
+namespace bufr {
+    /// \brief Appends values to a flat binary buffer (native byte order, so the buffer is only
+    ///        meant to be read back on the same kind of machine).
+    class BufferWriter
+    {
+     public:
+        template<typename T>
+        void value(const T& value)
+        {
+            buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void string(const std::string& str)
+        {
+            value<uint64_t>(str.size());
+            buffer_.append(str);
+        }
+
+        /// \brief Write a vector of plain values (ints or doubles).
+        template<typename T>
+        void array(const std::vector<T>& values)
+        {
+            value<uint64_t>(values.size());
+            buffer_.append(reinterpret_cast<const char*>(values.data()),
+                           values.size() * sizeof(T));
+        }
+
+        std::string& buffer() { return buffer_; }
+
+     private:
+        std::string buffer_;
+    };
+
+    /// \brief Reads back the values written with BufferWriter.
+    class BufferReader
+    {
+     public:
+        BufferReader(const char* data, size_t size) :
+            pos_(data),
+            end_(data + size)
+        {
+        }
+
+        template<typename T>
+        T value()
+        {
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string string()
+        {
+            const auto size = value<uint64_t>();
+            return std::string(take(size), size);
+        }
+
+        template<typename T>
+        void array(std::vector<T>& values)
+        {
+            const auto size = value<uint64_t>();
+            const char* data = take(size * sizeof(T));
+
+            values.resize(size);
+            if (size > 0) std::memcpy(values.data(), data, size * sizeof(T));
+        }
+
+        /// \brief Has everything been read?
+        bool atEnd() const { return pos_ == end_; }
+
+     private:
+        const char* pos_;
+        const char* end_;
+
+        const char* take(size_t numBytes)
+        {
+            if (numBytes > static_cast<size_t>(end_ - pos_))
+            {
+                std::ostringstream errStr;
+                errStr << "Serialized BUFR query data is incomplete.";
+                throw eckit::BadValue(errStr.str());
+            }
+
+            const char* data = pos_;
+            pos_ += numBytes;
+            return data;
+        }
+    };
+
+    /// \brief Write a Target (everything needed to make it again with readTarget).
+    void writeTarget(BufferWriter& writer, const Target& target);
+
+    /// \brief Read a Target written with writeTarget. The query components of the path are
+    ///        taken from the QuerySet, so it has to contain the query the target was made for.
+    /// \param reader The reader.
+    /// \param querySet The QuerySet the target was made for.
+    /// \return The target.
+    std::shared_ptr<Target> readTarget(BufferReader& reader, const QuerySet& querySet);
+}  // namespace bufr
@@ -0,0 +1,197 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "SubsetSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    SubsetSampler::SubsetSampler(const QuerySet& querySet) :
+        sampling_(querySet.sampling()),
+        isSampling_(sampling_.stride > 1 || sampling_.fraction < 1)
+    {
+        if (!sampling_.thins()) return;
+
+        const auto names = querySet.names();
+        for (const auto& name : {sampling_.latitude, sampling_.longitude, sampling_.quality})
+        {
+            if (!name.empty() && std::find(names.begin(), names.end(), name) == names.end())
+            {
+                std::ostringstream errStr;
+                errStr << "Can't thin the subsets with " << name << ", the QuerySet has no ";
+                errStr << "query with that name.";
+                throw eckit::BadParameter(errStr.str());
+            }
+        }
+    }
+
+    bool SubsetSampler::keepThinned(const ResultSetImpl& results)
+    {
+        if (!sampling_.thins()) return true;
+
+        // The targets (and so the columns) follow the QuerySet.
+        if (latitudeIdx_ < 0)
+        {
+            latitudeIdx_ = static_cast<int>(results.targetIdx(sampling_.latitude));
+            longitudeIdx_ = static_cast<int>(results.targetIdx(sampling_.longitude));
+            if (!sampling_.quality.empty())
+            {
+                qualityIdx_ = static_cast<int>(results.targetIdx(sampling_.quality));
+            }
+        }
+
+        const size_t subsetIdx = results.size() - 1;
+        const auto latitude = firstValue(results, latitudeIdx_, subsetIdx);
+        const auto longitude = firstValue(results, longitudeIdx_, subsetIdx);
+        if (std::isnan(latitude) || std::isnan(longitude)) return true;
+
+        // Missing quality values rank last.
+        const auto worst = sampling_.lowerIsBetter ? std::numeric_limits<double>::infinity()
+                                                   : -std::numeric_limits<double>::infinity();
+        auto quality = (qualityIdx_ < 0) ? worst : firstValue(results, qualityIdx_, subsetIdx);
+        if (std::isnan(quality)) quality = worst;
+
+        const auto cellKey = cellFor(latitude, longitude);
+        auto cellIt = cells_.find(cellKey);
+        if (cellIt == cells_.end())
+        {
+            if (isRecording_) undo_.push_back({cellKey, std::nullopt});
+            cells_.insert({cellKey, Cell{subsetIdx, quality}});
+            return true;
+        }
+
+        auto& cell = cellIt->second;
+        const bool isBetter = sampling_.lowerIsBetter ? quality < cell.quality
+                                                      : quality > cell.quality;
+        if (qualityIdx_ < 0 || cell.subsetIdx == NoSubset || !isBetter) return false;
+
+        if (isRecording_) undo_.push_back({cellKey, cell});
+        replaced_.push_back(cell.subsetIdx);
+        cell = Cell{subsetIdx, quality};
+        return true;
+    }
+
+    void SubsetSampler::dropReplaced(ResultSetImpl& results)
+    {
+        if (replaced_.empty()) return;
+
+        std::vector<bool> keep(results.size(), true);
+        for (const auto subsetIdx : replaced_)
+        {
+            keep[subsetIdx] = false;
+        }
+
+        results.keepSubsets(keep);
+
+        // The subsets after the dropped ones moved down.
+        std::vector<size_t> newIdxs(keep.size());
+        size_t numKept = 0;
+        for (size_t subsetIdx = 0; subsetIdx < keep.size(); ++subsetIdx)
+        {
+            newIdxs[subsetIdx] = numKept;
+            if (keep[subsetIdx]) numKept++;
+        }
+
+        for (auto& cell : cells_)
+        {
+            if (cell.second.subsetIdx != NoSubset)
+            {
+                cell.second.subsetIdx = newIdxs[cell.second.subsetIdx];
+            }
+        }
+
+        replaced_.clear();
+    }
+
+    void SubsetSampler::resultsTaken()
+    {
+        // Without a quality the subsets are never replaced, so their idxs aren't needed.
+        if (qualityIdx_ < 0) return;
+
+        for (auto& cell : cells_)
+        {
+            cell.second.subsetIdx = NoSubset;
+        }
+    }
+
+    void SubsetSampler::checkpoint()
+    {
+        isRecording_ = true;
+        savedNumSeen_ = numSeen_;
+        savedNumReplaced_ = replaced_.size();
+        undo_.clear();
+    }
+
+    void SubsetSampler::commit()
+    {
+        isRecording_ = false;
+        undo_.clear();
+    }
+
+    void SubsetSampler::rollback()
+    {
+        numSeen_ = savedNumSeen_;
+        replaced_.resize(savedNumReplaced_);
+
+        for (auto undoIt = undo_.rbegin(); undoIt != undo_.rend(); ++undoIt)
+        {
+            if (undoIt->second)
+            {
+                cells_[undoIt->first] = *undoIt->second;
+            }
+            else
+            {
+                cells_.erase(undoIt->first);
+            }
+        }
+
+        commit();
+    }
+
+    double SubsetSampler::draw(size_t subsetNum) const
+    {
+        // splitmix64, so the sample doesn't depend on the order the subsets are decoded in.
+        uint64_t bits = sampling_.seed + (static_cast<uint64_t>(subsetNum) + 1) *
+                                         0x9E3779B97F4A7C15ULL;
+        bits = (bits ^ (bits >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        bits = (bits ^ (bits >> 27)) * 0x94D049BB133111EBULL;
+        bits = bits ^ (bits >> 31);
+
+        return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);  // 2^-53
+    }
+
+    double SubsetSampler::firstValue(const ResultSetImpl& results,
+                                     int columnIdx,
+                                     size_t subsetIdx) const
+    {
+        const auto& column = results.columns_[columnIdx];
+        const auto& values = column.values();
+        if (values.isLongStr() || column.numValues(subsetIdx) == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        const auto valueIdx = column.valuesOffset(subsetIdx);
+        return values.isMissing(valueIdx) ? std::numeric_limits<double>::quiet_NaN()
+                                          : values.value.octets[valueIdx];
+    }
+
+    int64_t SubsetSampler::cellFor(double latitude, double longitude) const
+    {
+        const auto numColumns = static_cast<int64_t>(std::ceil(360.0 / sampling_.cellSize));
+
+        auto wrapped = std::fmod(longitude, 360.0);
+        if (wrapped < 0) wrapped += 360.0;
+
+        const auto row = static_cast<int64_t>(std::floor((latitude + 90.0) / sampling_.cellSize));
+        const auto column = std::min(static_cast<int64_t>(wrapped / sampling_.cellSize),
+                                     numColumns - 1);
+
+        return row * numColumns + column;
+    }
+}  // namespace bufr
@@ -0,0 +1,114 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bufr/QuerySet.h"
+#include "ResultSetImpl.h"
+
+
+namespace bufr {
+    /// \brief Decides which subsets are kept while the queries are run (see SubsetSampling).
+    /// The stride and the random sampling are decided before a subset is decoded, so the subsets
+    /// they leave out are never collected. The grid thinning needs the location of the subset,
+    /// so it is decided right after the subset is collected (see QueryRunner).
+    class SubsetSampler
+    {
+     public:
+        /// \brief Constructor.
+        /// \param querySet The QuerySet with the sampling options.
+        explicit SubsetSampler(const QuerySet& querySet);
+
+        /// \brief Should the next subset be collected? Has to be called once for every subset
+        ///        that is read (the stride and the random draws go by the number of subsets).
+        bool sample()
+        {
+            if (!isSampling_) return true;
+
+            const auto subsetNum = numSeen_++;
+            if (subsetNum % sampling_.stride != 0) return false;
+            return sampling_.fraction >= 1 || draw(subsetNum) < sampling_.fraction;
+        }
+
+        /// \brief Account for subsets that are read without asking sample (ex: none of them could
+        ///        be kept anyway), so the stride and the random draws stay the same.
+        /// \param numSubsets The number of subsets.
+        void skip(size_t numSubsets)
+        {
+            if (isSampling_) numSeen_ += numSubsets;
+        }
+
+        /// \brief Apply the grid thinning to the last subset in the results.
+        /// \param results The collected subsets.
+        /// \return False if the subset should be dropped (its cell already has a subset that is
+        ///         as good or better).
+        bool keepThinned(const ResultSetImpl& results);
+
+        /// \brief Number of subsets in the results that were replaced by a better one in their
+        ///        grid cell (see dropReplaced).
+        size_t numReplaced() const { return replaced_.size(); }
+
+        /// \brief Drop the subsets that were replaced by a better one in their grid cell.
+        /// \param results The collected subsets.
+        void dropReplaced(ResultSetImpl& results);
+
+        /// \brief The collected subsets were taken out of the results. Their grid cells stay
+        ///        taken, but they can't be replaced anymore.
+        void resultsTaken();
+
+        /// \brief Remember the state, so the decisions made after this can be undone (ex: the
+        ///        subsets of a message that couldn't be decoded after all).
+        void checkpoint();
+
+        /// \brief Forget the state saved by checkpoint.
+        void commit();
+
+        /// \brief Go back to the state saved by checkpoint.
+        void rollback();
+
+     private:
+        static constexpr size_t NoSubset = std::numeric_limits<size_t>::max();
+
+        /// \brief The subset kept for a grid cell.
+        struct Cell
+        {
+            size_t subsetIdx;  // NoSubset once the results are taken
+            double quality;
+        };
+
+        const SubsetSampling sampling_;
+        const bool isSampling_;
+
+        size_t numSeen_ = 0;
+        std::unordered_map<int64_t, Cell> cells_;
+        std::vector<size_t> replaced_;  // Subsets replaced by a better one in their cell
+
+        // Columns of the thinning queries, found with the first subset (-1 until then).
+        int latitudeIdx_ = -1;
+        int longitudeIdx_ = -1;
+        int qualityIdx_ = -1;
+
+        // State saved by checkpoint
+        bool isRecording_ = false;
+        size_t savedNumSeen_ = 0;
+        size_t savedNumReplaced_ = 0;
+        std::vector<std::pair<int64_t, std::optional<Cell>>> undo_;  // Cells as they were
+
+        /// \brief Get a uniform random number in [0, 1) for a subset. It only depends on the
+        ///        seed and the number of the subset.
+        double draw(size_t subsetNum) const;
+
+        /// \brief Get the first value a subset has for a column.
+        /// \return The value (NaN if there is none).
+        double firstValue(const ResultSetImpl& results, int columnIdx, size_t subsetIdx) const;
+
+        /// \brief Get the grid cell of a location.
+        int64_t cellFor(double latitude, double longitude) const;
+    };
+}  // namespace bufr
@@ -69,16 +69,6 @@ namespace bufr {
 
     typedef std::vector<TargetComponent> TargetComponents;
 
-    /// \brief For performance reasons we want to maintain a list of the indices of filtered
-    ///        data.
-    struct FilterData
-    {
-        const std::vector<size_t>& filter;
-        bool isEmpty;
-    };
-
-    typedef std::vector<FilterData> FilterDataList;
-
     /// \brief The information or Meta data for a BUFR field whose data we wish to capture when
     /// we execute a query.
     struct Target
@@ -95,7 +85,6 @@ namespace bufr {
         std::vector<Query> dimPaths;
         std::vector<int> exportDimIdxs;
         std::vector<int> seqPath;
-        FilterDataList filterDataList;
 
         bool hasDelayedRepeats = false;
         bool usesFilters = false;
@@ -111,7 +100,6 @@ namespace bufr {
             exportDimIdxs = {};
             seqPath.reserve(components.size());
             exportDimIdxs.reserve(components.size());
-            filterDataList.reserve(components.size());
 
             std::string currentPath;
             std::vector<std::shared_ptr<QueryComponent>> queryComponents;
@@ -152,9 +140,6 @@ namespace bufr {
                     seqPath.push_back(component.nodeId);
                 }
 
-                filterDataList.push_back({component.queryComponent->filter,
-                                          component.queryComponent->filter.empty()});
-
                 componentIdx++;
             }
 
@@ -0,0 +1,313 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "TargetColumn.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+
+
+namespace bufr {
+    namespace
+    {
+        /// \brief Offsets have to start at 0, never go down and end at the size of the buffer.
+        bool validOffsets(const std::vector<size_t>& offsets, size_t bufferSize)
+        {
+            return !offsets.empty() &&
+                   offsets.front() == 0 &&
+                   offsets.back() == bufferSize &&
+                   std::is_sorted(offsets.begin(), offsets.end());
+        }
+
+        /// \brief Move the ranges of a buffer that are marked to be kept down over the others.
+        /// The start of each range is read before its offset is overwritten (kept ranges can
+        /// only move down).
+        template<typename T>
+        void keepRanges(std::vector<size_t>& offsets,
+                        std::vector<T>& buffer,
+                        const std::vector<bool>& keep)
+        {
+            size_t end = 0;
+            size_t numKept = 0;
+            for (size_t rangeIdx = 0; rangeIdx + 1 < offsets.size(); ++rangeIdx)
+            {
+                const auto begin = offsets[rangeIdx];
+                const auto next = offsets[rangeIdx + 1];
+                offsets[numKept] = end;
+
+                if (keep[rangeIdx])
+                {
+                    std::move(buffer.begin() + begin, buffer.begin() + next, buffer.begin() + end);
+                    end += next - begin;
+                    numKept++;
+                }
+            }
+
+            offsets[numKept] = end;
+            offsets.resize(numKept + 1);
+            buffer.resize(end);
+        }
+    }  // namespace
+
+    void TargetColumn::addLevels(size_t numLevels)
+    {
+        while (counts_.size() < numLevels)
+        {
+            counts_.emplace_back();
+            countOffsets_.emplace_back(valueOffsets_.size(), 0);
+        }
+    }
+
+    void TargetColumn::addValues(const Data& values)
+    {
+        if (values_.empty()) values_.isLongStr(values.isLongStr());
+        if (values.isLongStr() != values_.isLongStr()) return;
+
+        if (values.isLongStr())
+        {
+            for (const auto& str : values.value.strings)
+            {
+                stringBytes_ += str.capacity();
+            }
+
+            values_.value.strings.insert(values_.value.strings.end(),
+                                         values.value.strings.begin(),
+                                         values.value.strings.end());
+        }
+        else
+        {
+            values_.value.octets.insert(values_.value.octets.end(),
+                                        values.value.octets.begin(),
+                                        values.value.octets.end());
+        }
+    }
+
+    void TargetColumn::endSubset()
+    {
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            countOffsets_[level].push_back(counts_[level].size());
+        }
+
+        valueOffsets_.push_back(values_.size());
+    }
+
+    void TargetColumn::truncate(size_t numSubsets)
+    {
+        if (numSubsets > size()) return;
+
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            counts_[level].resize(countOffsets_[level][numSubsets]);
+            countOffsets_[level].resize(numSubsets + 1);
+        }
+
+        // Only the strings that are dropped are gone over (subsets are dropped one at a time
+        // by the value predicates, see ExtractionPlan).
+        if (values_.isLongStr())
+        {
+            const auto& strings = values_.value.strings;
+            for (size_t idx = valueOffsets_[numSubsets]; idx < strings.size(); ++idx)
+            {
+                stringBytes_ -= std::min(stringBytes_, strings[idx].capacity());
+            }
+        }
+
+        values_.resize(valueOffsets_[numSubsets]);
+        valueOffsets_.resize(numSubsets + 1);
+    }
+
+    void TargetColumn::keepSubsets(const std::vector<bool>& keep)
+    {
+        truncate(size());
+
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            keepRanges(countOffsets_[level], counts_[level], keep);
+        }
+
+        if (values_.isLongStr())
+        {
+            const auto& strings = values_.value.strings;
+            for (size_t subsetIdx = 0; subsetIdx < size(); ++subsetIdx)
+            {
+                if (keep[subsetIdx]) continue;
+
+                const auto end = valueOffsets_[subsetIdx + 1];
+                for (size_t idx = valueOffsets_[subsetIdx]; idx < end; ++idx)
+                {
+                    stringBytes_ -= std::min(stringBytes_, strings[idx].capacity());
+                }
+            }
+
+            keepRanges(valueOffsets_, values_.value.strings, keep);
+        }
+        else
+        {
+            keepRanges(valueOffsets_, values_.value.octets, keep);
+        }
+    }
+
+    void TargetColumn::append(const TargetColumn& other)
+    {
+        // Anything that was added after the last finished subset is dropped.
+        truncate(size());
+
+        addLevels(other.numLevels());
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            auto& offsets = countOffsets_[level];
+            const size_t base = counts_[level].size();
+
+            if (level < other.numLevels())
+            {
+                const auto& otherCounts = other.counts_[level];
+                const auto& otherOffsets = other.countOffsets_[level];
+
+                counts_[level].insert(counts_[level].end(), otherCounts.begin(), otherCounts.end());
+                for (size_t subsetIdx = 1; subsetIdx <= other.size(); ++subsetIdx)
+                {
+                    offsets.push_back(base + otherOffsets[subsetIdx]);
+                }
+            }
+            else
+            {
+                offsets.insert(offsets.end(), other.size(), base);
+            }
+        }
+
+        const size_t base = values_.size();
+        addValues(other.values_);
+
+        const bool added = (values_.size() - base == other.values_.size());
+        for (size_t subsetIdx = 1; subsetIdx <= other.size(); ++subsetIdx)
+        {
+            valueOffsets_.push_back(added ? base + other.valueOffsets_[subsetIdx] : base);
+        }
+    }
+
+    void TargetColumn::reserve(const TargetColumn& other)
+    {
+        addLevels(other.numLevels());
+        for (size_t level = 0; level < other.numLevels(); ++level)
+        {
+            counts_[level].reserve(counts_[level].size() + other.counts_[level].size());
+            countOffsets_[level].reserve(countOffsets_[level].size() + other.size());
+        }
+
+        valueOffsets_.reserve(valueOffsets_.size() + other.size());
+
+        if (values_.empty()) values_.isLongStr(other.values_.isLongStr());
+        if (values_.isLongStr() != other.values_.isLongStr()) return;
+
+        if (values_.isLongStr())
+        {
+            values_.value.strings.reserve(values_.size() + other.values_.size());
+        }
+        else
+        {
+            values_.value.octets.reserve(values_.size() + other.values_.size());
+        }
+    }
+
+    void TargetColumn::addMemoryStats(MemoryStats& stats) const
+    {
+        stats.numBuffers += 2 + 2 * counts_.size();
+        stats.usedBytes += sizeof(TargetColumn) + valueOffsets_.size() * sizeof(size_t);
+        stats.reservedBytes += sizeof(TargetColumn) + valueOffsets_.capacity() * sizeof(size_t);
+
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            stats.usedBytes += counts_[level].size() * sizeof(int) +
+                               countOffsets_[level].size() * sizeof(size_t);
+            stats.reservedBytes += counts_[level].capacity() * sizeof(int) +
+                                   countOffsets_[level].capacity() * sizeof(size_t);
+        }
+
+        if (values_.isLongStr())
+        {
+            stats.usedBytes += values_.value.strings.size() * sizeof(std::string) + stringBytes_;
+            stats.reservedBytes += values_.value.strings.capacity() * sizeof(std::string) +
+                                   stringBytes_;
+        }
+        else
+        {
+            stats.usedBytes += values_.value.octets.size() * sizeof(double);
+            stats.reservedBytes += values_.value.octets.capacity() * sizeof(double);
+        }
+    }
+
+    void TargetColumn::serialize(BufferWriter& writer) const
+    {
+        writer.value<uint64_t>(counts_.size());
+        for (size_t level = 0; level < counts_.size(); ++level)
+        {
+            writer.array(counts_[level]);
+            writer.array(countOffsets_[level]);
+        }
+
+        writer.value<uint8_t>(values_.isLongStr() ? 1 : 0);
+        if (values_.isLongStr())
+        {
+            writer.value<uint64_t>(values_.value.strings.size());
+            for (const auto& str : values_.value.strings)
+            {
+                writer.string(str);
+            }
+        }
+        else
+        {
+            writer.array(values_.value.octets);
+        }
+
+        writer.array(valueOffsets_);
+    }
+
+    TargetColumn TargetColumn::deserialize(BufferReader& reader)
+    {
+        auto column = TargetColumn();
+
+        const auto numLevels = reader.value<uint64_t>();
+        for (size_t level = 0; level < numLevels; ++level)
+        {
+            column.counts_.emplace_back();
+            column.countOffsets_.emplace_back();
+            reader.array(column.counts_.back());
+            reader.array(column.countOffsets_.back());
+        }
+
+        column.values_.isLongStr(reader.value<uint8_t>() != 0);
+        if (column.values_.isLongStr())
+        {
+            const auto numStrings = reader.value<uint64_t>();
+            for (size_t strIdx = 0; strIdx < numStrings; ++strIdx)
+            {
+                column.values_.push_back(reader.string());
+                column.stringBytes_ += column.values_.value.strings.back().capacity();
+            }
+        }
+        else
+        {
+            reader.array(column.values_.value.octets);
+        }
+
+        reader.array(column.valueOffsets_);
+
+        bool isValid = validOffsets(column.valueOffsets_, column.values_.size());
+        for (size_t level = 0; isValid && level < numLevels; ++level)
+        {
+            isValid = column.countOffsets_[level].size() == column.valueOffsets_.size() &&
+                      validOffsets(column.countOffsets_[level], column.counts_[level].size());
+        }
+
+        if (!isValid)
+        {
+            std::ostringstream errStr;
+            errStr << "Serialized BUFR query data is corrupt.";
+            throw eckit::BadValue(errStr.str());
+        }
+
+        return column;
+    }
+}  // namespace bufr
@@ -0,0 +1,150 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl-lite.hpp>
+
+#include "bufr/Data.h"
+#include "bufr/ResultSet.h"
+#include "Serialization.h"
+
+
+namespace bufr {
+
+    /// \brief The data collected for one target (query name) over all the subsets. Rather than
+    /// keeping objects for every subset, the counts for each level of the target path (level 0
+    /// is the subset itself) and the values are appended to one contiguous buffer each, and the
+    /// jaggedness is recorded as the offsets where the data of each subset starts.
+    class TargetColumn
+    {
+     public:
+        TargetColumn() = default;
+
+        /// \brief Number of (finished) subsets in the column.
+        size_t size() const { return valueOffsets_.size() - 1; }
+
+        /// \brief Number of count levels (the longest target path seen, minus the element).
+        size_t numLevels() const { return counts_.size(); }
+
+        /// \brief Make sure there are at least numLevels count levels.
+        void addLevels(size_t numLevels);
+
+        /// \brief Add a count for a level of the current subset.
+        /// \param level The level (see addLevels).
+        /// \param count The count.
+        void addCount(size_t level, int count) { counts_[level].push_back(count); }
+
+        /// \brief Add a value to the current subset. All the values in the column have to be the
+        ///        same kind (numbers or long strings), values of the other kind are left out.
+        /// \param value The value.
+        void addValue(double value)
+        {
+            if (values_.isLongStr())
+            {
+                if (!values_.empty()) return;
+                values_.isLongStr(false);
+            }
+
+            values_.value.octets.push_back(value);
+        }
+
+        /// \brief Make room for num values at the end of the current subset (see addValue).
+        /// \param num The number of values.
+        /// \return Where to write the values (nullptr if the column holds long strings).
+        double* growValues(size_t num)
+        {
+            if (values_.isLongStr())
+            {
+                if (!values_.empty()) return nullptr;
+                values_.isLongStr(false);
+            }
+
+            auto& octets = values_.value.octets;
+            const auto offset = octets.size();
+            octets.resize(offset + num);
+            return octets.data() + offset;
+        }
+
+        /// \brief Add a long string value to the current subset (see addValue).
+        /// \param value The value.
+        void addValue(const std::string& value)
+        {
+            if (!values_.isLongStr())
+            {
+                if (!values_.empty()) return;
+                values_.isLongStr(true);
+            }
+
+            values_.value.strings.push_back(value);
+            stringBytes_ += value.capacity();
+        }
+
+        /// \brief Add values to the current subset (see addValue).
+        /// \param values The values.
+        void addValues(const Data& values);
+
+        /// \brief Finish the current subset (anything added after this goes to the next one).
+        void endSubset();
+
+        /// \brief Get the counts of a subset.
+        /// \param level The count level.
+        /// \param subsetIdx The idx of the subset.
+        gsl::span<const int> counts(size_t level, size_t subsetIdx) const
+        {
+            if (level >= counts_.size()) return {};
+
+            const auto& offsets = countOffsets_[level];
+            return gsl::span<const int>(counts_[level].data() + offsets[subsetIdx],
+                                        offsets[subsetIdx + 1] - offsets[subsetIdx]);
+        }
+
+        /// \brief Get the position of the first value of a subset in values().
+        size_t valuesOffset(size_t subsetIdx) const { return valueOffsets_[subsetIdx]; }
+
+        /// \brief Get the number of values of a subset.
+        size_t numValues(size_t subsetIdx) const
+        {
+            return valueOffsets_[subsetIdx + 1] - valueOffsets_[subsetIdx];
+        }
+
+        /// \brief Get the values of all the subsets.
+        const Data& values() const { return values_; }
+
+        /// \brief Drop the subsets after the first numSubsets (and any unfinished subset).
+        void truncate(size_t numSubsets);
+
+        /// \brief Drop the subsets that aren't marked to be kept (and any unfinished subset).
+        ///        The data of the subsets that are kept is moved down in place.
+        /// \param keep Whether to keep each subset (size() entries).
+        void keepSubsets(const std::vector<bool>& keep);
+
+        /// \brief Add the subsets of another column to the end of this one.
+        void append(const TargetColumn& other);
+
+        /// \brief Make room for the data of another column (ex: the last chunk), so the buffers
+        ///        don't have to grow while the subsets are added.
+        /// \param other The column to take the sizes from.
+        void reserve(const TargetColumn& other);
+
+        /// \brief Add the buffers of the column to the memory statistics.
+        /// \param stats The statistics to add to.
+        void addMemoryStats(MemoryStats& stats) const;
+
+        /// \brief Write the column (see WorkerPool).
+        void serialize(BufferWriter& writer) const;
+
+        /// \brief Read a column written with serialize.
+        static TargetColumn deserialize(BufferReader& reader);
+
+     private:
+        std::vector<std::vector<int>> counts_;
+        std::vector<std::vector<size_t>> countOffsets_;  // size() + 1 entries per level
+        Data values_;
+        std::vector<size_t> valueOffsets_ = {0};
+        size_t stringBytes_ = 0;
+    };
+}  // namespace bufr
@@ -0,0 +1,319 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "TargetsCache.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#include "../../Log.h"
+
+
+namespace bufr {
+    namespace
+    {
+        const char* CacheMagic = "BUFR-QUERY-TARGETS";
+        const uint32_t CacheVersion = 1;
+        const char* CacheExtension = ".bufrtargets";
+
+        /// \brief 64 bit FNV-1a hash.
+        uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+        {
+            for (size_t idx = 0; idx < size; ++idx)
+            {
+                hash ^= static_cast<unsigned char>(data[idx]);
+                hash *= 1099511628211ULL;
+            }
+
+            return hash;
+        }
+
+        /// \brief Builds up the key (the size of each string goes in too, so that different
+        ///        lists of strings can't run together into the same bytes).
+        class KeyHasher
+        {
+         public:
+            template<typename T>
+            void value(const T& value)
+            {
+                hash_ = fnv1a(reinterpret_cast<const char*>(&value), sizeof(T), hash_);
+            }
+
+            void string(const std::string& str)
+            {
+                value<uint64_t>(str.size());
+                hash_ = fnv1a(str.data(), str.size(), hash_);
+            }
+
+            uint64_t hash() const { return hash_; }
+
+         private:
+            uint64_t hash_ = fnv1a(nullptr, 0);
+        };
+
+        bool isTrue(const char* value)
+        {
+            const auto str = std::string(value);
+            return !(str.empty() || str == "0" || str == "off" || str == "OFF" ||
+                     str == "false" || str == "FALSE" || str == "no" || str == "NO");
+        }
+
+        void writeProgram(BufferWriter& writer, const std::shared_ptr<DecodeProgram>& program)
+        {
+            writer.value<uint8_t>(program != nullptr ? 1 : 0);
+            if (program != nullptr) program->serialize(writer);
+        }
+
+        std::shared_ptr<DecodeProgram> readProgram(BufferReader& reader)
+        {
+            if (reader.value<uint8_t>() == 0) return nullptr;
+            return DecodeProgram::deserialize(reader);
+        }
+    }  // namespace
+
+    TargetsCache::TargetsCache()
+    {
+        if (const char* enabled = std::getenv("BUFR_TARGETS_CACHE"))
+        {
+            enabled_ = isTrue(enabled);
+        }
+
+        if (const char* directory = std::getenv("BUFR_TARGETS_CACHE_DIR"))
+        {
+            directory_ = std::string(directory);
+        }
+    }
+
+    void TargetsCache::setEnabled(bool enabled)
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        cache.enabled_ = enabled;
+    }
+
+    bool TargetsCache::isEnabled()
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        return cache.enabled_;
+    }
+
+    void TargetsCache::setDirectory(const std::string& directory)
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        cache.directory_ = directory;
+    }
+
+    std::string TargetsCache::getDirectory()
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        return cache.directory_;
+    }
+
+    void TargetsCache::clear()
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        cache.entries_.clear();
+    }
+
+    size_t TargetsCache::size()
+    {
+        auto& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        return cache.entries_.size();
+    }
+
+    uint64_t TargetsCache::keyFor(const DataProvider& dataProvider, const QuerySet& querySet)
+    {
+        KeyHasher hasher;
+        hasher.string(dataProvider.typeName());
+        hasher.string(dataProvider.getSubsetVariant().str());
+
+        // The table nodes of the subset, straight from the table arrays. For elements the ISC
+        // and IRF hold the Table B scale and reference, so files with tables that only differ
+        // there get keys of their own. NCEPLIB-bufr doesn't export the widths, so QueryRunner
+        // checks the type info of the queried elements, and a program that skips the wrong
+        // number of bits for the others fails its trace check (the message is read by NCEPLIB).
+        const auto inode = dataProvider.getInode();
+        const auto lastNodeId = dataProvider.getIsc(inode);
+        hasher.value<int64_t>(inode);
+        hasher.value<int64_t>(lastNodeId);
+        for (auto nodeId = inode; nodeId <= lastNodeId; ++nodeId)
+        {
+            hasher.string(dataProvider.getTag(nodeId));
+            hasher.value<int32_t>(static_cast<int32_t>(dataProvider.getTyp(nodeId)));
+            hasher.value<int64_t>(dataProvider.getLink(nodeId));
+            hasher.value<int64_t>(dataProvider.getJmpb(nodeId));
+            hasher.value<int64_t>(dataProvider.getIrf(nodeId));
+            hasher.value<int64_t>(dataProvider.getIsc(nodeId));
+            hasher.value<int64_t>(dataProvider.getItp(nodeId));
+        }
+
+        const auto names = querySet.names();
+        hasher.value<uint64_t>(names.size());
+        for (const auto& name : names)
+        {
+            hasher.string(name);
+
+            const auto queries = querySet.queriesFor(name);
+            hasher.value<uint64_t>(queries.size());
+            for (const auto& query : queries)
+            {
+                hasher.string(query.str());
+            }
+        }
+
+        return hasher.hash();
+    }
+
+    std::shared_ptr<const TargetsCache::Entry> TargetsCache::get(uint64_t key,
+                                                                const QuerySet& querySet)
+    {
+        auto& cache = instance();
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex_);
+            if (!cache.enabled_) return nullptr;
+
+            const auto entryIt = cache.entries_.find(key);
+            if (entryIt != cache.entries_.end()) return entryIt->second;
+
+            directory = cache.directory_;
+        }
+
+        if (directory.empty()) return nullptr;
+
+        auto entry = load(directory, key, querySet);
+        if (entry != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex_);
+            cache.entries_.insert({key, entry});
+        }
+
+        return entry;
+    }
+
+    void TargetsCache::put(uint64_t key, const Entry& entry)
+    {
+        auto& cache = instance();
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex_);
+            if (!cache.enabled_) return;
+
+            cache.entries_[key] = std::make_shared<const Entry>(entry);
+            directory = cache.directory_;
+        }
+
+        if (!directory.empty()) save(directory, key, entry);
+    }
+
+    std::string TargetsCache::pathFor(const std::string& directory, uint64_t key)
+    {
+        std::ostringstream path;
+        path << directory << "/"
+             << std::hex << std::setw(16) << std::setfill('0') << key
+             << CacheExtension;
+
+        return path.str();
+    }
+
+    std::shared_ptr<const TargetsCache::Entry> TargetsCache::load(const std::string& directory,
+                                                                 uint64_t key,
+                                                                 const QuerySet& querySet)
+    {
+        std::ifstream cacheFile(pathFor(directory, key), std::ios::binary);
+        if (!cacheFile.is_open()) return nullptr;
+
+        const std::string data((std::istreambuf_iterator<char>(cacheFile)),
+                               std::istreambuf_iterator<char>());
+
+        try
+        {
+            auto reader = BufferReader(data.data(), data.size());
+            if (reader.string() != CacheMagic ||
+                reader.value<uint32_t>() != CacheVersion ||
+                reader.value<uint64_t>() != key)
+            {
+                return nullptr;
+            }
+
+            auto entry = std::make_shared<Entry>();
+            entry->targets = std::make_shared<Targets>(reader.value<uint64_t>());
+            for (auto& target : *entry->targets)
+            {
+                target = readTarget(reader, querySet);
+            }
+
+            entry->programs.program = readProgram(reader);
+            entry->programs.trace = readProgram(reader);
+            entry->programs.compressedProgram = readProgram(reader);
+            entry->programs.compressedTrace = readProgram(reader);
+
+            if (!reader.atEnd()) return nullptr;
+
+            return entry;
+        }
+        catch (const std::exception& e)
+        {
+            log::warning() << "Could not read the targets cache file " << pathFor(directory, key);
+            log::warning() << " (" << e.what() << ")" << std::endl;
+        }
+
+        return nullptr;
+    }
+
+    void TargetsCache::save(const std::string& directory, uint64_t key, const Entry& entry)
+    {
+        BufferWriter writer;
+        writer.string(CacheMagic);
+        writer.value<uint32_t>(CacheVersion);
+        writer.value<uint64_t>(key);
+
+        writer.value<uint64_t>(entry.targets->size());
+        for (const auto& target : *entry.targets)
+        {
+            writeTarget(writer, *target);
+        }
+
+        writeProgram(writer, entry.programs.program);
+        writeProgram(writer, entry.programs.trace);
+        writeProgram(writer, entry.programs.compressedProgram);
+        writeProgram(writer, entry.programs.compressedTrace);
+
+        // Write to a temporary file and then move it into place, so that concurrent readers
+        // never see a partially written entry.
+        const auto cachePath = pathFor(directory, key);
+        const auto tmpPath = cachePath + ".tmp" + std::to_string(getpid());
+
+        {
+            std::ofstream cacheFile(tmpPath, std::ios::binary);
+            if (!cacheFile.is_open())
+            {
+                log::debug() << "Could not write the targets cache file " << cachePath
+                             << std::endl;
+                return;
+            }
+
+            cacheFile.write(writer.buffer().data(), writer.buffer().size());
+            if (!cacheFile)
+            {
+                std::remove(tmpPath.c_str());
+                return;
+            }
+        }
+
+        if (std::rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+        }
+    }
+}  // namespace bufr
@@ -0,0 +1,105 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "bufr/DataProvider.h"
+#include "bufr/QuerySet.h"
+#include "DecodeProgram.h"
+#include "Target.h"
+
+
+namespace bufr {
+
+    /// \brief A process wide singleton that keeps the Targets and DecodePrograms QueryRunner
+    /// makes for each subset variant, so that files which share the same BUFR tables don't have
+    /// to analyze them again (building the SubsetTable needs a lot of calls into NCEPLIB-bufr).
+    /// The entries are keyed by a fingerprint of the NCEPLIB-bufr table arrays for the subset
+    /// (tags, types, links, jumps, references and scales) and of the QuerySet.
+    ///
+    /// \par The entries can also be stored on disk, so they are shared between runs. The
+    /// defaults can be set with the environment variables BUFR_TARGETS_CACHE (set to 0 to turn
+    /// the cache off) and BUFR_TARGETS_CACHE_DIR (the directory for the on-disk entries, nothing
+    /// is written to disk if it is not set).
+    class TargetsCache
+    {
+     public:
+        struct Entry
+        {
+            std::shared_ptr<Targets> targets;
+            DecodePrograms programs;
+        };
+
+        TargetsCache(TargetsCache const&) = delete;
+        void operator=(TargetsCache const&) = delete;
+
+        /// \brief Turn the cache on or off.
+        static void setEnabled(bool enabled);
+
+        /// \brief Is the cache turned on?
+        static bool isEnabled();
+
+        /// \brief Set the directory to store the entries in (empty to only keep them in memory).
+        static void setDirectory(const std::string& directory);
+
+        /// \brief Get the directory the entries are stored in (empty if they aren't).
+        static std::string getDirectory();
+
+        /// \brief Forget the entries held in memory.
+        static void clear();
+
+        /// \brief Number of entries held in memory.
+        static size_t size();
+
+        /// \brief Work out the key for the subset variant that is loaded in the DataProvider.
+        /// \param dataProvider The DataProvider with the subset loaded (in run).
+        /// \param querySet The QuerySet the targets are made for.
+        /// \return The key.
+        static uint64_t keyFor(const DataProvider& dataProvider, const QuerySet& querySet);
+
+        /// \brief Find an entry (in memory, then on disk).
+        /// \param key The key (see keyFor).
+        /// \param querySet The QuerySet the key was made with (entries read from disk get the
+        ///        query components of their targets from it).
+        /// \return The entry, or nullptr if there isn't one.
+        static std::shared_ptr<const Entry> get(uint64_t key, const QuerySet& querySet);
+
+        /// \brief Add an entry (replacing any entry with the same key).
+        /// \param key The key (see keyFor).
+        /// \param entry The entry.
+        static void put(uint64_t key, const Entry& entry);
+
+     private:
+        std::mutex mutex_;
+        bool enabled_ = true;
+        std::string directory_;
+        std::unordered_map<uint64_t, std::shared_ptr<const Entry>> entries_;
+
+        /// \brief Get the singleton instance of the TargetsCache.
+        static TargetsCache& instance()
+        {
+            static TargetsCache instance;
+            return instance;
+        }
+
+        /// \brief Reads the default settings from the environment.
+        TargetsCache();
+
+        /// \brief Get the path of the on-disk entry for a key.
+        static std::string pathFor(const std::string& directory, uint64_t key);
+
+        /// \brief Read an entry from disk.
+        /// \return The entry, or nullptr if there is no valid entry.
+        static std::shared_ptr<const Entry> load(const std::string& directory,
+                                                 uint64_t key,
+                                                 const QuerySet& querySet);
+
+        /// \brief Write an entry to disk.
+        static void save(const std::string& directory, uint64_t key, const Entry& entry);
+    };
+}  // namespace bufr
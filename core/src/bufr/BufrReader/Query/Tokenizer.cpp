@@ -25,6 +25,13 @@ namespace bufr {
         else
         { std::cout << "Tokenizer::tokenize: no match for " << query << std::endl; }
 
+        // Anything left over (ex: a predicate that isn't at the end) would be silently ignored.
+        if (token && iter != end)
+        {
+            throw eckit::BadParameter("Tokenizer::tokenize: Failed to parse query " + query +
+                                      " at " + std::string(iter, end));
+        }
+
         tokens.push_back(token);
 
         return tokens;
@@ -0,0 +1,300 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "WorkerPool.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "../../Log.h"
+#include "bufr/FortranUnits.h"
+#include "ResultSetImpl.h"
+#include "Serialization.h"
+#include "Target.h"
+#include "TargetColumn.h"
+
+
+namespace bufr {
+    namespace
+    {
+        /// \brief Write the whole buffer to a file descriptor.
+        bool writeAll(int fd, const std::string& buffer)
+        {
+            size_t pos = 0;
+            while (pos < buffer.size())
+            {
+                const auto written = ::write(fd, buffer.data() + pos, buffer.size() - pos);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+
+                pos += static_cast<size_t>(written);
+            }
+
+            return true;
+        }
+    }  // namespace
+
+    WorkerPool::WorkerPool(size_t numWorkers) :
+        numWorkers_(numWorkers)
+    {
+    }
+
+    ResultSet WorkerPool::run(const QuerySet& querySet,
+                              size_t begin,
+                              size_t end,
+                              const Worker& worker) const
+    {
+        struct Job
+        {
+            size_t offset = 0;
+            size_t numMessages = 0;
+            FILE* output = nullptr;
+            pid_t pid = 0;
+        };
+
+        const size_t totalMessages = (end > begin) ? end - begin : 0;
+        const size_t numWorkers = std::max<size_t>(1, std::min(numWorkers_, totalMessages));
+
+        // Split the messages as evenly as possible (the first workers get the remainder).
+        std::vector<Job> jobs(numWorkers);
+        size_t offset = begin;
+        for (size_t workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+        {
+            jobs[workerIdx].offset = offset;
+            jobs[workerIdx].numMessages = totalMessages / numWorkers +
+                                          ((workerIdx < totalMessages % numWorkers) ? 1 : 0);
+            offset += jobs[workerIdx].numMessages;
+        }
+
+        std::ostringstream errStr;
+        for (auto& job : jobs)
+        {
+            job.output = std::tmpfile();
+            if (job.output == nullptr)
+            {
+                errStr << "Could not create the output file for a worker process (";
+                errStr << std::strerror(errno) << "). ";
+                break;
+            }
+
+            // Buffered output would otherwise be written by the parent and the child.
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+
+            {
+                // Hold the lock so no other thread is in the middle of an NCEPLIB-bufr call
+                // when the process is copied.
+                auto lock = FortranUnits::lock();
+                job.pid = fork();
+                if (job.pid == 0)
+                {
+                    lock.release();
+                    FortranUnits::afterFork();
+                }
+            }
+
+            if (job.pid == 0)
+            {
+                int status = 0;
+                try
+                {
+                    const auto buffer = serialize(worker(job.offset, job.numMessages));
+                    if (!writeAll(fileno(job.output), buffer)) status = 1;
+                }
+                catch (const std::exception& e)
+                {
+                    log::error() << "Worker for messages " << job.offset << " to ";
+                    log::error() << job.offset + job.numMessages << " failed: ";
+                    log::error() << e.what() << std::endl;
+                    status = 1;
+                }
+
+                std::cout.flush();
+                std::cerr.flush();
+                _exit(status);
+            }
+
+            if (job.pid < 0)
+            {
+                errStr << "Could not start a worker process (" << std::strerror(errno) << "). ";
+                break;
+            }
+        }
+
+        // Wait for every worker that was started, even if something went wrong.
+        for (const auto& job : jobs)
+        {
+            if (job.pid <= 0) continue;
+
+            int status = 0;
+            pid_t result;
+            while ((result = waitpid(job.pid, &status, 0)) < 0 && errno == EINTR) {}
+
+            if (result < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                errStr << "The worker process for messages " << job.offset << " to ";
+                errStr << job.offset + job.numMessages << " failed. ";
+            }
+        }
+
+        auto resultSet = ResultSet();
+        try
+        {
+            for (const auto& job : jobs)
+            {
+                if (!errStr.str().empty()) break;
+
+                const int fd = fileno(job.output);
+                struct stat info;
+                if (fstat(fd, &info) != 0 || info.st_size == 0)
+                {
+                    errStr << "Could not read the output of a worker process. ";
+                    break;
+                }
+
+                const auto size = static_cast<size_t>(info.st_size);
+                void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    errStr << "Could not map the output of a worker process (";
+                    errStr << std::strerror(errno) << "). ";
+                    break;
+                }
+
+                try
+                {
+                    deserialize(static_cast<const char*>(data), size, querySet, resultSet);
+                }
+                catch (...)
+                {
+                    munmap(data, size);
+                    throw;
+                }
+
+                munmap(data, size);
+            }
+        }
+        catch (...)
+        {
+            for (const auto& job : jobs)
+            {
+                if (job.output != nullptr) std::fclose(job.output);
+            }
+
+            throw;
+        }
+
+        for (const auto& job : jobs)
+        {
+            if (job.output != nullptr) std::fclose(job.output);
+        }
+
+        if (!errStr.str().empty())
+        {
+            throw eckit::BadValue(errStr.str());
+        }
+
+        return resultSet;
+    }
+
+    std::string WorkerPool::serialize(const ResultSet& resultSet)
+    {
+        const auto& results = *resultSet.impl_;
+
+        BufferWriter writer;
+        writer.value<uint64_t>(results.targets_.size());
+        for (const auto& targets : results.targets_)
+        {
+            writer.value<uint64_t>(targets->size());
+            for (const auto& target : *targets)
+            {
+                writeTarget(writer, *target);
+            }
+        }
+
+        writer.array(results.subsetTargets_);
+
+        writer.value<uint64_t>(results.columns_.size());
+        for (const auto& column : results.columns_)
+        {
+            column.serialize(writer);
+        }
+
+        writer.value<uint64_t>(results.decodeStats_.numNativeMessages);
+        writer.value<uint64_t>(results.decodeStats_.numFallbackMessages);
+
+        return std::move(writer.buffer());
+    }
+
+    void WorkerPool::deserialize(const char* data,
+                                 size_t size,
+                                 const QuerySet& querySet,
+                                 ResultSet& resultSet)
+    {
+        auto reader = BufferReader(data, size);
+        auto results = ResultSetImpl();
+
+        results.targets_.resize(reader.value<uint64_t>());
+        for (auto& targets : results.targets_)
+        {
+            targets = std::make_shared<Targets>(reader.value<uint64_t>());
+            for (auto& target : *targets)
+            {
+                target = readTarget(reader, querySet);
+            }
+        }
+
+        reader.array(results.subsetTargets_);
+
+        const auto numColumns = reader.value<uint64_t>();
+        results.columns_.reserve(numColumns);
+        for (size_t columnIdx = 0; columnIdx < numColumns; ++columnIdx)
+        {
+            results.columns_.push_back(TargetColumn::deserialize(reader));
+        }
+
+        results.decodeStats_.numNativeMessages = reader.value<uint64_t>();
+        results.decodeStats_.numFallbackMessages = reader.value<uint64_t>();
+
+        bool isValid = true;
+        for (const auto targetsIdx : results.subsetTargets_)
+        {
+            isValid = isValid &&
+                      targetsIdx < results.targets_.size() &&
+                      results.targets_[targetsIdx]->size() == results.columns_.size();
+        }
+
+        for (const auto& column : results.columns_)
+        {
+            isValid = isValid && column.size() == results.subsetTargets_.size();
+        }
+
+        if (!isValid)
+        {
+            std::ostringstream errStr;
+            errStr << "The results of a worker process are corrupt.";
+            throw eckit::BadValue(errStr.str());
+        }
+
+        resultSet.impl_->append(results);
+    }
+}  // namespace bufr
@@ -0,0 +1,61 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "bufr/QuerySet.h"
+#include "bufr/ResultSet.h"
+
+
+namespace bufr {
+
+    /// \brief Runs a query over a range of messages by splitting it between forked worker
+    ///        processes. NCEPLIB-bufr keeps its state in global variables, so threads can't
+    ///        decode in parallel but separate processes can. Each worker decodes its own part
+    ///        of the range, writes the data it collected to a temporary file and exits. The
+    ///        parent maps the files into memory and puts the data back together in message
+    ///        order, so the ResultSet is the same as the one a single process would produce.
+    class WorkerPool
+    {
+     public:
+        /// \brief Function that runs in a worker. It decodes numMessages messages (counting
+        ///        only the ones that match the QuerySet) starting at offset.
+        typedef std::function<ResultSet(size_t offset, size_t numMessages)> Worker;
+
+        /// \brief Constructor.
+        /// \param numWorkers The number of processes to fork.
+        explicit WorkerPool(size_t numWorkers);
+
+        /// \brief Split the messages [begin, end) between the workers and collect the results.
+        /// \param querySet The QuerySet the worker uses (needed to rebuild the targets).
+        /// \param begin The first message to decode.
+        /// \param end One past the last message to decode.
+        /// \param worker The function that runs in each worker process.
+        /// \return The combined results of all the workers.
+        ResultSet run(const QuerySet& querySet,
+                      size_t begin,
+                      size_t end,
+                      const Worker& worker) const;
+
+     private:
+        const size_t numWorkers_;
+
+        /// \brief Turn the data in a ResultSet into a flat buffer. The targets are written
+        ///        once per subset variant and the subsets refer to them by idx.
+        /// \param resultSet The ResultSet to serialize.
+        /// \return The serialized data.
+        static std::string serialize(const ResultSet& resultSet);
+
+        /// \brief Append the data in a buffer made by serialize to a ResultSet.
+        /// \param data The serialized data.
+        /// \param size The size of the data in bytes.
+        /// \param querySet The QuerySet the data was collected with.
+        /// \param[in, out] resultSet The ResultSet to add the data to.
+        static void deserialize(const char* data,
+                                size_t size,
+                                const QuerySet& querySet,
+                                ResultSet& resultSet);
+    };
+}  // namespace bufr
@@ -13,6 +13,13 @@
 
 namespace bufr {
 
+  /// \brief Stands in for a type, so the type can be passed to a generic lambda.
+  template <typename T>
+  struct TypeTag
+  {
+    typedef T type;
+  };
+
   class DataObjectBuilder
   {
   public:
@@ -25,22 +32,10 @@ namespace bufr {
                                                 const std::vector<Query>& dimPaths)
     {
       std::shared_ptr<DataObjectBase> object = nullptr;
-      if (overrideType.empty())
-      {
-        object = objectByTypeInfo(info);
-      }
-      else
+      visitType(fieldName, info, overrideType, [&object](auto tag)
       {
-        object = objectByType(overrideType);
-
-        if ((overrideType == "string" && !info.isString())
-            || (overrideType != "string" && info.isString())) {
-          std::ostringstream errMsg;
-          errMsg << "Conversions between numbers and strings are not currently supported. ";
-          errMsg << "See the export definition for \"" << fieldName << "\".";
-          throw eckit::BadParameter(errMsg.str());
-        }
-      }
+        object = std::make_shared<DataObject<typename decltype(tag)::type>>();
+      });
 
       object->setData(data);
       object->setDims(dims);
@@ -70,64 +65,107 @@ namespace bufr {
       return object;
     }
 
-  private:
+    /// \brief Make a DataObject that takes over the data rather than copying it.
+    template<typename T>
+    static std::shared_ptr<DataObjectBase>  make(std::vector<T>&& data,
+                                                const std::string& fieldName,
+                                                const std::string& groupByFieldName,
+                                                const std::vector<int>& dims,
+                                                const std::string& query,
+                                                const std::vector<Query>& dimPaths)
+    {
+      std::shared_ptr<DataObject<T>> object = std::make_shared<DataObject<T>>();
+      object->setData(std::move(data));
+      object->setDims(dims);
+      object->setFieldName(fieldName);
+      object->setGroupByFieldName(groupByFieldName);
+      object->setDimPaths(dimPaths);
+      object->setQuery(query);
+
+      return object;
+    }
 
-    static std::shared_ptr<DataObjectBase> objectByTypeInfo(const TypeInfo& info)
+    /// \brief Work out the type of the DataObject for a field and call visitor with a
+    ///        TypeTag for it. The override type wins over the TypeInfo.
+    /// \param fieldName The name of the field (for the error messages).
+    /// \param info The meta data for the element.
+    /// \param overrideType The name of the type to convert the data to (empty for none).
+    /// \param visitor Generic function called with TypeTag<T>.
+    template <typename Visitor>
+    static void visitType(const std::string& fieldName,
+                          const TypeInfo& info,
+                          const std::string& overrideType,
+                          Visitor&& visitor)
     {
-      std::shared_ptr<DataObjectBase> object;
+      if (overrideType.empty())
+      {
+        visitTypeInfo(info, visitor);
+        return;
+      }
+
+      if ((overrideType == "string" && !info.isString())
+          || (overrideType != "string" && info.isString())) {
+        std::ostringstream errMsg;
+        errMsg << "Conversions between numbers and strings are not currently supported. ";
+        errMsg << "See the export definition for \"" << fieldName << "\".";
+        throw eckit::BadParameter(errMsg.str());
+      }
 
+      visitOverrideType(overrideType, visitor);
+    }
+
+  private:
+
+    template <typename Visitor>
+    static void visitTypeInfo(const TypeInfo& info, Visitor& visitor)
+    {
       if (info.isString() || info.isLongString()) {
-        object = std::make_shared<DataObject<std::string>>();
+        visitor(TypeTag<std::string>());
       } else if (info.isInteger()) {
         if (info.isSigned()) {
           if (info.is64Bit()) {
-            object = std::make_shared<DataObject<int64_t>>();
+            visitor(TypeTag<int64_t>());
           } else {
-            object = std::make_shared<DataObject<int32_t>>();
+            visitor(TypeTag<int32_t>());
           }
         } else {
           if (info.is64Bit()) {
-            object = std::make_shared<DataObject<uint64_t>>();
+            visitor(TypeTag<uint64_t>());
           } else {
-            object = std::make_shared<DataObject<uint32_t>>();
+            visitor(TypeTag<uint32_t>());
           }
         }
       } else {
         if (info.is64Bit()) {
-          object = std::make_shared<DataObject<double>>();
+          visitor(TypeTag<double>());
         } else {
-          object = std::make_shared<DataObject<float>>();
+          visitor(TypeTag<float>());
         }
       }
-
-      return object;
     }
 
-    static std::shared_ptr<DataObjectBase> objectByType(const std::string& overrideType)
+    template <typename Visitor>
+    static void visitOverrideType(const std::string& overrideType, Visitor& visitor)
     {
-      std::shared_ptr<DataObjectBase> object;
-
       if (overrideType == "int" || overrideType == "int32") {
-        object = std::make_shared<DataObject<int32_t>>();
+        visitor(TypeTag<int32_t>());
       } else if (overrideType == "float" || overrideType == "float32") {
-        object = std::make_shared<DataObject<float>>();
+        visitor(TypeTag<float>());
       } else if (overrideType == "double" || overrideType == "float64") {
-        object = std::make_shared<DataObject<double>>();
+        visitor(TypeTag<double>());
       } else if (overrideType == "string") {
-        object = std::make_shared<DataObject<std::string>>();
+        visitor(TypeTag<std::string>());
       } else if (overrideType == "int64") {
-        object = std::make_shared<DataObject<int64_t>>();
+        visitor(TypeTag<int64_t>());
       } else if (overrideType == "uint64") {
-        object = std::make_shared<DataObject<uint64_t>>();
+        visitor(TypeTag<uint64_t>());
       } else if (overrideType == "uint32" || overrideType == "uint") {
-        object = std::make_shared<DataObject<uint32_t>>();
+        visitor(TypeTag<uint32_t>());
       } else {
         std::ostringstream errMsg;
         errMsg << "Unknown or unsupported type " << overrideType << ".";
         throw eckit::BadParameter(errMsg.str());
       }
-
-      return object;
     }
   };
 
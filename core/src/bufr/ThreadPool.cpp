@@ -0,0 +1,137 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+namespace bufr {
+    ThreadPool::ThreadPool(size_t numThreads, size_t maxThreads)
+    {
+        if (numThreads == 0)
+        {
+            numThreads = std::thread::hardware_concurrency();
+        }
+
+        numThreads = std::max<size_t>(1, std::min(numThreads, maxThreads));
+
+        threads_.reserve(numThreads - 1);
+        for (size_t threadIdx = 0; threadIdx + 1 < numThreads; ++threadIdx)
+        {
+            threads_.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStopping_ = true;
+        }
+
+        workReady_.notify_all();
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::run(size_t numTasks, const Task& task)
+    {
+        if (numTasks == 0) return;
+
+        if (threads_.empty() || numTasks == 1)
+        {
+            for (size_t taskIdx = 0; taskIdx < numTasks; ++taskIdx)
+            {
+                task(taskIdx);
+            }
+
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_ = &task;
+        numTasks_ = numTasks;
+        nextTask_ = 0;
+        numFinished_ = 0;
+        error_ = nullptr;
+        batchNumber_++;
+        workReady_.notify_all();
+
+        // The calling thread does its share rather than just waiting.
+        runTasks(lock);
+        workDone_.wait(lock, [this]() { return numFinished_ == numTasks_; });
+
+        task_ = nullptr;
+        auto error = error_;
+        error_ = nullptr;
+        lock.unlock();
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    void ThreadPool::runBlocks(size_t numItems, size_t minBlockSize, const BlockTask& task)
+    {
+        const auto blockSize = this->blockSize(numItems, minBlockSize);
+        run(numBlocks(numItems, minBlockSize), [&task, blockSize, numItems](size_t blockIdx)
+        {
+            const auto begin = blockIdx * blockSize;
+            task(blockIdx, begin, std::min(begin + blockSize, numItems));
+        });
+    }
+
+    size_t ThreadPool::blockSize(size_t numItems, size_t minBlockSize) const
+    {
+        const size_t BlocksPerThread = 4;
+        return std::max<size_t>({minBlockSize, 1, numItems / (size() * BlocksPerThread)});
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        size_t lastBatch = 0;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            workReady_.wait(lock, [this, lastBatch]()
+            {
+                return isStopping_ || (task_ != nullptr && batchNumber_ != lastBatch);
+            });
+
+            if (isStopping_) return;
+
+            lastBatch = batchNumber_;
+            runTasks(lock);
+        }
+    }
+
+    void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock)
+    {
+        while (nextTask_ < numTasks_)
+        {
+            const auto taskIdx = nextTask_++;
+            const auto& task = *task_;
+
+            lock.unlock();
+            std::exception_ptr error;
+            try
+            {
+                task(taskIdx);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            if (error && (!error_ || taskIdx < errorTaskIdx_))
+            {
+                error_ = error;
+                errorTaskIdx_ = taskIdx;
+            }
+
+            if (++numFinished_ == numTasks_) workDone_.notify_all();
+        }
+    }
+}  // namespace bufr
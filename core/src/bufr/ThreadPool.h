@@ -0,0 +1,96 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace bufr {
+
+    /// \brief A fixed set of threads that run the tasks of a batch (see run). The tasks are
+    /// numbered, and each one should only write to its own output (ex: the slot with its number
+    /// in a vector), so the results are the same whatever the number of threads is. Don't use
+    /// it for anything that calls into NCEPLIB-bufr (see FortranUnits and WorkerPool).
+    class ThreadPool
+    {
+     public:
+        /// \brief Function that runs one task of a batch.
+        typedef std::function<void(size_t taskIdx)> Task;
+
+        /// \brief Function that runs a block of items (see runBlocks).
+        typedef std::function<void(size_t blockIdx, size_t begin, size_t end)> BlockTask;
+
+        /// \brief Constructor.
+        /// \param numThreads The number of threads to run the tasks on, counting the thread
+        ///        that calls run (0 for one per core). With 1 the tasks run on the calling
+        ///        thread one after the other.
+        /// \param maxThreads Never use more threads than this (ex: the number of tasks).
+        explicit ThreadPool(size_t numThreads,
+                            size_t maxThreads = std::numeric_limits<size_t>::max());
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// \brief Number of threads the tasks run on (counting the one that calls run).
+        size_t size() const { return threads_.size() + 1; }
+
+        /// \brief Run the tasks 0 to numTasks - 1 and wait until they are all done. If tasks
+        ///        throw, the exception of the one with the lowest number is rethrown (after all
+        ///        the tasks have finished).
+        /// \param numTasks The number of tasks.
+        /// \param task The function that runs a task.
+        void run(size_t numTasks, const Task& task);
+
+        /// \brief Split the items 0 to numItems - 1 into blocks and run a task for each block
+        ///        (see run). There are a few blocks per thread so the threads that finish early
+        ///        can help out, but no block is smaller than minBlockSize items.
+        /// \param numItems The number of items.
+        /// \param minBlockSize The smallest number of items worth a task of its own.
+        /// \param task The function that runs a block of items [begin, end).
+        void runBlocks(size_t numItems, size_t minBlockSize, const BlockTask& task);
+
+        /// \brief Number of blocks runBlocks splits the items into (ex: to make room for the
+        ///        partial results of each block).
+        size_t numBlocks(size_t numItems, size_t minBlockSize) const
+        {
+            const auto blockSize = this->blockSize(numItems, minBlockSize);
+            return (numItems + blockSize - 1) / blockSize;
+        }
+
+     private:
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable workReady_;
+        std::condition_variable workDone_;
+
+        // The batch being run (guarded by mutex_)
+        const Task* task_ = nullptr;
+        size_t numTasks_ = 0;
+        size_t nextTask_ = 0;
+        size_t numFinished_ = 0;
+        size_t batchNumber_ = 0;
+        size_t errorTaskIdx_ = 0;
+        std::exception_ptr error_;
+        bool isStopping_ = false;
+
+        /// \brief Number of items in the blocks of runBlocks (the last block can be smaller).
+        size_t blockSize(size_t numItems, size_t minBlockSize) const;
+
+        /// \brief The loop the pool threads run until the pool is destroyed.
+        void workerLoop();
+
+        /// \brief Run tasks of the current batch until there are none left.
+        /// \param lock A lock on mutex_ (released while a task runs).
+        void runTasks(std::unique_lock<std::mutex>& lock);
+    };
+}  // namespace bufr
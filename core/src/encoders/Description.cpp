@@ -24,6 +24,7 @@ namespace
             const char* Paths = "paths";
             const char* Source = "source";
             const char* Labels = "labels";
+            const char* Ragged = "ragged";
         }  // Dimension
 
         namespace Variable
@@ -113,6 +114,11 @@ namespace encoders {
                     dim.labels = dimConf.getString(ConfKeys::Dimension::Labels);
                 }
 
+                if (dimConf.has(ConfKeys::Dimension::Ragged))
+                {
+                    dim.ragged = dimConf.getBool(ConfKeys::Dimension::Ragged);
+                }
+
                 addDimension(dim);
             }
         }
@@ -269,7 +275,8 @@ namespace encoders {
     void Description::addDimension(const std::string& name,
                                    const std::vector<std::string>& paths,
                                    const std::string& source,
-                                   const std::string& labels)
+                                   const std::string& labels,
+                                   bool ragged)
     {
         DimensionDescription dim;
         dim.name = name;
@@ -283,6 +290,7 @@ namespace encoders {
         dim.paths = pathQueries;
         dim.source = source;
         dim.labels = labels;
+        dim.ragged = ragged;
 
         addDimension(dim);
     }
@@ -127,13 +127,49 @@ namespace netcdf {
       nc::NcVar& var_;
     };
 
+    /// \brief Writes (Location, dim) data as a CF contiguous ragged array, i.e. only the first
+    ///        rowSizes[loc] elements of each row, one row after the other.
+    template <typename T>
+    class RaggedVarWriter : public ObjectWriter<T>
+    {
+    public:
+        RaggedVarWriter() = delete;
+        RaggedVarWriter(nc::NcVar& var, const std::vector<size_t>& rowSizes) :
+          var_(var),
+          rowSizes_(rowSizes)
+        {
+        }
+
+        void write(const std::vector<T>& data) final
+        {
+            if (rowSizes_.empty()) return;
+
+            const size_t rowLength = data.size() / rowSizes_.size();
+
+            std::vector<T> packed;
+            packed.reserve(std::accumulate(rowSizes_.begin(), rowSizes_.end(), size_t(0)));
+            for (size_t rowIdx = 0; rowIdx < rowSizes_.size(); ++rowIdx)
+            {
+                const auto rowStart = data.begin() + rowIdx * rowLength;
+                packed.insert(packed.end(), rowStart, rowStart + rowSizes_[rowIdx]);
+            }
+
+            VarWriter<T>(var_).write(packed);
+        }
+
+    private:
+        nc::NcVar& var_;
+        const std::vector<size_t>& rowSizes_;
+    };
+
     template <typename T>
     nc::NcVar createVar(std::shared_ptr<DataObject<T>>& obj,
                         nc::NcGroup& group,
                         const std::string& name,
                         const std::vector<std::string>& dimNames,
                         std::vector<size_t>& chunks,
-                        const int compressionLevel)
+                        const int compressionLevel,
+                        const std::vector<size_t>& rowSizes)
     {
         auto var = group.addVar(name, encoders::netcdf::getNcType<T>().getName(), dimNames);
 
@@ -148,7 +184,14 @@ namespace netcdf {
         }
 
         addAttribute(var, _FillValue, obj->missingValue());
-        obj->write(std::make_shared<VarWriter<T>>(var));
+        if (rowSizes.empty())
+        {
+            obj->write(std::make_shared<VarWriter<T>>(var));
+        }
+        else
+        {
+            obj->write(std::make_shared<RaggedVarWriter<T>>(var, rowSizes));
+        }
 
         return var;
     }
@@ -158,37 +201,38 @@ namespace netcdf {
                         const std::string& name,
                         const std::vector<std::string>& dimNames,
                         std::vector<size_t>& chunks,
-                        const int compressionLevel)
+                        const int compressionLevel,
+                        const std::vector<size_t>& rowSizes = {})
     {
         nc::NcVar var;
         if (auto fltobj = std::dynamic_pointer_cast<DataObject<float>>(object))
         {
-            var = createVar(fltobj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(fltobj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto dblobj = std::dynamic_pointer_cast<DataObject<double>>(object))
         {
-            var = createVar(dblobj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(dblobj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto intobj = std::dynamic_pointer_cast<DataObject<int32_t>>(object))
         {
-            var = createVar(intobj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(intobj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto uintobj = std::dynamic_pointer_cast<DataObject<uint32_t>>(object))
         {
-            var = createVar(uintobj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(uintobj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto int64obj = std::dynamic_pointer_cast<DataObject<int64_t>>(object))
         {
-            var = createVar(int64obj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(int64obj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto uint64obj = std::dynamic_pointer_cast<DataObject<uint64_t>>(object))
         {
-            var = createVar(uint64obj, group, name, dimNames, chunks, compressionLevel);
+            var = createVar(uint64obj, group, name, dimNames, chunks, compressionLevel, rowSizes);
         }
         else if (auto strobj = std::dynamic_pointer_cast<DataObject<std::string>>(object))
         {
             // Can not compress string data
-            var = createVar(strobj, group, name, dimNames, chunks, 0);
+            var = createVar(strobj, group, name, dimNames, chunks, 0, rowSizes);
         }
         else
         {
@@ -303,12 +347,44 @@ namespace netcdf {
 
             // Add Dimensions
             auto dims = getEncoderDimensions(dataContainer, categories);
+            const auto rowSizes = getRowSizes(dataContainer, categories, dims);
             for (auto dim: dims.dims())
             {
-                const auto& ncDim = file->addDim(dim->dimObj->name, dim->dimObj->size());
+                if (!dim->description.ragged)
+                {
+                    const auto& ncDim = file->addDim(dim->dimObj->name, dim->dimObj->size());
+                    auto ncVar = file->addVar(dim->dimObj->name, nc::NcType::nc_INT, ncDim);
+                    addAttribute(ncVar, _FillValue, DataObject<int>::missingValue());
+                    dim->dimObj->write(std::make_shared<VarWriter<int>>(ncVar));
+                    continue;
+                }
+
+                // Ragged dimensions become the CF sample dimension, with a count variable on
+                // the Location dimension that says how many samples each location has.
+                const auto& dimRowSizes = rowSizes.at(dim->dimObj->name);
+                const auto labels = std::dynamic_pointer_cast<DimensionData<int>>(dim->dimObj);
+
+                std::vector<int> sampleLabels;
+                for (const auto rowSize : dimRowSizes)
+                {
+                    sampleLabels.insert(sampleLabels.end(),
+                                        labels->data.begin(),
+                                        labels->data.begin() +
+                                            std::min(rowSize, labels->data.size()));
+                }
+
+                const auto& ncDim = file->addDim(dim->dimObj->name, sampleLabels.size());
                 auto ncVar = file->addVar(dim->dimObj->name, nc::NcType::nc_INT, ncDim);
                 addAttribute(ncVar, _FillValue, DataObject<int>::missingValue());
-                dim->dimObj->write(std::make_shared<VarWriter<int>>(ncVar));
+                ncVar.putVar(sampleLabels.data());
+
+                std::vector<int> counts(dimRowSizes.begin(), dimRowSizes.end());
+                auto countVar = file->addVar(dim->dimObj->name + "RowSize",
+                                             nc::NcType::nc_INT,
+                                             file->getDim(dims.dims().front()->dimObj->name));
+                countVar.putAtt("long_name", "number of " + dim->dimObj->name + " per location");
+                countVar.putAtt("sample_dimension", dim->dimObj->name);
+                countVar.putVar(counts.data());
             }
 
             // Write all the other Variables
@@ -324,12 +400,31 @@ namespace netcdf {
 
                 auto group = file->getGroup(groupName);
                 auto chunks = dims.chunksForVar(varDesc.name);
+                auto dimNames = dims.dimNamesForVar(varDesc.name);
+
+                // Variables on a ragged dimension only have the sample dimension.
+                static const std::vector<size_t> NoRowSizes;
+                const auto rowSizesIt = (dimNames.size() == 2) ? rowSizes.find(dimNames[1])
+                                                               : rowSizes.end();
+                const auto& varRowSizes = (rowSizesIt != rowSizes.end()) ? rowSizesIt->second
+                                                                         : NoRowSizes;
+                if (rowSizesIt != rowSizes.end())
+                {
+                    const auto numSamples = std::accumulate(varRowSizes.begin(),
+                                                            varRowSizes.end(),
+                                                            size_t(0));
+                    dimNames = {dimNames[1]};
+                    chunks = (numSamples > 0) ? std::vector<size_t>{numSamples}
+                                              : std::vector<size_t>{};
+                }
+
                 auto var = createVarFromObj(dataContainer->get(varDesc.source, categories),
                                             group,
                                             varName,
-                                            dims.dimNamesForVar(varDesc.name),
+                                            dimNames,
                                             chunks,
-                                            varDesc.compressionLevel);
+                                            varDesc.compressionLevel,
+                                            varRowSizes);
 
                 var.putAtt("long_name", varDesc.longName);
                 if (!varDesc.units.empty())
@@ -361,6 +456,60 @@ namespace netcdf {
         return obsGroups;
     }
 
+    std::map<std::string, std::vector<size_t>>
+    Encoder::getRowSizes(const std::shared_ptr<DataContainer>& container,
+                         const SubCategory& categories,
+                         const EncoderDimensions& dims) const
+    {
+        // The first dimension is always Location.
+        const auto numLocs = dims.dims().front()->dimObj->size();
+
+        std::map<std::string, std::vector<size_t>> rowSizes;
+        for (const auto& dim : dims.dims())
+        {
+            if (dim->description.ragged) rowSizes[dim->dimObj->name].resize(numLocs, 0);
+        }
+
+        if (rowSizes.empty()) return rowSizes;
+
+        for (const auto& varDesc : description_.getVariables())
+        {
+            const auto dimNames = dims.dimNamesForVar(varDesc.name);
+            for (size_t dimIdx = 0; dimIdx < dimNames.size(); ++dimIdx)
+            {
+                auto rowSizesIt = rowSizes.find(dimNames[dimIdx]);
+                if (rowSizesIt == rowSizes.end()) continue;
+
+                if (dimIdx != 1 || dimNames.size() != 2)
+                {
+                    std::ostringstream errStr;
+                    errStr << "Variable " << varDesc.name << " can't use the ragged dimension ";
+                    errStr << dimNames[dimIdx] << ". Ragged dimensions have to be the second of ";
+                    errStr << "two dimensions.";
+                    throw eckit::BadParameter(errStr.str());
+                }
+
+                const auto object = container->get(varDesc.source, categories);
+                const auto rowLength = static_cast<size_t>(object->getDims()[1]);
+
+                auto& sizes = rowSizesIt->second;
+                for (size_t locIdx = 0; locIdx < numLocs; ++locIdx)
+                {
+                    for (size_t idx = rowLength; idx > sizes[locIdx]; --idx)
+                    {
+                        if (!object->isMissing(locIdx * rowLength + idx - 1))
+                        {
+                            sizes[locIdx] = idx;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        return rowSizes;
+    }
+
     std::string Encoder::makeStrWithSubstitions(const std::string &prototype,
                                                 const std::map<std::string, std::string> &subMap)
     {
@@ -53,7 +53,7 @@ namespace bufr {
   template <>
   py::array pyArrayFromObj<std::string>(const std::shared_ptr<DataObject<std::string>>& obj)
   {
-    auto data = obj->getRawData();
+    const auto data = obj->getRawDataView();
     py::list pyStrList(data.size());
 
     // Convert the std::vector<std::string> into a list of Python Unicode strings
@@ -22,7 +22,7 @@ namespace bufr {
 
   template <typename T>
   py::array pyArrayFromObj(const std::shared_ptr<DataObject<T>>& obj) {
-    auto data = obj->getRawData();
+    const auto data = obj->getRawDataView();
 
     // Create the data array
     py::array_t<T> pyData(obj->getDims());
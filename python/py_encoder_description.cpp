@@ -62,12 +62,15 @@ void setupEncoderDescription(py::module& m)
          static_cast<void (Description::*)(const std::string&,
                                          const std::vector<std::string>&,
                                            const std::string&,
-                                         const std::string&)>(&Description::addDimension),
+                                         const std::string&,
+                                         bool)>(&Description::addDimension),
         py::arg("name"),
         py::arg("paths"),
         py::arg("source") = "",
         py::arg("labels") = "",
-          "Add a dimension to the description.")
+        py::arg("ragged") = false,
+          "Add a dimension to the description. Ragged dimensions are written by the netCDF "
+          "encoder as CF contiguous ragged arrays.")
    .def("remove_dimension", &Description::removeDimension,
         py::arg("name"),
         "Remove a dimension from the description.")
@@ -6,18 +6,55 @@
 */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "bufr/Aggregate.h"
 #include "bufr/File.h"
+#include "bufr/ResultSetIterator.h"
 
 namespace py = pybind11;
 
+using bufr::AggregateSpec;
+using bufr::AggregateStats;
 using bufr::File;
+using bufr::ResultSetIterator;
+
+namespace
+{
+  py::dict statsDict(const AggregateStats& stats)
+  {
+    py::dict result;
+    result["count"] = stats.count;
+    result["min"] = stats.min;
+    result["max"] = stats.max;
+    result["mean"] = stats.mean();
+    result["histogram"] = stats.histogram;
+    return result;
+  }
+}  // namespace
 
 void setupFile(py::module& m)
 {
+  py::class_<AggregateSpec>(m, "AggregateSpec")
+   .def(py::init([](const std::string& field,
+                    const std::string& groupBy,
+                    const std::vector<double>& bins)
+                 {
+                   return AggregateSpec{field, groupBy, bins};
+                 }),
+        py::arg("field"),
+        py::arg("group_by") = std::string(""),
+        py::arg("bins") = std::vector<double>(),
+        "The statistics to compute for a field (see File.aggregate). The values are "
+        "optionally grouped by another field, and bins are the edges of the histogram bins.")
+   .def_readwrite("field", &AggregateSpec::field)
+   .def_readwrite("group_by", &AggregateSpec::groupBy)
+   .def_readwrite("bins", &AggregateSpec::binEdges);
+
   py::class_<File>(m, "File")
    .def(py::init<const std::string&, const std::string&>(),
         py::arg("filename"),
@@ -26,9 +63,67 @@ void setupFile(py::module& m)
         py::arg("query_set"),
         py::arg("offset") = static_cast<int>(0),
         py::arg("numMsgs") = static_cast<int>(0),
-        "Execute a query set on the file. Returns a ResultSet object.")
+        py::arg("numWorkers") = static_cast<int>(1),
+        "Execute a query set on the file. Returns a ResultSet object. With numWorkers > 1 "
+        "the messages are decoded by that many forked processes.")
+   .def("execute_chunks", &File::executeChunks,
+        py::arg("query_set"),
+        py::arg("chunkMsgs"),
+        py::arg("chunkBytes") = static_cast<int>(0),
+        py::arg("offset") = static_cast<int>(0),
+        py::arg("numMsgs") = static_cast<int>(0),
+        py::keep_alive<0, 1>(),
+        "Execute a query set on the file a chunk at a time. Returns an iterator over the "
+        "ResultSet of each chunk (at most chunkMsgs messages, or chunkBytes bytes of data).")
+   .def("aggregate", [](File& self,
+                        const bufr::QuerySet& querySet,
+                        const std::vector<AggregateSpec>& specs,
+                        size_t offset,
+                        size_t numMsgs)
+        {
+          py::list results;
+          for (const auto& aggregate : self.aggregate(querySet, specs, offset, numMsgs))
+          {
+            auto result = statsDict(aggregate.total);
+            result["field"] = aggregate.spec.field;
+            result["group_by"] = aggregate.spec.groupBy;
+
+            py::dict groups;
+            for (const auto& group : aggregate.groups)
+            {
+              groups[py::float_(group.first)] = statsDict(group.second);
+            }
+
+            result["groups"] = groups;
+            results.append(result);
+          }
+
+          return results;
+        },
+        py::arg("query_set"),
+        py::arg("specs"),
+        py::arg("offset") = static_cast<int>(0),
+        py::arg("numMsgs") = static_cast<int>(0),
+        "Compute the count, min, max, mean (and histogram) of fields without keeping their "
+        "data. Returns a dict for each AggregateSpec, with the statistics of each group in "
+        "'groups'.")
+   .def("size", &File::size,
+        py::arg("query_set") = bufr::QuerySet(),
+        "Number of messages in the file that match the query set.")
    .def("rewind", &File::rewind, "Rewind the file to the beginning.")
    .def("close", &File::close, "Close the file.")
    .def("__enter__", [](File &f) { return &f; })
    .def("__exit__", [](File &f, py::args args) { f.close(); });
+
+  py::class_<ResultSetIterator>(m, "ResultSetIterator")
+   .def("__iter__", [](ResultSetIterator &it) -> ResultSetIterator& { return it; },
+        py::return_value_policy::reference_internal)
+   .def("__next__", [](ResultSetIterator &it)
+        {
+          if (!it.hasNext()) throw py::stop_iteration();
+          return it.next();
+        },
+        "Decode the next chunk of messages. Returns a ResultSet object.")
+   .def("position", &ResultSetIterator::position,
+        "Index of the next message to read.");
 }
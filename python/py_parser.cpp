@@ -29,22 +29,27 @@ void setupParser(py::module& m)
          py::arg("obsfile"),
          py::arg("mapping_path"),
          py::arg("table_path") = "")
-    .def("parse", [](BufrParser& self, size_t numMsgs = 0)
+    .def("parse", [](BufrParser& self, size_t numMsgs = 0, size_t numWorkers = 1,
+                     size_t numThreads = 1)
          {
-           return self.parse(numMsgs);
+           return self.parse(numMsgs, numWorkers, numThreads);
          },
          py::arg("numMsgs") = 0,
-         "Get Parser to parse a config file and get the data container.")
-    .def("parse", [](BufrParser& self, bufr::mpi::Comm& comm)
+         py::arg("numWorkers") = 1,
+         py::arg("numThreads") = 1,
+         "Get Parser to parse a config file and get the data container. The variables are "
+         "built and exported on numThreads threads (0 for one per core).")
+    .def("parse", [](BufrParser& self, bufr::mpi::Comm& comm, size_t numThreads = 1)
         {
           if (comm.size() == 1)
           {
             // use non-mpi version of the parser
-            return self.parse(0);
+            return self.parse(0, 1, numThreads);
           }
 
-          return self.parse(comm.getComm());
+          return self.parse(comm.getComm(), numThreads);
         },
         py::arg("comm"),
+        py::arg("numThreads") = 1,
         "Get Parser to parse a config file and get the data container in parallel.");
 }
@@ -23,6 +23,29 @@ void setupQuerySet(py::module& m)
    .def(py::init<>())
    .def(py::init<const std::vector<std::string>&>())
    .def("size", &QuerySet::size, "Get the number of queries in the query set.")
-   .def("add", &QuerySet::add, "Add a query to the query set.");
+   .def("add", &QuerySet::add, "Add a query to the query set.")
+   .def("set_time_window", &QuerySet::setTimeWindow,
+        py::arg("start"),
+        py::arg("end"),
+        "Only read messages whose section 1 date (YYYYMMDDHH) is in [start, end].")
+   .def("add_message_type", &QuerySet::addMessageType,
+        py::arg("dataCategory"),
+        py::arg("dataSubCategory") = -1,
+        "Only read messages of this data category and sub-category (-1 for any).")
+   .def("set_sample_stride", &QuerySet::setSampleStride,
+        py::arg("stride"),
+        "Only keep every stride-th subset.")
+   .def("set_sample_fraction", &QuerySet::setSampleFraction,
+        py::arg("fraction"),
+        py::arg("seed") = static_cast<uint64_t>(0),
+        "Keep each subset with the given probability (the same seed gives the same sample).")
+   .def("set_grid_thinning", &QuerySet::setGridThinning,
+        py::arg("latitude"),
+        py::arg("longitude"),
+        py::arg("cellSize"),
+        py::arg("quality") = std::string(""),
+        py::arg("lowerIsBetter") = true,
+        "Keep one subset per latitude/longitude cell of cellSize degrees (the first one, or "
+        "the best one by the quality query). The arguments are the names of queries.");
 
 }
@@ -43,6 +43,33 @@ void setupResultSet(py::module& m)
         "Get a numpy array of the specified field name. If the group_by "
         "field is specified, the array is grouped by the specified field."
         "It is also possible to specify a type to override the default type.")
+   .def("get_many", [](const ResultSet& self,
+                       const std::vector<std::string>& field_names,
+                       const std::string& group_by,
+                       size_t num_threads)
+        {
+          std::vector<bufr::FieldRequest> fields;
+          for (const auto& name : field_names)
+          {
+            fields.push_back({name, group_by, ""});
+          }
+
+          const auto objects = self.getMany(fields, num_threads);
+
+          py::dict result;
+          for (size_t idx = 0; idx < fields.size(); ++idx)
+          {
+            result[py::str(fields[idx].name)] = bufr::pyArrayFromObj(objects[idx]);
+          }
+
+          return result;
+        },
+        py::arg("field_names"),
+        py::arg("group_by") = std::string(""),
+        py::arg("num_threads") = static_cast<size_t>(1),
+        "Get a dict of numpy arrays for the specified field names (like get, but the "
+        "dimensions of all the fields are worked out together). The fields are assembled on "
+        "num_threads threads (0 for one per core).")
    .def("get_datetime", [](const ResultSet& self,
                            const std::string& year,
                            const std::string& month,
@@ -126,5 +153,49 @@ void setupResultSet(py::module& m)
         "and second fields. If the minute and second fields are not "
         "specified, they are assumed to be 0. If the group_by field is "
         "specified, the datetime objects are grouped by the specified "
-        "field.");
+        "field.")
+   .def("get_ragged", [](const ResultSet& self,
+                         const std::string& field_name,
+                         const std::string& type)
+        {
+          auto ragged = self.getRagged(field_name, type);
+
+          py::list offsets;
+          for (const auto& dimOffsets : ragged.offsets)
+          {
+            offsets.append(py::array_t<size_t>(dimOffsets.size(), dimOffsets.data()));
+          }
+
+          return py::make_tuple(bufr::pyArrayFromObj(ragged.values), offsets);
+        },
+        py::arg("field_name"),
+        py::arg("type") = std::string(""),
+        "Get the data of the specified field without padding. Returns a tuple with a 1D numpy "
+        "array of the values and a list of offset arrays, one for each dimension but the last. "
+        "The elements of the next dimension (or the values) in element i of dimension k are "
+        "the ones from offsets[k][i] up to offsets[k][i + 1].")
+   .def("memory_stats", [](const ResultSet& self)
+        {
+          const auto stats = self.memoryStats();
+
+          py::dict result;
+          result["num_subsets"] = stats.numSubsets;
+          result["num_buffers"] = stats.numBuffers;
+          result["used_bytes"] = stats.usedBytes;
+          result["reserved_bytes"] = stats.reservedBytes;
+          return result;
+        },
+        "Get a dict with the number of subsets, the number of buffers and the bytes used "
+        "and reserved for the collected data.")
+   .def("decode_stats", [](const ResultSet& self)
+        {
+          const auto stats = self.decodeStats();
+
+          py::dict result;
+          result["native_messages"] = stats.numNativeMessages;
+          result["fallback_messages"] = stats.numFallbackMessages;
+          return result;
+        },
+        "Get a dict with the number of messages whose subsets after the first were decoded "
+        "directly from the message data (native) or read by NCEPLIB-bufr (fallback).");
 }
@@ -116,6 +116,396 @@ def test_invalid_query():
     assert False, "Did not throw exception for invalid query."
 
 
+def test_execute_offset():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    # Reading every message should give the same data as reading the file in two parts (the
+    # second part seeks directly to its first message).
+    with bufr.File(DATA_PATH) as f:
+        num_msgs = f.size(q)
+        lat_all = f.execute(q).get('latitude')
+        lat_start = f.execute(q, 0, num_msgs // 2).get('latitude')
+        lat_end = f.execute(q, num_msgs // 2).get('latitude')
+
+    assert num_msgs > 1
+    assert np.allclose(lat_all, np.concatenate((lat_start, lat_end)))
+
+
+def test_multiple_open_files():
+    HRS_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+    MHS_PATH = 'testdata/gdas.t18z.1bmhs.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    with bufr.File(HRS_PATH) as f:
+        hrs_lat = f.execute(q).get('latitude')
+
+    with bufr.File(MHS_PATH) as f:
+        mhs_lat = f.execute(q).get('latitude')
+
+    # Files that are open at the same time each get their own Fortran unit, so reads from them
+    # can be interleaved.
+    with bufr.File(HRS_PATH) as hrs_file, bufr.File(MHS_PATH) as mhs_file:
+        num_hrs_msgs = hrs_file.size(q)
+        hrs_start = hrs_file.execute(q, 0, num_hrs_msgs // 2).get('latitude')
+        mhs_all = mhs_file.execute(q).get('latitude')
+        hrs_end = hrs_file.execute(q, num_hrs_msgs // 2).get('latitude')
+
+    assert np.allclose(hrs_lat, np.concatenate((hrs_start, hrs_end)))
+    assert np.allclose(mhs_lat, mhs_all)
+
+
+def test_message_filters():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    # NC021023 messages (data category 21, sub-category 23)
+    q_all = bufr.QuerySet()
+    q_all.add('latitude', '*/CLAT')
+    q_all.set_time_window(1900010100, 2100010100)
+    q_all.add_message_type(21, 23)
+
+    q_none = bufr.QuerySet()
+    q_none.add('latitude', '*/CLAT')
+    q_none.add_message_type(21, 24)
+
+    q_past = bufr.QuerySet()
+    q_past.add('latitude', '*/CLAT')
+    q_past.set_time_window(1900010100, 1900010123)
+
+    with bufr.File(DATA_PATH) as f:
+        lat = f.execute(q).get('latitude')
+        lat_filtered = f.execute(q_all).get('latitude')
+
+        assert f.size(q_all) == f.size(q)
+        assert f.size(q_none) == 0
+        assert f.size(q_past) == 0
+
+    assert np.allclose(lat, lat_filtered)
+
+
+def test_execute_chunks():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+
+    # The chunks put back together should give the same data as reading everything at once.
+    with bufr.File(DATA_PATH) as f:
+        num_msgs = f.size(q)
+        lat_all = f.execute(q).get('latitude')
+
+        chunk_msgs = num_msgs // 3 + 1
+        chunks = [r.get('latitude') for r in f.execute_chunks(q, chunkMsgs=chunk_msgs)]
+        byte_chunks = [r.get('latitude') for r in f.execute_chunks(q, 0, chunkBytes=100000)]
+
+    assert len(chunks) == (num_msgs + chunk_msgs - 1) // chunk_msgs
+    assert np.allclose(lat_all, np.concatenate(chunks))
+    assert len(byte_chunks) > 1
+    assert np.allclose(lat_all, np.concatenate(byte_chunks))
+
+
+def test_execute_chunks_other_files():
+    HRS_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+    MHS_PATH = 'testdata/gdas.t18z.1bmhs.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(HRS_PATH) as f:
+        lat_all = f.execute(q).get('latitude')
+        rad_all = f.execute(q).get('radiance')
+
+    # Opening and closing other files between the chunks rebuilds the NCEPLIB-bufr tables (the
+    # table node ids change), which mustn't throw off the chunks that follow.
+    lats = []
+    rads = []
+    with bufr.File(HRS_PATH) as f:
+        for r in f.execute_chunks(q, chunkMsgs=5):
+            lats.append(r.get('latitude'))
+            rads.append(r.get('radiance'))
+
+            with bufr.File(MHS_PATH) as other:
+                other.execute(q, 0, 1)
+
+    assert len(lats) > 1
+    assert np.allclose(lat_all, np.concatenate(lats))
+    assert np.allclose(rad_all, np.concatenate(rads))
+
+
+def test_get_ragged():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    lat = r.get('latitude')
+    rad = r.get('radiance')
+
+    lat_values, lat_offsets = r.get_ragged('latitude')
+    rad_values, rad_offsets = r.get_ragged('radiance')
+
+    # One value per subset needs no offsets.
+    assert len(lat_offsets) == 0
+    assert np.allclose(lat, lat_values)
+
+    # Every subset has the same number of channels, so nothing was padded.
+    assert len(rad_offsets) == 1
+    assert len(rad_offsets[0]) == rad.shape[0] + 1
+    assert rad_offsets[0][-1] == len(rad_values)
+    assert np.allclose(rad, rad_values.reshape(rad.shape))
+
+
+def test_filtered_query():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('radiance', '*/BRIT/TMBR')
+    q.add('filtered', '*/BRIT{1-5,10}/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    rad = r.get('radiance')
+    filtered = r.get('filtered')
+    filtered_values, filtered_offsets = r.get_ragged('filtered')
+
+    # The filtered repeats are the same as picking them out of the full result.
+    assert filtered.shape == (rad.shape[0], 6)
+    assert np.allclose(filtered, rad[:, [0, 1, 2, 3, 4, 9]])
+    assert len(filtered_offsets[0]) == rad.shape[0] + 1
+    assert np.allclose(filtered_values.reshape(filtered.shape), filtered)
+
+
+def test_value_predicate():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    q_pred = bufr.QuerySet()
+    q_pred.add('latitude', '*/CLAT[-30:30]')
+    q_pred.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    with bufr.File(DATA_PATH) as f:
+        r_pred = f.execute(q_pred)
+
+    lat = r.get('latitude')
+    keep = (lat >= -30) & (lat <= 30)
+
+    # Only the subsets that pass the predicate are collected (for every query).
+    assert 0 < np.count_nonzero(keep) < len(lat)
+    assert np.allclose(r_pred.get('latitude'), lat[keep])
+    assert np.allclose(r_pred.get('radiance'), r.get('radiance')[keep])
+
+
+def test_value_predicate_missing():
+    DATA_PATH = 'testdata/gdas.t06z.adpsfc.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('pressure', '*/PRES')
+    q.add('temperature', '*/TMDB')
+
+    # The range covers every real pressure, so only the missing ones fail it.
+    q_pred = bufr.QuerySet()
+    q_pred.add('pressure', '*/PRES[0:200000]')
+    q_pred.add('temperature', '*/TMDB')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    with bufr.File(DATA_PATH) as f:
+        r_pred = f.execute(q_pred)
+
+    pressure = r.get('pressure')
+    keep = ~np.ma.getmaskarray(pressure)
+
+    # Subsets with a missing value never pass a predicate.
+    assert 0 < np.count_nonzero(keep) < len(pressure)
+    assert np.ma.count_masked(r_pred.get('pressure')) == 0
+    assert np.ma.allclose(r_pred.get('pressure'), pressure[keep])
+    assert np.ma.allclose(r_pred.get('temperature'), r.get('temperature')[keep])
+
+
+def test_get_many():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('channel', '*/BRIT/CHNM')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+
+    fields = r.get_many(['latitude', 'radiance'])
+    assert np.allclose(fields['latitude'], r.get('latitude'))
+    assert np.allclose(fields['radiance'], r.get('radiance'))
+
+    grouped = r.get_many(['latitude', 'radiance'], group_by='channel')
+    assert np.allclose(grouped['latitude'], r.get('latitude', group_by='channel'))
+    assert np.allclose(grouped['radiance'], r.get('radiance', group_by='channel'))
+
+    threaded = r.get_many(['latitude', 'radiance'], group_by='channel', num_threads=4)
+    assert np.array_equal(threaded['latitude'], grouped['latitude'])
+    assert np.array_equal(threaded['radiance'], grouped['radiance'])
+
+
+def test_parse_threads():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+    YAML_PATH = 'testinput/bufrtest_hrs_basic_mapping.yaml'
+
+    container = bufr.Parser(DATA_PATH, YAML_PATH).parse()
+    threaded = bufr.Parser(DATA_PATH, YAML_PATH).parse(numThreads=4)
+
+    assert threaded.list() == container.list()
+    for name in container.list():
+        assert np.array_equal(threaded.get(name), container.get(name))
+
+
+def test_memory_stats():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    with bufr.File(DATA_PATH) as f:
+        stats = f.execute(q).memory_stats()
+        chunk_stats = [r.memory_stats() for r in f.execute_chunks(q, chunkMsgs=5)]
+
+    assert stats['num_subsets'] > 0
+    assert 0 < stats['used_bytes'] <= stats['reserved_bytes']
+    assert sum(s['num_subsets'] for s in chunk_stats) == stats['num_subsets']
+    assert all(s['used_bytes'] <= s['reserved_bytes'] for s in chunk_stats)
+
+
+def test_decode_stats():
+    # The subsets after the first one in each message have to be decoded natively, both for
+    # uncompressed (1bhrs4) and compressed (atms) messages.
+    paths = {'testdata/gdas.t00z.1bhrs4.tm00.bufr_d': ('*/CLAT', '*/CLON'),
+             'testdata/gdas.t00z.atms.tm00.bufr_d': ('*/CLATH', '*/CLONH')}
+
+    for path, (lat_query, lon_query) in paths.items():
+        q = bufr.QuerySet()
+        q.add('latitude', lat_query)
+        q.add('longitude', lon_query)
+
+        # The first execute runs without the message index, the second one with it.
+        with bufr.File(path) as f:
+            first_msgs = f.execute(q, 0, 5)
+            results = f.execute(q)
+
+        stats = results.decode_stats()
+        assert stats['native_messages'] > stats['fallback_messages']
+        assert first_msgs.decode_stats()['native_messages'] > 0
+
+
+def test_execute_workers():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    # Splitting the messages between worker processes shouldn't change the results.
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+        r_workers = f.execute(q, numWorkers=3)
+
+    assert np.allclose(r.get('latitude'), r_workers.get('latitude'))
+    assert np.allclose(r.get('radiance'), r_workers.get('radiance'))
+
+
+def test_subset_sampling():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    def make_query_set():
+        q = bufr.QuerySet()
+        q.add('latitude', '*/CLAT')
+        q.add('longitude', '*/CLON')
+        q.add('radiance', '*/BRIT/TMBR')
+        return q
+
+    q_stride = make_query_set()
+    q_stride.set_sample_stride(3)
+
+    q_random = make_query_set()
+    q_random.set_sample_fraction(0.25, seed=42)
+
+    q_thin = make_query_set()
+    q_thin.set_grid_thinning('latitude', 'longitude', 5.0)
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(make_query_set())
+        r_stride = f.execute(q_stride)
+        r_random = f.execute(q_random)
+        r_random_again = f.execute(q_random)
+        r_thin = f.execute(q_thin)
+
+    lat = r.get('latitude')
+    lon = r.get('longitude')
+
+    # Every third subset, counted over the whole file.
+    assert np.allclose(r_stride.get('latitude'), lat[::3])
+    assert np.allclose(r_stride.get('radiance'), r.get('radiance')[::3])
+
+    # The same seed gives the same sample.
+    assert 0 < len(r_random.get('latitude')) < len(lat)
+    assert np.allclose(r_random.get('latitude'), r_random_again.get('latitude'))
+
+    # One subset per cell, the first one in the file.
+    cells = np.floor((lat + 90) / 5) * 1000 + np.floor(np.mod(lon, 360) / 5)
+    _, first_idxs = np.unique(cells, return_index=True)
+    assert np.allclose(r_thin.get('latitude'), lat[np.sort(first_idxs)])
+
+
+def test_aggregate():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+
+    q = bufr.QuerySet()
+    q.add('latitude', '*/CLAT')
+    q.add('channel', '*/BRIT/CHNM')
+    q.add('radiance', '*/BRIT/TMBR')
+
+    specs = [bufr.AggregateSpec('latitude', bins=[-90, 0, 90]),
+             bufr.AggregateSpec('radiance', group_by='channel')]
+
+    with bufr.File(DATA_PATH) as f:
+        r = f.execute(q)
+        lat_stats, rad_stats = f.aggregate(q, specs)
+
+    lat = np.ma.masked_invalid(r.get('latitude')).compressed()
+    assert lat_stats['count'] == len(lat)
+    assert np.isclose(lat_stats['min'], lat.min())
+    assert np.isclose(lat_stats['max'], lat.max())
+    assert np.isclose(lat_stats['mean'], lat.mean())
+    assert lat_stats['histogram'] == list(np.histogram(lat, bins=[-90, 0, 90])[0])
+
+    channel = r.get('channel')
+    radiance = r.get('radiance')
+    assert len(rad_stats['groups']) == len(np.unique(channel.compressed()))
+    for chn, stats in rad_stats['groups'].items():
+        values = np.ma.masked_invalid(radiance[channel == chn]).compressed()
+        assert stats['count'] == len(values)
+        assert np.isclose(stats['mean'], values.mean())
+
+
 def test_highlevel_replace():
     DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
     YAML_PATH = 'testinput/bufrtest_hrs_basic_mapping.yaml'
@@ -278,6 +668,35 @@ def test_highlevel_cache():
     if bufr.DataCache.has(DATA_PATH, YAML_PATH):
         assert False, "Data Cache still contains entry."
 
+def test_ragged_encoder():
+    DATA_PATH = 'testdata/gdas.t00z.1bhrs4.tm00.bufr_d'
+    YAML_PATH = 'testinput/bufrtest_hrs_basic_mapping.yaml'
+    OUTPUT_PATH = 'testrun/bufrtest_python_test_ragged.nc'
+
+    container = bufr.Parser(DATA_PATH, YAML_PATH).parse()
+    data = container.get('variables/brightnessTemp')
+
+    description = bufr.encoders.Description(YAML_PATH)
+    description.remove_dimension('Channel')
+    description.add_dimension('Channel', ['*/BRIT', '*/BRITCSTC'], 'variables/channel',
+                              ragged=True)
+
+    dataset = next(iter(netcdf.Encoder(description).encode(container, OUTPUT_PATH).values()))
+    row_sizes = dataset['ChannelRowSize'][:]
+    obs_temp = dataset['ObsValue/brightnessTemperature'][:]
+    sample_dim = dataset['ChannelRowSize'].sample_dimension
+    dataset.close()
+
+    # Each row holds the channels of a location up to the last one with data.
+    assert sample_dim == 'Channel'
+    assert len(row_sizes) == data.shape[0]
+    assert np.sum(row_sizes) == len(obs_temp)
+
+    offsets = np.concatenate([[0], np.cumsum(row_sizes)])
+    for loc in range(0, data.shape[0], 97):
+        assert np.allclose(obs_temp[offsets[loc]:offsets[loc + 1]], data[loc, :row_sizes[loc]])
+
+
 def test_zarr_encoder():
     DATA_PATH = 'testdata/gdas.t18z.1bmhs.tm00.bufr_d'
     YAML_PATH = 'testinput/bufrtest_mhs_basic_mapping.yaml'
@@ -295,6 +714,22 @@ if __name__ == '__main__':
     test_long_str_field()
     test_type_override()
     test_invalid_query()
+    test_execute_offset()
+    test_multiple_open_files()
+    test_message_filters()
+    test_execute_chunks()
+    test_execute_chunks_other_files()
+    test_get_ragged()
+    test_filtered_query()
+    test_value_predicate()
+    test_value_predicate_missing()
+    test_get_many()
+    test_parse_threads()
+    test_memory_stats()
+    test_decode_stats()
+    test_execute_workers()
+    test_subset_sampling()
+    test_aggregate()
 
     # High level interface tests
     test_highlevel_replace()
@@ -304,5 +739,6 @@ if __name__ == '__main__':
     test_highlevel_append()
 
     # Test Encoders
+    test_ragged_encoder()
     test_zarr_encoder()
 
@@ -73,7 +73,8 @@ namespace mpi {
              const std::string& mappingFile,
              const std::string& outputFile,
              const std::string& tablePath = "",
-             std::size_t numMsgs = 0)
+             std::size_t numMsgs = 0,
+             std::size_t numWorkers = 1)
   {
     auto startTime = std::chrono::steady_clock::now();
 
@@ -83,7 +84,8 @@ namespace mpi {
     if (yaml->has("encoder"))
     {
       auto data = BufrParser(obsFile,
-                             yaml->getSubConfiguration("bufr"), tablePath).parse(numMsgs);
+                             yaml->getSubConfiguration("bufr"), tablePath).parse(numMsgs,
+                                                                                 numWorkers);
 
       auto backend = encoders::netcdf::Encoder::Backend(false, outputFile);
 
@@ -152,13 +154,14 @@ namespace mpi {
 
 static void showHelp()
 {
-    std::cerr << "Usage: bufr2netcdf.x [-t TABLE_PATH] [-n NUM_MESSAGES] SRC_FILE MAPPING_FILE"
-              << " OUT_FILE\n"
+    std::cerr << "Usage: bufr2netcdf.x [-t TABLE_PATH] [-n NUM_MESSAGES] [-w NUM_WORKERS] SRC_FILE"
+              << " MAPPING_FILE OUT_FILE\n"
               << "Options:\n"
               << "  -h,  Show this help message\n"
               << "  --no-gather, Don't gather the data into 1 output file. Makes 1 file per task.\n"
               << "  -t TABLE_PATH,  Path to BUFR table files (use with WMO BUFR files)\n"
               << "  -n NUM_MESSAGES,  Number of BUFR messages to parse.\n"
+              << "  -w NUM_WORKERS,  Number of processes to decode with (without MPI).\n"
               << "Example:\n"
               << "  bufr2netcdf.x input/mhs.bufr input/mhs_mapping.yaml output/mhs.nc\n"
               << std::endl;
@@ -178,6 +181,7 @@ int main(int argc, char **argv)
     std::string outputFile;
     std::string tablePath = "";
     std::size_t numMsgs = 0;
+    std::size_t numWorkers = 1;
 
     enum class ReqArgType
     {
@@ -202,6 +206,18 @@ int main(int argc, char **argv)
                 return 0;
             }
 
+            argIdx += 2;
+        } else if (strcmp(argv[argIdx], "-w") == 0)
+        {
+            if (static_cast<std::size_t> (argc) > argIdx + 1)
+            {
+                numWorkers = atoi(argv[argIdx + 1]);
+            } else
+            {
+                showHelp();
+                return 0;
+            }
+
             argIdx += 2;
         } else if (strcmp(argv[argIdx], "-h") == 0)
         {
@@ -257,7 +273,7 @@ int main(int argc, char **argv)
     }
     else
     {
-      bufr::parse(obsFile, mappingFile, outputFile, tablePath, numMsgs);
+      bufr::parse(obsFile, mappingFile, outputFile, tablePath, numMsgs, numWorkers);
     }
 
     return 0;
@@ -0,0 +1,219 @@
+// (C) Copyright 2024 NOAA/NWS/NCEP/EMC
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/runtime/Main.h"
+
+#include "bufr/File.h"
+#include "bufr/MessageIndex.h"
+#include "bufr/MessageIndexCache.h"
+
+
+namespace bufr {
+namespace index {
+  class App : public eckit::Main
+  {
+  public:
+    App() = delete;
+    App(int argc, char **argv) : eckit::Main(argc, argv)
+    {
+      name_ = "bufr_index";
+    }
+  };
+
+  bool isDirectory(const std::string& path)
+  {
+    struct stat pathStat;
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+  }
+
+  /// \brief Get the paths of the regular files in a directory (not recursive). Existing index
+  ///        files are skipped.
+  std::vector<std::string> listFiles(const std::string& dirPath)
+  {
+    std::vector<std::string> files;
+
+    DIR* dir = opendir(dirPath.c_str());
+    if (dir == nullptr)
+    {
+      std::cerr << "Could not open the directory " << dirPath << std::endl;
+      return files;
+    }
+
+    const std::string indexExt = ".bufridx";
+    while (auto entry = readdir(dir))
+    {
+      const auto name = std::string(entry->d_name);
+      const auto path = dirPath + "/" + name;
+
+      if (name == "." || name == ".." || isDirectory(path)) continue;
+      if (name.size() > indexExt.size() &&
+          name.compare(name.size() - indexExt.size(), indexExt.size(), indexExt) == 0)
+      {
+        continue;
+      }
+
+      files.push_back(path);
+    }
+
+    closedir(dir);
+
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  /// \brief Check that NCEPLIB-bufr can be given the file (it has BUFR messages).
+  bool isBufrFile(const std::string& filePath)
+  {
+    if (MessageIndex(filePath).empty())
+    {
+      std::cout << "Skipping " << filePath << " (no BUFR messages)" << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+  /// \brief Make sure there is an up to date index for the file.
+  /// \return True if the index file was written.
+  bool indexFile(const std::string& filePath, const std::string& tablePath)
+  {
+    auto startTime = std::chrono::steady_clock::now();
+
+    auto file = File(filePath, tablePath);
+    auto index = file.index();
+    file.close();
+
+    // The index may have come from an older index file, so write it out ourselves to know it
+    // is there.
+    const auto providerType = tablePath.empty() ? "NCEP" : "WMO";
+    if (!MessageIndexCache::save(*index, providerType, tablePath))
+    {
+      std::cerr << "Could not write the index file " << MessageIndexCache::pathFor(filePath)
+                << " for " << filePath << std::endl;
+      return false;
+    }
+
+    auto timeElapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+        (std::chrono::steady_clock::now() - startTime);
+
+    std::cout << "Indexed " << filePath << " (" << index->size() << " messages) -> "
+              << MessageIndexCache::pathFor(filePath)
+              << " [" << timeElapsed.count() / 1000.0 << "s]" << std::endl;
+
+    return true;
+  }
+}  // namespace index
+}  // namespace bufr
+
+
+static void showHelp()
+{
+    std::cerr << "Usage: bufr_index.x [-t TABLE_PATH] [-d CACHE_DIR] [--hash] PATH [PATH ...]\n"
+              << "Builds the message index for BUFR files so later runs don't need to scan them.\n"
+              << "PATH can be a BUFR file or a directory of BUFR files.\n"
+              << "Options:\n"
+              << "  -h,  Show this help message\n"
+              << "  -t TABLE_PATH,  Path to BUFR table files (use with WMO BUFR files)\n"
+              << "  -d CACHE_DIR,  Directory to store the indexes in (default is next to the file,\n"
+              << "                 use the same BUFR_INDEX_CACHE_DIR when reading the files).\n"
+              << "  --hash,  Record the content hash of each file.\n"
+              << "Example:\n"
+              << "  bufr_index.x -d /data/bufr_index /data/incoming\n"
+              << std::endl;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        showHelp();
+        return 0;
+    }
+
+    std::string tablePath = "";
+    std::vector<std::string> paths;
+
+    std::size_t argIdx = 1;
+    while (argIdx < static_cast<std::size_t> (argc))
+    {
+        if (strcmp(argv[argIdx], "-h") == 0)
+        {
+            showHelp();
+            return 0;
+        } else if (strcmp(argv[argIdx], "-t") == 0 || strcmp(argv[argIdx], "-d") == 0)
+        {
+            if (static_cast<std::size_t> (argc) <= argIdx + 1)
+            {
+                showHelp();
+                return 0;
+            }
+
+            if (strcmp(argv[argIdx], "-t") == 0)
+            {
+                tablePath = std::string(argv[argIdx + 1]);
+            } else
+            {
+                bufr::MessageIndexCache::setDirectory(std::string(argv[argIdx + 1]));
+            }
+
+            argIdx += 2;
+        } else if (strcmp(argv[argIdx], "--hash") == 0)
+        {
+            bufr::MessageIndexCache::setUseHash(true);
+            argIdx += 1;
+        } else
+        {
+            paths.push_back(std::string(argv[argIdx]));
+            argIdx++;
+        }
+    }
+
+    auto app = bufr::index::App(argc, argv);
+    bufr::MessageIndexCache::setEnabled(true);
+    bufr::MessageIndexCache::setWritable(true);
+
+    size_t numIndexed = 0;
+    size_t numFailed = 0;
+    for (const auto& path : paths)
+    {
+        auto files = bufr::index::isDirectory(path) ?
+                     bufr::index::listFiles(path) : std::vector<std::string>{path};
+
+        for (const auto& filePath : files)
+        {
+            try
+            {
+                // Don't hand files that aren't BUFR to NCEPLIB-bufr.
+                if (!bufr::index::isBufrFile(filePath)) continue;
+
+                if (bufr::index::indexFile(filePath, tablePath))
+                {
+                    numIndexed++;
+                } else
+                {
+                    numFailed++;
+                }
+            }
+            catch (const eckit::Exception& e)
+            {
+                std::cerr << "Failed to index " << filePath << ": " << e.what() << std::endl;
+                numFailed++;
+            }
+        }
+    }
+
+    std::cout << "Indexed " << numIndexed << " files." << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}